@@ -0,0 +1,326 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef ASSETARCHIVE_H
+#define ASSETARCHIVE_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Binary file layout, data is 16 byte aligned
+//  Header | file data | directory (sorted by path hash) | path strings
+struct AssetArchiveHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t padding;
+    std::uint64_t directoryOffset;
+    std::uint64_t stringsOffset;
+    std::int64_t buildTime;
+};
+
+struct AssetArchiveEntry {
+    std::uint64_t pathHash;
+    std::uint64_t offset;
+    std::uint64_t size; // Also the size of the source file at build time
+    std::int64_t sourceWriteTime;
+    std::uint32_t pathOffset; // Relative to the strings section
+    std::uint32_t pathLength;
+};
+
+struct AssetView {
+    const std::byte *data;
+    std::size_t size;
+};
+
+// All assets and shader sources packed into a single file that gets mapped once at startup
+// Paths are stored exactly like the loaders request them ("../assets/..", "../src/Shaders/..")
+// If there is no archive or a file is missing in it, loaders fall back to the file system
+// A loose file that differs in size or write time from its packed copy wins, so edits aren't shadowed by a stale pack
+// That check runs once per entry, the first time it is looked up
+class AssetArchive {
+public:
+    static constexpr char MAGIC[4] = {'R', 'C', 'G', 'A'};
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t ALIGNMENT = 16;
+    static constexpr const char *DEFAULT_PATH = "../assets.pack";
+
+    static AssetArchive &instance() {
+        static AssetArchive archive{DEFAULT_PATH};
+        return archive;
+    }
+
+    explicit AssetArchive(const std::string &path) : m_file(path) {
+        if (!m_file.isOpen() || m_file.size() < sizeof(AssetArchiveHeader)) {
+            return;
+        }
+
+        if (!isValid(m_file)) {
+            std::cerr << "Invalid asset archive: " << path << std::endl;
+            return;
+        }
+
+        m_shadowStates = std::vector<std::atomic<std::uint8_t> >(getHeader().entryCount);
+        m_valid = true;
+        m_file.prefetch();
+    }
+
+    [[nodiscard]] bool isValid() const {
+        return m_valid;
+    }
+
+    [[nodiscard]] std::int64_t getBuildTime() const {
+        return m_valid ? getHeader().buildTime : 0;
+    }
+
+    [[nodiscard]] std::optional<AssetView> find(std::string_view path) const {
+        if (!m_valid) {
+            return std::nullopt;
+        }
+
+        const std::string normalized = normalizePath(path);
+        const std::uint64_t hash = hashPath(normalized);
+
+        const AssetArchiveHeader &header = getHeader();
+        const auto *begin = reinterpret_cast<const AssetArchiveEntry *>(m_file.data() + header.directoryOffset);
+        const auto *end = begin + header.entryCount;
+        const char *strings = reinterpret_cast<const char *>(m_file.data() + header.stringsOffset);
+
+        auto it = std::lower_bound(begin, end, hash, [](const AssetArchiveEntry &entry, std::uint64_t value) {
+            return entry.pathHash < value;
+        });
+
+        // Compare the paths in case of hash collisions
+        for (; it != end && it->pathHash == hash; ++it) {
+            if (std::string_view{strings + it->pathOffset, it->pathLength} == normalized) {
+                if (isShadowedByLooseFile(normalized, *it, m_shadowStates[it - begin])) {
+                    return std::nullopt;
+                }
+
+                return AssetView{m_file.data() + it->offset, it->size};
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // Reads from the archive if the file is packed, otherwise from disk
+    static std::optional<std::string> readText(std::string_view path) {
+        if (std::optional<AssetView> view = instance().find(path)) {
+            return std::string{reinterpret_cast<const char *>(view->data), view->size};
+        }
+
+        std::ifstream file{std::string{path}, std::ios::binary};
+
+        if (!file) {
+            return std::nullopt;
+        }
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    static std::string normalizePath(std::string_view path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    static std::uint64_t hashPath(std::string_view path) {
+        // FNV-1a
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+
+        for (const char c: path) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    // Packs every regular file below the given roots, paths are stored as "root/relative/path"
+    static bool build(const std::vector<std::string> &roots, const std::vector<std::string> &excludedRoots,
+                      const std::string &outPath) {
+        std::vector<std::string> paths;
+
+        for (const std::string &root: roots) {
+            std::error_code error;
+
+            for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+                 it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                if (error) {
+                    break;
+                }
+
+                const std::string path = normalizePath(it->path().string());
+                const bool excluded = std::any_of(excludedRoots.begin(), excludedRoots.end(),
+                                                  [&path](const std::string &excludedRoot) {
+                                                      return path.rfind(normalizePath(excludedRoot), 0) == 0;
+                                                  });
+
+                if (it->is_regular_file() && !excluded) {
+                    paths.push_back(path);
+                }
+            }
+        }
+
+        // Files of the same directory end up next to each other
+        std::sort(paths.begin(), paths.end());
+
+        std::ofstream out(outPath + ".tmp", std::ios::binary | std::ios::trunc);
+
+        if (!out) {
+            std::cerr << "Unable to write asset archive: " << outPath << std::endl;
+            return false;
+        }
+
+        AssetArchiveHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.entryCount = static_cast<std::uint32_t>(paths.size());
+        header.buildTime = std::chrono::system_clock::now().time_since_epoch().count();
+        writeAligned(out, &header, sizeof(header));
+
+        std::vector<AssetArchiveEntry> directory;
+        std::string strings;
+
+        for (const std::string &path: paths) {
+            std::ifstream file{path, std::ios::binary};
+            const std::vector<char> content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+            AssetArchiveEntry entry{};
+            entry.pathHash = hashPath(path);
+            entry.size = content.size();
+            entry.sourceWriteTime = getWriteTime(path).value_or(0);
+            entry.offset = writeAligned(out, content.data(), content.size());
+            entry.pathOffset = static_cast<std::uint32_t>(strings.size());
+            entry.pathLength = static_cast<std::uint32_t>(path.size());
+
+            strings += path;
+            directory.push_back(entry);
+        }
+
+        std::sort(directory.begin(), directory.end(), [](const AssetArchiveEntry &a, const AssetArchiveEntry &b) {
+            return a.pathHash < b.pathHash;
+        });
+
+        header.directoryOffset = writeAligned(out, directory.data(), directory.size() * sizeof(AssetArchiveEntry));
+        header.stringsOffset = writeAligned(out, strings.data(), strings.size());
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.close();
+
+        if (!out) {
+            std::cerr << "Unable to write asset archive: " << outPath << std::endl;
+            return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(outPath + ".tmp", outPath, error);
+        return !error;
+    }
+
+private:
+    // Loose file check result per entry, lookups can come from several loader threads
+    enum ShadowState : std::uint8_t {
+        UNCHECKED = 0,
+        PACKED,
+        SHADOWED
+    };
+
+    MappedFile m_file;
+    bool m_valid{false};
+    mutable std::vector<std::atomic<std::uint8_t> > m_shadowStates;
+
+    static bool isInFile(const MappedFile &file, std::uint64_t offset, std::uint64_t size) {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    // Every range find() reads through has to lie inside the mapping
+    static bool isValid(const MappedFile &file) {
+        const auto &header = *reinterpret_cast<const AssetArchiveHeader *>(file.data());
+
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.entryCount > file.size() / sizeof(AssetArchiveEntry) ||
+            !isInFile(file, header.directoryOffset, header.entryCount * sizeof(AssetArchiveEntry)) ||
+            header.directoryOffset % alignof(AssetArchiveEntry) != 0 || header.stringsOffset > file.size()) {
+            return false;
+        }
+
+        const auto *entries = reinterpret_cast<const AssetArchiveEntry *>(file.data() + header.directoryOffset);
+        const std::uint64_t stringsSize = file.size() - header.stringsOffset;
+
+        for (std::uint32_t i = 0; i < header.entryCount; i++) {
+            const AssetArchiveEntry &entry = entries[i];
+
+            if (!isInFile(file, entry.offset, entry.size) || entry.pathOffset > stringsSize ||
+                entry.pathLength > stringsSize - entry.pathOffset) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] const AssetArchiveHeader &getHeader() const {
+        return *reinterpret_cast<const AssetArchiveHeader *>(m_file.data());
+    }
+
+    static std::optional<std::int64_t> getWriteTime(const std::string &path) {
+        std::error_code error;
+        const auto writeTime = std::filesystem::last_write_time(path, error);
+
+        if (error) {
+            return std::nullopt;
+        }
+
+        return writeTime.time_since_epoch().count();
+    }
+
+    // A missing loose file is the shipped case, the packed copy is used
+    static bool isShadowedByLooseFile(const std::string &path, const AssetArchiveEntry &entry,
+                                      std::atomic<std::uint8_t> &state) {
+        const std::uint8_t checked = state.load(std::memory_order_relaxed);
+        if (checked != UNCHECKED) {
+            return checked == SHADOWED;
+        }
+
+        bool shadowed = false;
+        if (const std::optional<std::int64_t> writeTime = getWriteTime(path)) {
+            std::error_code error;
+            const std::uintmax_t size = std::filesystem::file_size(path, error);
+            shadowed = error || size != entry.size || *writeTime != entry.sourceWriteTime;
+        }
+
+        // Concurrent first lookups come to the same result
+        state.store(shadowed ? SHADOWED : PACKED, std::memory_order_relaxed);
+        return shadowed;
+    }
+
+    // Returns the offset the data got written to
+    static std::uint64_t writeAligned(std::ofstream &out, const void *data, std::size_t size) {
+        static const char zeros[ALIGNMENT] = {};
+
+        const std::uint64_t position = out.tellp();
+        const std::uint64_t padding = (ALIGNMENT - position % ALIGNMENT) % ALIGNMENT;
+        out.write(zeros, static_cast<std::streamsize>(padding));
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+
+        return position + padding;
+    }
+};
+
+
+#endif //ASSETARCHIVE_H
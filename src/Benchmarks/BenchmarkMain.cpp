@@ -0,0 +1,47 @@
+//
+// Created by slice on 10/19/26.
+//
+
+// CPU side benchmarks, no OpenGL context is created
+// Usage: realtime_cg_benchmarks [name], runs all benchmarks if no name is given
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "GltfLoadBenchmark.h"
+#include "InterleaveBenchmark.h"
+#include "MeshOptimizerBenchmark.h"
+#include "MeshSimplifierBenchmark.h"
+#include "TerrainRaycastBenchmark.h"
+#include "WaterLODBenchmark.h"
+
+int main(int argc, char **argv) {
+    const std::vector<std::pair<std::string, std::function<void()> > > benchmarks = {
+        {"water_lod", benchmarks::runWaterLODBenchmark},
+        {"gltf_load", benchmarks::runGltfLoadBenchmark},
+        {"mesh_optimizer", benchmarks::runMeshOptimizerBenchmark},
+        {"mesh_simplifier", benchmarks::runMeshSimplifierBenchmark},
+        {"interleave", benchmarks::runInterleaveBenchmark},
+        {"terrain_raycast", benchmarks::runTerrainRaycastBenchmark},
+    };
+
+    const char *selected = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+
+    for (const auto &[name, run]: benchmarks) {
+        if (!selected || std::strcmp(selected, name.c_str()) == 0) {
+            run();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        std::cerr << "Unknown benchmark: " << selected << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef GLTFLOADBENCHMARK_H
+#define GLTFLOADBENCHMARK_H
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../GltfLoader.h"
+
+namespace benchmarks {
+    inline long getPeakRssKb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss; // KB on Linux
+    }
+
+    inline long getCurrentRssKb() {
+        long pages = 0;
+        long residentPages = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> residentPages;
+        return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    // Load time and memory of GltfLoader::loadModel, primitives reference the scene owned buffers
+    // Peak RSS is only meaningful for the first load, run this benchmark on its own: realtime_cg_benchmarks gltf_load
+    inline void runGltfLoadBenchmark() {
+        const std::string path = "../assets/models/DamagedHelmet.glb";
+
+        const int runs = 5;
+        const long rssBefore = getCurrentRssKb();
+        const long peakBefore = getPeakRssKb();
+
+        GltfLoader loader;
+        std::size_t vertexBytes = 0;
+        std::size_t indexBytes = 0;
+        std::size_t bufferBytes = 0;
+        std::size_t imageBytes = 0;
+        long rssLoaded = 0;
+        double totalMs = 0.0;
+
+        for (int i = 0; i < runs; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            GltfScene scene = loader.loadModel(path);
+            const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+            totalMs += loadTime.count();
+
+            if (i == 0) {
+                rssLoaded = getCurrentRssKb();
+
+                for (const std::vector<unsigned char> &buffer: scene.buffers) {
+                    bufferBytes += buffer.size();
+                }
+
+                for (const GltfImage &image: scene.images) {
+                    imageBytes += image.buffer.size();
+                }
+
+                for (const GltfObject &object: scene.objects) {
+                    for (const GltfMesh &mesh: object.meshes) {
+                        for (const GltfPrimitive &primitive: mesh.primitives) {
+                            for (const auto &[type, attrib]: primitive.attributes) {
+                                vertexBytes += attrib.bufferSize;
+                            }
+                            indexBytes += primitive.indexBufferSize;
+                        }
+                    }
+                }
+            }
+        }
+
+        const long peakAfter = getPeakRssKb();
+
+        std::printf("== glTF load (%s) ==\n", path.c_str());
+        std::printf("Average load time:            %8.2f ms (%d runs)\n", totalMs / runs, runs);
+        std::printf("Scene buffers:                %8.2f MB\n", bufferBytes / (1024.0 * 1024.0));
+        std::printf("Decoded images:               %8.2f MB\n", imageBytes / (1024.0 * 1024.0));
+        std::printf("Per attribute copies avoided: %8.2f MB (vertex %.2f MB, index %.2f MB)\n",
+                    (vertexBytes + indexBytes) / (1024.0 * 1024.0),
+                    vertexBytes / (1024.0 * 1024.0), indexBytes / (1024.0 * 1024.0));
+        std::printf("RSS while loaded:             %8.2f MB (+%.2f MB)\n",
+                    rssLoaded / 1024.0, (rssLoaded - rssBefore) / 1024.0);
+        std::printf("RSS after release:            %8.2f MB\n", getCurrentRssKb() / 1024.0);
+        std::printf("Peak RSS growth:              %8.2f MB\n\n", (peakAfter - peakBefore) / 1024.0);
+    }
+}
+
+#endif //GLTFLOADBENCHMARK_H
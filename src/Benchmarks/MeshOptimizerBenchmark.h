@@ -0,0 +1,133 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef MESHOPTIMIZERBENCHMARK_H
+#define MESHOPTIMIZERBENCHMARK_H
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../GltfLoader.h"
+#include "../MeshOptimizer.h"
+#include "../Final/TerrainPatchLODGenerator.h"
+
+namespace benchmarks {
+    struct MeshOptimizerRow {
+        std::vector<std::uint32_t> original;
+        std::vector<std::uint32_t> vertexCache;
+        std::vector<std::uint32_t> overdraw; // Empty if the pass does not apply
+        std::uint32_t vertexCount;
+    };
+
+    inline void printMeshOptimizerRow(const std::string &name, const MeshOptimizerRow &row) {
+        for (const std::uint32_t cacheSize: {16u, 32u}) {
+            const VertexCacheStats original = MeshOptimizer::analyzeVertexCache(row.original, row.vertexCount, cacheSize);
+            const VertexCacheStats optimized = MeshOptimizer::analyzeVertexCache(row.vertexCache, row.vertexCount, cacheSize);
+
+            std::printf("%-28s %4u %8zu   %5.3f / %5.3f   %5.3f / %5.3f",
+                        name.c_str(), cacheSize, row.original.size() / 3,
+                        original.acmr, original.atvr, optimized.acmr, optimized.atvr);
+
+            if (!row.overdraw.empty()) {
+                const VertexCacheStats overdraw = MeshOptimizer::analyzeVertexCache(row.overdraw, row.vertexCount, cacheSize);
+                std::printf("   %5.3f / %5.3f", overdraw.acmr, overdraw.atvr);
+            }
+
+            std::printf("\n");
+        }
+    }
+
+    // ACMR (transformed vertices per triangle) and ATVR (transformed per unique vertex) of the
+    // import order against the optimized order, FIFO cache with 16 and 32 entries
+    inline void runMeshOptimizerBenchmark() {
+        std::printf("== Mesh optimizer (ACMR / ATVR) ==\n");
+        std::printf("%-28s %4s %8s   %-13s   %-13s   %-13s\n", "Mesh", "FIFO", "Tris", "Original", "Vertex cache",
+                    "+ Overdraw");
+
+        // glTF models
+        const std::vector<std::string> models = {
+            "../assets/models/DamagedHelmet.glb",
+            "../assets/models/terrain/LOW_POLY_TREE.glb",
+            "../assets/models/terrain/grass.glb",
+            "../assets/models/tv.glb"
+        };
+
+        GltfLoader loader;
+        double optimizeMs = 0.0;
+        std::size_t optimizedTriangles = 0;
+
+        for (const std::string &path: models) {
+            GltfScene scene = loader.loadModel(path);
+            int primitiveIdx = 0;
+
+            for (const GltfObject &object: scene.objects) {
+                for (const GltfMesh &mesh: object.meshes) {
+                    for (const GltfPrimitive &primitive: mesh.primitives) {
+                        MeshOptimizerRow row;
+                        row.original = VertexInterleaver::readIndices(primitive);
+                        row.vertexCount = static_cast<std::uint32_t>(primitive.get(GltfAttribute::POSITION).elemCount);
+
+                        if (row.original.empty()) {
+                            continue;
+                        }
+
+                        std::vector<glm::vec3> positions(row.vertexCount);
+                        for (std::size_t i = 0; i < positions.size(); i++) {
+                            float position[4] = {};
+                            VertexInterleaver::readElement(primitive.get(GltfAttribute::POSITION), i, position);
+                            positions[i] = {position[0], position[1], position[2]};
+                        }
+
+                        const auto start = std::chrono::steady_clock::now();
+                        std::vector<std::uint32_t> clusters;
+                        row.vertexCache = MeshOptimizer::optimizeVertexCache(row.original, row.vertexCount,
+                                                                             MeshOptimizer::CACHE_SIZE, &clusters);
+                        row.overdraw = MeshOptimizer::optimizeOverdraw(row.vertexCache, positions, clusters);
+                        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+                        optimizeMs += time.count();
+                        optimizedTriangles += row.original.size() / 3;
+
+                        const std::string name = std::filesystem::path(path).stem().string() + "#" +
+                                                 std::to_string(primitiveIdx++);
+                        printMeshOptimizerRow(name, row);
+                    }
+                }
+            }
+        }
+
+        // Terrain patches as generated by TerrainManager, 256 chunk size
+        for (int lod = 0; lod < 4; lod++) {
+            for (const STITCHED_EDGE edge: {STITCHED_EDGE::NONE, STITCHED_EDGE::TOP, STITCHED_EDGE::LEFT}) {
+                TerrainPatch patch = TerrainPatchLODGenerator::generateBasePatch(256, lod);
+
+                if (edge != STITCHED_EDGE::NONE) {
+                    TerrainPatchLODGenerator::stitchPatchEdge(patch, edge);
+                }
+
+                MeshOptimizerRow row;
+                row.original = TerrainPatchLODGenerator::triangulatePatch(patch);
+                row.vertexCount = static_cast<std::uint32_t>(TerrainPatchLODGenerator::generateVertexBuffer(patch).size() / 2);
+
+                const auto start = std::chrono::steady_clock::now();
+                row.vertexCache = MeshOptimizer::optimizeVertexCache(row.original, row.vertexCount);
+                const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+                optimizeMs += time.count();
+                optimizedTriangles += row.original.size() / 3;
+
+                const char *edgeNames[] = {"", " top", " left"};
+                const int edgeIdx = edge == STITCHED_EDGE::NONE ? 0 : (edge == STITCHED_EDGE::TOP ? 1 : 2);
+                printMeshOptimizerRow("terrain lod " + std::to_string(lod) + edgeNames[edgeIdx], row);
+            }
+        }
+
+        std::printf("Optimization time: %.2f ms for %zu triangles (%.1f M triangles/s)\n\n",
+                    optimizeMs, optimizedTriangles, optimizedTriangles / (optimizeMs * 1000.0));
+    }
+}
+
+#endif //MESHOPTIMIZERBENCHMARK_H
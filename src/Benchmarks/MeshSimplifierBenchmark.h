@@ -0,0 +1,88 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef MESHSIMPLIFIERBENCHMARK_H
+#define MESHSIMPLIFIERBENCHMARK_H
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../GltfLoader.h"
+#include "../MeshSimplifier.h"
+#include "../VertexInterleaver.h"
+
+namespace benchmarks {
+    // Triangle count and error of every LOD, error relative to the mesh bounds as well
+    inline void runMeshSimplifierBenchmark() {
+        std::printf("== Mesh simplifier (LOD chain) ==\n");
+        std::printf("%-28s %3s %8s %7s %12s %9s\n", "Mesh", "LOD", "Tris", "Ratio", "Error", "Error (%)");
+
+        const std::vector<std::string> models = {
+            "../assets/models/DamagedHelmet.glb",
+            "../assets/models/terrain/LOW_POLY_TREE.glb",
+            "../assets/models/terrain/grass.glb",
+            "../assets/models/tv.glb"
+        };
+
+        GltfLoader loader;
+        double simplifyMs = 0.0;
+        std::size_t inputTriangles = 0;
+
+        for (const std::string &path: models) {
+            GltfScene scene = loader.loadModel(path);
+            int primitiveIdx = 0;
+
+            for (const GltfObject &object: scene.objects) {
+                for (const GltfMesh &mesh: object.meshes) {
+                    for (const GltfPrimitive &primitive: mesh.primitives) {
+                        const std::vector<std::uint32_t> indices = VertexInterleaver::readIndices(primitive);
+
+                        if (indices.empty()) {
+                            continue;
+                        }
+
+                        const GltfVertexAttrib &positionAttrib = primitive.get(GltfAttribute::POSITION);
+                        std::vector<glm::vec3> positions(positionAttrib.elemCount);
+                        glm::vec3 min{std::numeric_limits<float>::max()};
+                        glm::vec3 max{-std::numeric_limits<float>::max()};
+
+                        for (std::size_t i = 0; i < positions.size(); i++) {
+                            float position[4] = {};
+                            VertexInterleaver::readElement(positionAttrib, i, position);
+                            positions[i] = {position[0], position[1], position[2]};
+                            min = glm::min(min, positions[i]);
+                            max = glm::max(max, positions[i]);
+                        }
+
+                        const float extent = glm::length(max - min);
+
+                        const auto start = std::chrono::steady_clock::now();
+                        const std::vector<MeshLod> lods = MeshSimplifier::generateLodChain(indices, positions);
+                        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+                        simplifyMs += time.count();
+                        inputTriangles += indices.size() / 3;
+
+                        const std::string name = std::filesystem::path(path).stem().string() + "#" +
+                                                 std::to_string(primitiveIdx++);
+
+                        for (std::size_t lod = 0; lod < lods.size(); lod++) {
+                            std::printf("%-28s %3zu %8zu %7.3f %12.6f %9.3f\n", name.c_str(), lod,
+                                        lods[lod].indices.size() / 3,
+                                        static_cast<double>(lods[lod].indices.size()) / indices.size(),
+                                        lods[lod].error, extent > 0.0f ? lods[lod].error / extent * 100.0f : 0.0f);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::printf("Simplification time: %.2f ms for %zu triangles\n\n", simplifyMs, inputTriangles);
+    }
+}
+
+#endif //MESHSIMPLIFIERBENCHMARK_H
@@ -0,0 +1,107 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINRAYCASTBENCHMARK_H
+#define TERRAINRAYCASTBENCHMARK_H
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../Final/TerrainRaycaster.h"
+
+namespace benchmarks {
+    // Fixed step march over TerrainNoise::getHeight, what picking had to do without the raycaster
+    inline TerrainRayHit raycastFixedStep(const TerrainNoiseParams &params, const TerrainRay &ray, const float step) {
+        const glm::vec3 direction = glm::normalize(ray.direction);
+
+        for (float t = 0.0f; t <= ray.maxDistance; t += step) {
+            const glm::vec3 pos = ray.origin + direction * t;
+
+            if (pos.y <= TerrainNoise::getHeight(params, glm::vec2{pos.x, pos.z})) {
+                return {true, t, pos};
+            }
+        }
+
+        return {false, ray.maxDistance, glm::vec3{0.0f}};
+    }
+
+    // Default terrain parameters, 5x5 tiles of 256 like the chunk grid, bounds sampled every 4 units
+    // Rays start at camera heights and look slightly down, like picking and line of sight checks
+    inline void runTerrainRaycastBenchmark() {
+        constexpr int RAY_COUNT = 4096;
+        constexpr int TILES_PER_AXIS = 5;
+        constexpr float TILE_SIZE = 256.0f;
+        constexpr float FIXED_STEP = 0.5f;
+
+        const TerrainNoiseParams params = {30.0f, 4, 300.0f, 0.244f, 10.0f};
+        const glm::vec2 gridOrigin = glm::vec2{-TILE_SIZE * TILES_PER_AXIS * 0.5f};
+
+        std::printf("== Terrain raycast (%d rays) ==\n", RAY_COUNT);
+
+        const auto buildStart = std::chrono::steady_clock::now();
+        std::vector<TerrainRaycastTile> tiles;
+        for (int z = 0; z < TILES_PER_AXIS; z++) {
+            for (int x = 0; x < TILES_PER_AXIS; x++) {
+                const glm::vec2 tileOrigin = gridOrigin + glm::vec2(x, z) * TILE_SIZE;
+                tiles.push_back(TerrainRaycaster::buildTile(params, tileOrigin, TILE_SIZE, 64));
+            }
+        }
+        const double buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - buildStart).count();
+
+        TerrainRaycaster raycaster;
+        raycaster.setTiles(params, nullptr, gridOrigin, TILE_SIZE, TILES_PER_AXIS, std::move(tiles));
+
+        std::mt19937 random{42};
+        std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+        std::vector<TerrainRay> rays(RAY_COUNT);
+        for (TerrainRay &ray: rays) {
+            ray.origin = {unit(random) * 500.0f, 25.0f + unit(random) * 10.0f, unit(random) * 500.0f};
+            ray.direction = {unit(random), unit(random) * 0.3f - 0.1f, unit(random)};
+            ray.maxDistance = 500.0f;
+        }
+
+        auto measure = [](auto &&castAll) {
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<TerrainRayHit> hits = castAll();
+            const double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            return std::make_pair(ms, std::move(hits));
+        };
+
+        const auto [fixedMs, fixedHits] = measure([&] {
+            std::vector<TerrainRayHit> hits;
+            for (const TerrainRay &ray: rays) {
+                hits.push_back(raycastFixedStep(params, ray, FIXED_STEP));
+            }
+            return hits;
+        });
+        const auto [singleMs, singleHits] = measure([&] { return raycaster.raycast(rays, false); });
+        const auto [batchMs, batchHits] = measure([&] { return raycaster.raycast(rays, true); });
+
+        // The fixed step can only be off by one step, anything more is a wrong hit
+        int hitCount = 0;
+        int disagreements = 0;
+        for (int i = 0; i < RAY_COUNT; i++) {
+            hitCount += singleHits[i].hit;
+            const bool agrees = fixedHits[i].hit == singleHits[i].hit &&
+                                (!fixedHits[i].hit || std::abs(fixedHits[i].distance - singleHits[i].distance) <=
+                                 FIXED_STEP);
+            disagreements += !agrees;
+        }
+
+        std::printf("Bounds build (CPU samples): %.2f ms\n", buildMs);
+        std::printf("%-28s %10s %12s\n", "", "total ms", "us per ray");
+        std::printf("%-28s %10.2f %12.2f\n", "Fixed step getHeight (0.5)", fixedMs, fixedMs * 1000.0 / RAY_COUNT);
+        std::printf("%-28s %10.2f %12.2f\n", "Pyramid, single thread", singleMs, singleMs * 1000.0 / RAY_COUNT);
+        std::printf("%-28s %10.2f %12.2f\n", "Pyramid, worker pool", batchMs, batchMs * 1000.0 / RAY_COUNT);
+        std::printf("Hits: %d, disagreements with fixed step: %d, worker threads: %zu\n", hitCount, disagreements,
+                    ThreadPool::decodePool().getThreadCount());
+        std::printf("Speedup vs fixed step: %.1fx\n\n", fixedMs / batchMs);
+    }
+}
+
+#endif //TERRAINRAYCASTBENCHMARK_H
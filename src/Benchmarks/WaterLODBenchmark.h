@@ -0,0 +1,60 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef WATERLODBENCHMARK_H
+#define WATERLODBENCHMARK_H
+#include <array>
+#include <cstdio>
+
+#include "../Final/WaterPatchLODGenerator.h"
+
+namespace benchmarks {
+    // Compares the vertex/triangle load of the LOD water against uniform tiles and the old 400x400 camera plane
+    // Worst case: every tile of the 5x5 chunk grid is underwater, camera in the center tile
+    inline void runWaterLODBenchmark() {
+        const int chunkSize = 256;
+        const int chunkAmount = 5;
+        const int tilesPerChunkAxis = 4;
+        const int baseSpacing = 2;
+        const int tileSize = chunkSize / tilesPerChunkAxis;
+        const int tilesPerAxis = chunkAmount * tilesPerChunkAxis;
+
+        WaterLODMeshBuffer buffer = WaterPatchLODGenerator::generateLODMeshBuffer(tileSize, baseSpacing);
+
+        const glm::ivec2 cameraTile = {tilesPerAxis / 2, tilesPerAxis / 2};
+        std::array<GLuint, WaterPatchLODGenerator::LOD_COUNT> tilesPerLod{};
+        std::array<GLuint, WaterPatchLODGenerator::LOD_COUNT> uniformTiles{};
+
+        for (int z = 0; z < tilesPerAxis; z++) {
+            for (int x = 0; x < tilesPerAxis; x++) {
+                tilesPerLod[WaterPatchLODGenerator::calculateLod({x, z}, cameraTile)]++;
+            }
+        }
+        uniformTiles[0] = tilesPerAxis * tilesPerAxis;
+
+        const WaterLODStats lodStats = WaterPatchLODGenerator::calculateStats(buffer, tilesPerLod);
+        const WaterLODStats uniformStats = WaterPatchLODGenerator::calculateStats(buffer, uniformTiles);
+
+        // Previous water plane: 400x400 vertices, 2 triangles per quad
+        const GLuint planeVertices = 400 * 400;
+        const GLuint planeTriangles = 399 * 399 * 2;
+
+        std::printf("== Water LOD ==\n");
+        std::printf("%-6s %8s %10s %10s\n", "LOD", "tiles", "vertices", "triangles");
+        for (const WaterLODMeshDescriptor &mesh: buffer.meshes) {
+            std::printf("%-6d %8u %10u %10u\n", mesh.lod, tilesPerLod[mesh.lod],
+                        tilesPerLod[mesh.lod] * mesh.vertexCount,
+                        tilesPerLod[mesh.lod] * (mesh.indexCount / 3));
+        }
+
+        std::printf("%-22s %10s %10s\n", "", "vertices", "triangles");
+        std::printf("%-22s %10u %10u\n", "400x400 plane", planeVertices, planeTriangles);
+        std::printf("%-22s %10u %10u\n", "Uniform tiles (LOD 0)", uniformStats.vertexCount, uniformStats.triangleCount);
+        std::printf("%-22s %10u %10u\n", "Distance LOD tiles", lodStats.vertexCount, lodStats.triangleCount);
+        std::printf("Vertex reduction vs uniform tiles: %.1fx\n\n",
+                    static_cast<double>(uniformStats.vertexCount) / lodStats.vertexCount);
+    }
+}
+
+#endif //WATERLODBENCHMARK_H
@@ -4,26 +4,25 @@
 
 #ifndef COMPUTESHADER_H
 #define COMPUTESHADER_H
-#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <optional>
+#include <string>
 #include <string_view>
 
+#include "AssetArchive.h"
 #include "glad/glad.h"
 
 
 class ComputeShader {
 public:
     ComputeShader(std::string_view path) {
-        std::ifstream shaderFile{path.begin()};
+        std::optional<std::string> shaderCode = AssetArchive::readText(path);
 
-        if (!shaderFile) {
+        if (!shaderCode) {
             std::cerr << "File not found" << std::endl;
         }
 
-        std::stringstream buffer;
-        buffer << shaderFile.rdbuf();
-        m_shaderCode = buffer.str();
+        m_shaderCode = shaderCode.value_or("");
 
         bool success = compileShader();
 
@@ -50,6 +49,10 @@ public:
         glUniform2fv(glGetUniformLocation(m_programId, name), 1, glm::value_ptr(value));
     }
 
+    void setIVec2(const char *name, glm::ivec2 value) const {
+        glUniform2iv(glGetUniformLocation(m_programId, name), 1, glm::value_ptr(value));
+    }
+
     void setVec3f(const char *name, glm::vec3 value) const {
         glUniform3fv(glGetUniformLocation(m_programId, name), 1, glm::value_ptr(value));
     }
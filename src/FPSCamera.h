@@ -59,6 +59,10 @@ public:
         return m_position;
     }
 
+    [[nodiscard]] glm::vec3 getFront() const {
+        return m_front;
+    }
+
     void updateHeight(const float height) {
         m_position.y = height;
     }
@@ -0,0 +1,377 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef BAKEDHEIGHTMAP_H
+#define BAKEDHEIGHTMAP_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glm/glm.hpp>
+
+#include "HeightPyramid.h"
+#include "TerrainNoise.h"
+#include "../MappedFile.h"
+#include "../ThreadPool.h"
+
+// Binary file layout, every tile record is 16 byte aligned
+//  Header | tiles (row major)
+// Tile record: BakedHeightTileHeader | (tileSize + 1)^2 uint16 samples, quantized between the tile bounds
+struct BakedHeightmapHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t worldSize; // World units per axis, one sample per unit
+    std::uint32_t tileSize; // Quads per tile axis, the last sample row is shared with the next tile
+    float minHeight; // Normalized, the terrain height slider scales it
+    float maxHeight;
+    float maxSlope; // Largest normalized height difference between neighbouring samples
+    std::uint32_t padding;
+    std::uint64_t tilesOffset;
+};
+
+struct BakedHeightTileHeader {
+    float minHeight;
+    float maxHeight;
+};
+
+// Pre-baked terrain heights, memory mapped so only the tiles that get read are paged in
+// One sample per world unit, coarser levels aren't baked since nothing reads them
+// The world is centered around the origin, lookups outside of it clamp to the border
+class BakedHeightmap {
+public:
+    static constexpr char MAGIC[4] = {'R', 'C', 'G', 'H'};
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t ALIGNMENT = 16;
+    static constexpr const char *DEFAULT_PATH = "../assets/cache/world.heights";
+
+    explicit BakedHeightmap(const std::string &path) : m_file(path) {
+        if (!m_file.isOpen() || m_file.size() < sizeof(BakedHeightmapHeader)) {
+            return;
+        }
+
+        const BakedHeightmapHeader &header = getHeader();
+
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            !areTilesInFile(header, m_file.size())) {
+            std::cerr << "Invalid baked heightmap: " << path << std::endl;
+            return;
+        }
+
+        m_identity = readIdentity(path);
+        m_valid = true;
+    }
+
+    [[nodiscard]] bool isValid() const {
+        return m_valid;
+    }
+
+    // Changes whenever the file gets baked again or edited, identifies its heights in cache keys
+    [[nodiscard]] std::uint64_t getIdentity() const {
+        return m_identity;
+    }
+
+    [[nodiscard]] int getWorldSize() const {
+        return static_cast<int>(getHeader().worldSize);
+    }
+
+    // World position of sample (0, 0)
+    [[nodiscard]] glm::vec2 getOrigin() const {
+        return glm::vec2{-0.5f * static_cast<float>(getWorldSize())};
+    }
+
+    // Normalized height range of the whole world
+    [[nodiscard]] HeightBounds getBounds() const {
+        return {getHeader().minHeight, getHeader().maxHeight};
+    }
+
+    // Bound of the normalized slope between samples, the bilinear surface can be at most sqrt(2) steeper
+    [[nodiscard]] float getMaxSlope() const {
+        return getHeader().maxSlope * std::sqrt(2.0f);
+    }
+
+    // Normalized height of a sample, indices are clamped to the world
+    [[nodiscard]] float getSample(int x, int z) const {
+        const BakedHeightmapHeader &header = getHeader();
+        const int tileSize = static_cast<int>(header.tileSize);
+        const int tilesPerAxis = getTilesPerAxis();
+        const int lastSample = tilesPerAxis * tileSize;
+
+        x = std::clamp(x, 0, lastSample);
+        z = std::clamp(z, 0, lastSample);
+
+        // The last sample of the world belongs to the last tile
+        const int tileX = std::min(x / tileSize, tilesPerAxis - 1);
+        const int tileZ = std::min(z / tileSize, tilesPerAxis - 1);
+        const std::byte *record = getTileRecord(tileX, tileZ);
+
+        const auto &tileHeader = *reinterpret_cast<const BakedHeightTileHeader *>(record);
+        const auto *samples = reinterpret_cast<const std::uint16_t *>(record + sizeof(BakedHeightTileHeader));
+        const std::uint16_t quantized = samples[(z - tileZ * tileSize) * (tileSize + 1) + x - tileX * tileSize];
+
+        return dequantize(tileHeader, quantized);
+    }
+
+    // Normalized, bilinear between the samples
+    [[nodiscard]] float getHeight(const glm::vec2 &xzPos) const {
+        const glm::vec2 samplePos = xzPos - getOrigin();
+        const glm::vec2 base = glm::floor(samplePos);
+        const glm::vec2 fraction = samplePos - base;
+        const int x = static_cast<int>(base.x);
+        const int z = static_cast<int>(base.y);
+
+        const float h0 = glm::mix(getSample(x, z), getSample(x + 1, z), fraction.x);
+        const float h1 = glm::mix(getSample(x, z + 1), getSample(x + 1, z + 1), fraction.x);
+        return glm::mix(h0, h1, fraction.y);
+    }
+
+    // size^2 normalized samples starting at the given world position, row major
+    void readRegion(const glm::ivec2 &firstSamplePos, const int size, std::vector<float> &out) const {
+        const glm::ivec2 firstSample = firstSamplePos - glm::ivec2(getOrigin());
+        out.resize(size * size);
+
+        for (int z = 0; z < size; z++) {
+            for (int x = 0; x < size; x++) {
+                out[z * size + x] = getSample(firstSample.x + x, firstSample.y + z);
+            }
+        }
+    }
+
+    // Asks the kernel to page in the tiles overlapping the area, so a later readRegion doesn't stall on disk
+    void prefetchRegion(const glm::vec2 &min, const glm::vec2 &max) const {
+        const int tileSize = static_cast<int>(getHeader().tileSize);
+        const int lastTile = getTilesPerAxis() - 1;
+        auto tileAt = [&](const glm::vec2 &xzPos) {
+            const glm::ivec2 tile = glm::ivec2(glm::floor((xzPos - getOrigin()) / static_cast<float>(tileSize)));
+            return glm::clamp(tile, glm::ivec2{0}, glm::ivec2{lastTile});
+        };
+
+        const glm::ivec2 firstTile = tileAt(min);
+        const glm::ivec2 lastTileInArea = tileAt(max);
+        const std::size_t recordSize = getRecordSize(tileSize);
+
+        // Tiles of a row are contiguous
+        for (int z = firstTile.y; z <= lastTileInArea.y; z++) {
+            const std::size_t offset = getTileRecord(firstTile.x, z) - m_file.data();
+            m_file.prefetch(offset, (lastTileInArea.x - firstTile.x + 1) * recordSize);
+        }
+    }
+
+    // Samples the noise into a new heightmap, every tile row is a task on the worker pool
+    // worldSize and tileSize have to be powers of two
+    static bool bake(const TerrainNoiseParams &params, const int worldSize, const int tileSize,
+                     const std::string &outPath) {
+        if (worldSize < tileSize || (worldSize & (worldSize - 1)) != 0 || (tileSize & (tileSize - 1)) != 0) {
+            std::cerr << "Baked heightmap sizes have to be powers of two" << std::endl;
+            return false;
+        }
+
+        BakedHeightmapHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.worldSize = worldSize;
+        header.tileSize = tileSize;
+        header.tilesOffset = alignUp(sizeof(BakedHeightmapHeader));
+
+        // Records have a fixed size, every tile can be written independently
+        const int tilesPerAxis = worldSize / tileSize;
+        const std::size_t recordSize = getRecordSize(tileSize);
+        const std::size_t fileSize = header.tilesOffset + static_cast<std::size_t>(tilesPerAxis) * tilesPerAxis * recordSize;
+
+        const std::string tmpPath = outPath + ".tmp";
+        const int fd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(fileSize)) != 0) {
+            std::cerr << "Unable to write baked heightmap: " << outPath << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+
+        // Heights get stored normalized, the terrain height is applied when they are used
+        TerrainNoiseParams normalizedParams = params;
+        normalizedParams.terrainHeight = 1.0f;
+
+        std::vector<std::future<BakeStats> > rows;
+
+        for (int tileZ = 0; tileZ < tilesPerAxis; tileZ++) {
+            rows.push_back(ThreadPool::decodePool().submit([&, tileZ] {
+                BakeStats rowStats = BakeStats::empty();
+                std::vector<float> heights((tileSize + 1) * (tileSize + 1));
+                std::vector<std::byte> record(recordSize);
+
+                for (int tileX = 0; tileX < tilesPerAxis; tileX++) {
+                    const glm::ivec2 firstSample = glm::ivec2(tileX, tileZ) * tileSize;
+
+                    for (int z = 0; z <= tileSize; z++) {
+                        for (int x = 0; x <= tileSize; x++) {
+                            const glm::ivec2 sample = firstSample + glm::ivec2(x, z);
+                            const glm::vec2 xzPos = glm::vec2(sample) - 0.5f * static_cast<float>(worldSize);
+                            heights[z * (tileSize + 1) + x] = TerrainNoise::getHeight(normalizedParams, xzPos);
+                        }
+                    }
+
+                    rowStats.merge(encodeTile(heights, tileSize, record));
+
+                    const std::size_t tileIndex = tileZ * tilesPerAxis + tileX;
+                    const std::size_t offset = header.tilesOffset + tileIndex * recordSize;
+                    if (pwrite(fd, record.data(), recordSize, static_cast<off_t>(offset)) !=
+                        static_cast<ssize_t>(recordSize)) {
+                        rowStats.maxSlope = -1.0f;
+                    }
+                }
+
+                return rowStats;
+            }));
+        }
+
+        BakeStats stats = BakeStats::empty();
+        for (std::future<BakeStats> &row: rows) {
+            stats.merge(row.get());
+        }
+
+        header.minHeight = stats.minHeight;
+        header.maxHeight = stats.maxHeight;
+        header.maxSlope = stats.maxSlope;
+
+        bool success = stats.maxSlope >= 0.0f &&
+                       pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        close(fd);
+
+        if (!success || std::rename(tmpPath.c_str(), outPath.c_str()) != 0) {
+            std::cerr << "Unable to write baked heightmap: " << outPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    struct BakeStats {
+        float minHeight;
+        float maxHeight;
+        float maxSlope; // Negative if a write failed
+
+        static BakeStats empty() {
+            return {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0f};
+        }
+
+        void merge(const BakeStats &other) {
+            minHeight = std::min(minHeight, other.minHeight);
+            maxHeight = std::max(maxHeight, other.maxHeight);
+            maxSlope = maxSlope < 0.0f || other.maxSlope < 0.0f ? -1.0f : std::max(maxSlope, other.maxSlope);
+        }
+    };
+
+    MappedFile m_file;
+    bool m_valid{false};
+    std::uint64_t m_identity{0};
+
+    // FNV-1a over the size and the modification time, a bake writes a new file that gets renamed into place
+    static std::uint64_t readIdentity(const std::string &path) {
+        struct stat fileStat{};
+        if (stat(path.c_str(), &fileStat) != 0) {
+            return 0;
+        }
+
+        const std::int64_t fields[3] = {
+            static_cast<std::int64_t>(fileStat.st_size), static_cast<std::int64_t>(fileStat.st_mtim.tv_sec),
+            static_cast<std::int64_t>(fileStat.st_mtim.tv_nsec)
+        };
+
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        unsigned char bytes[sizeof(fields)];
+        std::memcpy(bytes, fields, sizeof(fields));
+        for (const unsigned char byte: bytes) {
+            hash = (hash ^ byte) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    [[nodiscard]] const BakedHeightmapHeader &getHeader() const {
+        return *reinterpret_cast<const BakedHeightmapHeader *>(m_file.data());
+    }
+
+    // Every tile record a lookup can reach has to lie inside the mapping
+    static bool areTilesInFile(const BakedHeightmapHeader &header, const std::size_t fileSize) {
+        if (header.tileSize == 0 || header.worldSize < header.tileSize || header.worldSize % header.tileSize != 0 ||
+            header.tilesOffset % ALIGNMENT != 0 || header.tilesOffset > fileSize) {
+            return false;
+        }
+
+        const std::uint64_t tilesPerAxis = header.worldSize / header.tileSize;
+        const std::uint64_t tilesSize = tilesPerAxis * tilesPerAxis * getRecordSize(header.tileSize);
+        return tilesSize <= fileSize - header.tilesOffset;
+    }
+
+    [[nodiscard]] int getTilesPerAxis() const {
+        return static_cast<int>(getHeader().worldSize / getHeader().tileSize);
+    }
+
+    [[nodiscard]] const std::byte *getTileRecord(const int tileX, const int tileZ) const {
+        const BakedHeightmapHeader &header = getHeader();
+        const std::size_t tileIndex = tileZ * getTilesPerAxis() + tileX;
+        return m_file.data() + header.tilesOffset + tileIndex * getRecordSize(header.tileSize);
+    }
+
+    static std::size_t alignUp(const std::size_t size) {
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    static std::size_t getRecordSize(const std::size_t tileSize) {
+        return alignUp(sizeof(BakedHeightTileHeader) + (tileSize + 1) * (tileSize + 1) * sizeof(std::uint16_t));
+    }
+
+    static float dequantize(const BakedHeightTileHeader &tileHeader, const std::uint16_t quantized) {
+        return tileHeader.minHeight +
+               (tileHeader.maxHeight - tileHeader.minHeight) * (static_cast<float>(quantized) / 65535.0f);
+    }
+
+    // Quantizes the heights into record
+    static BakeStats encodeTile(const std::vector<float> &heights, const int tileSize, std::vector<std::byte> &record) {
+        const int rowLength = tileSize + 1;
+        BakeStats stats = BakeStats::empty();
+
+        const auto [minIt, maxIt] = std::minmax_element(heights.begin(), heights.end());
+        stats.minHeight = *minIt;
+        stats.maxHeight = *maxIt;
+
+        for (int z = 0; z < rowLength; z++) {
+            for (int x = 0; x < rowLength; x++) {
+                const float height = heights[z * rowLength + x];
+                if (x > 0) {
+                    stats.maxSlope = std::max(stats.maxSlope, std::abs(height - heights[z * rowLength + x - 1]));
+                }
+                if (z > 0) {
+                    stats.maxSlope = std::max(stats.maxSlope, std::abs(height - heights[(z - 1) * rowLength + x]));
+                }
+            }
+        }
+
+        const BakedHeightTileHeader tileHeader = {stats.minHeight, stats.maxHeight};
+        const float range = stats.maxHeight - stats.minHeight;
+        std::memcpy(record.data(), &tileHeader, sizeof(tileHeader));
+
+        auto *samples = reinterpret_cast<std::uint16_t *>(record.data() + sizeof(BakedHeightTileHeader));
+        for (std::size_t i = 0; i < heights.size(); i++) {
+            const float normalized = range > 0.0f ? (heights[i] - stats.minHeight) / range : 0.0f;
+            samples[i] = static_cast<std::uint16_t>(std::lround(normalized * 65535.0f));
+        }
+
+        return stats;
+    }
+};
+
+#endif //BAKEDHEIGHTMAP_H
@@ -0,0 +1,285 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef CHUNKDISKCACHE_H
+#define CHUNKDISKCACHE_H
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "TerrainNoise.h"
+#include "../MappedFile.h"
+#include "../ThreadPool.h"
+
+// Everything the generated data of a chunk depends on
+struct ChunkCacheKey {
+    TerrainNoiseParams params;
+    glm::ivec2 chunkCoord; // Global position divided by the chunk size
+    int chunkSize;
+    int lod;
+    int meshVariant; // Patch template of the grid slot, LODs differ in their stitched edges
+    int heightSource; // TerrainHeightSource
+    std::uint64_t heightmapIdentity; // BakedHeightmap::getIdentity for baked heights, 0 for the noise
+
+    [[nodiscard]] std::uint64_t hash() const {
+        // FNV-1a over the fields, floats by their bits
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        auto append = [&hash](const auto &value) {
+            unsigned char bytes[sizeof(value)];
+            std::memcpy(bytes, &value, sizeof(value));
+
+            for (const unsigned char byte: bytes) {
+                hash = (hash ^ byte) * 0x100000001b3ull;
+            }
+        };
+
+        append(params.terrainHeight);
+        append(params.octaves);
+        append(params.scale);
+        append(params.persistance);
+        append(params.lucunarity);
+        append(chunkCoord.x);
+        append(chunkCoord.y);
+        append(chunkSize);
+        append(lod);
+        append(meshVariant);
+        append(heightSource);
+        append(heightmapIdentity);
+        return hash;
+    }
+};
+
+// File layout: ChunkCacheFileHeader | vertices (height, octahedron normal) | bounds cells (ordered min/max bits)
+struct ChunkCacheFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t keyHash;
+    std::uint32_t vertexCount;
+    std::uint32_t boundsCellCount;
+};
+
+// Mapped cache file, pointers stay valid as long as the entry lives
+struct ChunkCacheEntry {
+    MappedFile file;
+    const std::uint32_t *vertices; // 2 per vertex, same layout as the terrain SSBO
+    const std::uint32_t *bounds; // 2 per cell, same layout as the chunk bounds SSBO
+};
+
+struct ChunkDiskCacheStats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int writes;
+    unsigned int evictions;
+    std::uint64_t bytes; // On disk
+};
+
+// Generated chunk data kept on disk across runs, one file per key hash
+// Writes happen on the worker pool, the least recently used files get deleted once MAX_BYTES is exceeded
+// A hit refreshes the modification time, so the order survives restarts
+class ChunkDiskCache {
+public:
+    static constexpr char MAGIC[4] = {'R', 'C', 'G', 'C'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint64_t MAX_BYTES = 256ull * 1024 * 1024;
+    static constexpr const char *DEFAULT_DIRECTORY = "../assets/cache/chunks";
+
+    explicit ChunkDiskCache(std::string directory) : m_directory(std::move(directory)) {
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        for (auto it = std::filesystem::directory_iterator(m_directory, error);
+             it != std::filesystem::directory_iterator(); it.increment(error)) {
+            if (error) {
+                break;
+            }
+
+            if (it->is_regular_file(error) && it->path().extension() == ".chunk") {
+                const std::uint64_t size = it->file_size(error);
+                const auto lastUse = it->last_write_time(error);
+
+                if (!error) {
+                    m_files[it->path().filename().string()] = {size, lastUse};
+                    m_stats.bytes += size;
+                }
+            }
+        }
+
+        // The limit may have been lowered or the directory filled by hand
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evictLeastRecentlyUsed();
+    }
+
+    ~ChunkDiskCache() {
+        // Writes capture this
+        for (std::future<void> &write: m_pendingWrites) {
+            write.wait();
+        }
+    }
+
+    ChunkDiskCache(const ChunkDiskCache &) = delete;
+    ChunkDiskCache &operator=(const ChunkDiskCache &) = delete;
+
+    // Counts a hit or a miss, a file with the wrong size or header is a miss
+    std::optional<ChunkCacheEntry> load(const ChunkCacheKey &key, const std::uint32_t vertexCount,
+                                        const std::uint32_t boundsCellCount) {
+        const std::uint64_t keyHash = key.hash();
+        const std::string fileName = getFileName(keyHash);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_files.find(fileName) == m_files.end()) {
+                m_stats.misses++;
+                return std::nullopt;
+            }
+        }
+
+        const std::string path = m_directory + "/" + fileName;
+        ChunkCacheEntry entry{MappedFile{path}, nullptr, nullptr};
+        const std::size_t expectedSize = getFileSize(vertexCount, boundsCellCount);
+
+        if (entry.file.size() != expectedSize) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.misses++;
+            return std::nullopt;
+        }
+
+        const auto &header = *reinterpret_cast<const ChunkCacheFileHeader *>(entry.file.data());
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.keyHash != keyHash || header.vertexCount != vertexCount ||
+            header.boundsCellCount != boundsCellCount) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.misses++;
+            return std::nullopt;
+        }
+
+        entry.vertices = reinterpret_cast<const std::uint32_t *>(entry.file.data() + sizeof(ChunkCacheFileHeader));
+        entry.bounds = entry.vertices + vertexCount * 2;
+        entry.file.prefetch();
+
+        // Most recently used again
+        std::error_code error;
+        const auto now = std::filesystem::file_time_type::clock::now();
+        std::filesystem::last_write_time(path, now, error);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.hits++;
+        auto it = m_files.find(fileName);
+        if (it != m_files.end()) {
+            it->second.lastUse = now;
+        }
+
+        return entry;
+    }
+
+    // Writes the chunk in the background, vertices and bounds are 2 uints per element
+    void store(const ChunkCacheKey &key, std::vector<std::uint32_t> vertices, std::vector<std::uint32_t> bounds) {
+        m_pendingWrites.erase(std::remove_if(m_pendingWrites.begin(), m_pendingWrites.end(),
+                                             [](const std::future<void> &write) {
+                                                 return write.wait_for(std::chrono::seconds(0)) ==
+                                                        std::future_status::ready;
+                                             }), m_pendingWrites.end());
+
+        m_pendingWrites.push_back(ThreadPool::decodePool().submit([this, keyHash = key.hash(), vertices = std::move(vertices),
+                    bounds = std::move(bounds)] {
+            write(keyHash, vertices, bounds);
+        }));
+    }
+
+    [[nodiscard]] ChunkDiskCacheStats getStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    struct FileInfo {
+        std::uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    std::string m_directory;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, FileInfo> m_files;
+    ChunkDiskCacheStats m_stats{0, 0, 0, 0, 0};
+    std::vector<std::future<void> > m_pendingWrites; // Only touched by the render thread
+
+    static std::string getFileName(const std::uint64_t keyHash) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.chunk", static_cast<unsigned long long>(keyHash));
+        return name;
+    }
+
+    static std::size_t getFileSize(const std::uint32_t vertexCount, const std::uint32_t boundsCellCount) {
+        return sizeof(ChunkCacheFileHeader) + (vertexCount + boundsCellCount) * 2 * sizeof(std::uint32_t);
+    }
+
+    void write(const std::uint64_t keyHash, const std::vector<std::uint32_t> &vertices,
+               const std::vector<std::uint32_t> &bounds) {
+        const std::string fileName = getFileName(keyHash);
+        const std::string path = m_directory + "/" + fileName;
+        const std::string tmpPath = path + ".tmp";
+
+        ChunkCacheFileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.keyHash = keyHash;
+        header.vertexCount = static_cast<std::uint32_t>(vertices.size() / 2);
+        header.boundsCellCount = static_cast<std::uint32_t>(bounds.size() / 2);
+
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(std::uint32_t));
+            out.write(reinterpret_cast<const char *>(bounds.data()), bounds.size() * sizeof(std::uint32_t));
+
+            if (!out) {
+                std::remove(tmpPath.c_str());
+                return;
+            }
+        }
+
+        // Readers only ever see complete files
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            return;
+        }
+
+        const std::uint64_t size = getFileSize(header.vertexCount, header.boundsCellCount);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, inserted] = m_files.try_emplace(fileName, FileInfo{0, {}});
+        m_stats.bytes += size - it->second.size;
+        it->second = {size, std::filesystem::file_time_type::clock::now()};
+        m_stats.writes++;
+
+        evictLeastRecentlyUsed();
+    }
+
+    // Expects the mutex to be held
+    void evictLeastRecentlyUsed() {
+        while (m_stats.bytes > MAX_BYTES && m_files.size() > 1) {
+            auto oldest = std::min_element(m_files.begin(), m_files.end(), [](const auto &a, const auto &b) {
+                return a.second.lastUse < b.second.lastUse;
+            });
+
+            std::error_code error;
+            std::filesystem::remove(m_directory + "/" + oldest->first, error);
+            m_stats.bytes -= oldest->second.size;
+            m_stats.evictions++;
+            m_files.erase(oldest);
+        }
+    }
+};
+
+#endif //CHUNKDISKCACHE_H
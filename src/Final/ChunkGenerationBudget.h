@@ -0,0 +1,140 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef CHUNKGENERATIONBUDGET_H
+#define CHUNKGENERATIONBUDGET_H
+#include <array>
+#include <deque>
+#include <vector>
+
+#include "glad/glad.h"
+
+// Per chunk passes of a grid, all of them share the frame budget
+enum class ChunkWork {
+    VERTICES = 0, // Heights, normals and bounds into the pool slot
+    INSTANCES, // Grass and tree placement from the resident vertices
+    WATER // Water mask of the pool slot
+};
+
+// How many chunks fit into the terrain generation time of a frame
+// GPU time per chunk is measured with timer queries, the results arrive a few frames later
+// and update a running average per pass and LOD, which is what the budget is checked against
+class ChunkGenerationBudget {
+public:
+    static constexpr int LOD_COUNT = 3;
+    static constexpr int WORK_COUNT = 3;
+
+    ChunkGenerationBudget() = default;
+
+    ~ChunkGenerationBudget() {
+        for (const PendingQuery &pending: m_pendingQueries) {
+            m_freeQueries.push_back(pending.query);
+        }
+
+        if (!m_freeQueries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+        }
+    }
+
+    ChunkGenerationBudget(const ChunkGenerationBudget &) = delete;
+    ChunkGenerationBudget &operator=(const ChunkGenerationBudget &) = delete;
+
+    void setBudgetMs(const float budgetMs) {
+        m_budgetMs = budgetMs;
+    }
+
+    [[nodiscard]] float getBudgetMs() const {
+        return m_budgetMs;
+    }
+
+    // Collects finished queries and starts the frame with an empty budget
+    void beginFrame() {
+        while (!m_pendingQueries.empty()) {
+            const PendingQuery &pending = m_pendingQueries.front();
+
+            GLint available = 0;
+            glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsedNs);
+            const float elapsedMs = static_cast<float>(elapsedNs) / 1.0e6f;
+
+            float &estimate = m_estimatedMs[pending.work][pending.lod];
+            estimate = estimate + (elapsedMs - estimate) * 0.25f;
+            m_lastMeasuredMs = elapsedMs;
+
+            m_freeQueries.push_back(pending.query);
+            m_pendingQueries.pop_front();
+        }
+
+        m_spentMs = 0.0f;
+    }
+
+    // The first chunk of a frame always fits, otherwise a budget below one chunk would stall generation
+    [[nodiscard]] bool fits(const int lod, const ChunkWork work = ChunkWork::VERTICES) const {
+        return m_spentMs == 0.0f || m_spentMs + getEstimatedMs(lod, work) <= m_budgetMs;
+    }
+
+    // Wraps the dispatches of one chunk in a timer query
+    void beginChunk(const int lod, const ChunkWork work = ChunkWork::VERTICES) {
+        if (m_freeQueries.empty()) {
+            GLuint query;
+            glGenQueries(1, &query);
+            m_freeQueries.push_back(query);
+        }
+
+        m_currentQuery = {m_freeQueries.back(), static_cast<int>(work), lod};
+        m_freeQueries.pop_back();
+        glBeginQuery(GL_TIME_ELAPSED, m_currentQuery.query);
+    }
+
+    void endChunk() {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_pendingQueries.push_back(m_currentQuery);
+        m_spentMs += m_estimatedMs[m_currentQuery.work][m_currentQuery.lod];
+    }
+
+    // Work measured on the CPU, like uploads from the disk cache
+    void spend(const float ms) {
+        m_spentMs += ms;
+    }
+
+    [[nodiscard]] float getSpentMs() const {
+        return m_spentMs;
+    }
+
+    [[nodiscard]] float getEstimatedMs(const int lod, const ChunkWork work = ChunkWork::VERTICES) const {
+        return m_estimatedMs[static_cast<int>(work)][lod];
+    }
+
+    [[nodiscard]] float getLastMeasuredMs() const {
+        return m_lastMeasuredMs;
+    }
+
+private:
+    struct PendingQuery {
+        GLuint query;
+        int work;
+        int lod;
+    };
+
+    float m_budgetMs{2.0f};
+    float m_spentMs{0.0f};
+    float m_lastMeasuredMs{0.0f};
+    // Initial guesses until the first queries come back, LOD 0 has the most vertices
+    // The water mask has the same resolution for every LOD
+    std::array<std::array<float, LOD_COUNT>, WORK_COUNT> m_estimatedMs{{
+        {1.0f, 0.3f, 0.15f},
+        {0.5f, 0.15f, 0.08f},
+        {0.3f, 0.3f, 0.3f}
+    }};
+    PendingQuery m_currentQuery{0, 0, 0};
+    std::deque<PendingQuery> m_pendingQueries;
+    std::vector<GLuint> m_freeQueries;
+};
+
+#endif //CHUNKGENERATIONBUDGET_H
@@ -0,0 +1,171 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef CLIPMAPMESHGENERATOR_H
+#define CLIPMAPMESHGENERATOR_H
+#include <cstdint>
+#include <vector>
+
+#include "../MeshOptimizer.h"
+#include "glad/glad.h"
+
+struct ClipmapMeshDescriptor {
+    GLint baseVertex;
+    GLuint indexOffset;
+    GLuint indexCount;
+    GLuint vertexCount;
+};
+
+struct ClipmapMeshBuffer {
+    std::vector<GLfloat> vertexBuffer; // XZ in level units
+    std::vector<GLuint> indexBuffer; // Relative to the base vertex of each mesh
+    std::vector<ClipmapMeshDescriptor> meshes; // Indexed by ClipmapMesh
+};
+
+enum ClipmapMesh {
+    CLIPMAP_MESH_FULL = 0, // Finest level, no hole
+    CLIPMAP_MESH_RING, // Coarser levels, hole for the next finer level
+    CLIPMAP_MESH_TRIM, // 4 L-shaped trims, CLIPMAP_MESH_TRIM + (parent offset x + 2 * parent offset z)
+    CLIPMAP_MESH_SEAM = CLIPMAP_MESH_TRIM + 4, // Closes the T-junctions towards the next coarser level
+    CLIPMAP_MESH_COUNT
+};
+
+// Geometry shared by all clipmap levels, vertices are in units of the level spacing
+// A level is a grid of 4 * blockSize + 1 quads around its snapped center
+//  -> The hole of a ring is 2 * blockSize + 1 quads wide, in finer level units 4 * blockSize + 2
+//  -> The finer level only covers 4 * blockSize + 1 of those, the trim fills the one quad left
+//     Depending on where the finer level snapped inside its parent the trim sits on the low or the high side
+// All meshes are placed relative to their origin, the vertex shader scales and offsets them per level
+class ClipmapMeshGenerator {
+public:
+    static ClipmapMeshBuffer generateMeshBuffer(const int blockSize) {
+        ClipmapMeshBuffer buffer;
+        buffer.meshes.resize(CLIPMAP_MESH_COUNT);
+
+        const int levelSize = 4 * blockSize + 1;
+        const int holeStart = blockSize;
+        const int holeEnd = 3 * blockSize + 1;
+        const int trimSize = levelSize + 1;
+
+        // Full level
+        {
+            MeshData mesh;
+            appendGrid(mesh, 0, 0, levelSize, levelSize);
+            insertMesh(buffer, mesh, CLIPMAP_MESH_FULL);
+        }
+
+        // Ring, 4 strips around the hole
+        {
+            MeshData mesh;
+            appendGrid(mesh, 0, 0, levelSize, holeStart);
+            appendGrid(mesh, 0, holeEnd, levelSize, levelSize - holeEnd);
+            appendGrid(mesh, 0, holeStart, holeStart, holeEnd - holeStart);
+            appendGrid(mesh, holeEnd, holeStart, levelSize - holeEnd, holeEnd - holeStart);
+            insertMesh(buffer, mesh, CLIPMAP_MESH_RING);
+        }
+
+        // Trims, origin is the hole origin of the parent level
+        // An offset of 0 means the finer level starts at the hole origin and the trim goes to the high side
+        for (int offsetZ = 0; offsetZ < 2; offsetZ++) {
+            for (int offsetX = 0; offsetX < 2; offsetX++) {
+                const int columnX = offsetX == 0 ? trimSize - 1 : 0;
+                const int rowZ = offsetZ == 0 ? trimSize - 1 : 0;
+                const int rowStartX = offsetX == 0 ? 0 : 1;
+
+                MeshData mesh;
+                appendGrid(mesh, columnX, 0, 1, trimSize);
+                appendGrid(mesh, rowStartX, rowZ, trimSize - 1, 1);
+                insertMesh(buffer, mesh, CLIPMAP_MESH_TRIM + offsetX + 2 * offsetZ);
+            }
+        }
+
+        // Seam, runs around the border of the trimmed level
+        // Every second vertex lies on the parent grid, the triangles in between are degenerate in XZ
+        // and close the crack to the straight parent edge
+        {
+            MeshData mesh;
+            for (int i = 0; i < trimSize; i++) {
+                appendVertex(mesh, i, 0);
+            }
+            for (int i = 0; i < trimSize; i++) {
+                appendVertex(mesh, trimSize, i);
+            }
+            for (int i = 0; i < trimSize; i++) {
+                appendVertex(mesh, trimSize - i, trimSize);
+            }
+            for (int i = 0; i < trimSize; i++) {
+                appendVertex(mesh, 0, trimSize - i);
+            }
+
+            // Stands vertically, both windings so back face culling keeps it from either side
+            const auto vertexCount = static_cast<GLuint>(mesh.vertices.size() / 2);
+            for (GLuint i = 0; i < vertexCount; i += 2) {
+                const GLuint next = i + 1;
+                const GLuint last = (i + 2) % vertexCount;
+
+                mesh.indices.insert(mesh.indices.end(), {i, next, last});
+                mesh.indices.insert(mesh.indices.end(), {last, next, i});
+            }
+
+            insertMesh(buffer, mesh, CLIPMAP_MESH_SEAM);
+        }
+
+        return buffer;
+    }
+
+private:
+    struct MeshData {
+        std::vector<GLfloat> vertices;
+        std::vector<GLuint> indices;
+    };
+
+    static void appendVertex(MeshData &mesh, const int x, const int z) {
+        mesh.vertices.push_back(static_cast<GLfloat>(x));
+        mesh.vertices.push_back(static_cast<GLfloat>(z));
+    }
+
+    // Grid of width * height quads, same winding as the terrain patches
+    static void appendGrid(MeshData &mesh, const int startX, const int startZ, const int width, const int height) {
+        const auto firstVertex = static_cast<GLuint>(mesh.vertices.size() / 2);
+
+        for (int z = 0; z <= height; z++) {
+            for (int x = 0; x <= width; x++) {
+                appendVertex(mesh, startX + x, startZ + z);
+            }
+        }
+
+        const auto rowLength = static_cast<GLuint>(width + 1);
+        for (GLuint z = 0; z < static_cast<GLuint>(height); z++) {
+            for (GLuint x = 0; x < static_cast<GLuint>(width); x++) {
+                const GLuint topLeft = firstVertex + z * rowLength + x;
+                const GLuint topRight = topLeft + 1;
+                const GLuint bottomLeft = topLeft + rowLength;
+                const GLuint bottomRight = bottomLeft + 1;
+
+                mesh.indices.insert(mesh.indices.end(), {bottomLeft, bottomRight, topRight});
+                mesh.indices.insert(mesh.indices.end(), {bottomLeft, topRight, topLeft});
+            }
+        }
+    }
+
+    static void insertMesh(ClipmapMeshBuffer &buffer, MeshData &mesh, const int meshIndex) {
+        const auto vertexCount = static_cast<std::uint32_t>(mesh.vertices.size() / 2);
+
+        // Heights come from the clipmap texture, only the vertex cache order matters
+        mesh.indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+        MeshOptimizer::optimizeVertexFetch(mesh.vertices, 2, mesh.indices);
+
+        buffer.meshes[meshIndex] = {
+            static_cast<GLint>(buffer.vertexBuffer.size() / 2), // 2 GLfloats per vertex
+            static_cast<GLuint>(buffer.indexBuffer.size()),
+            static_cast<GLuint>(mesh.indices.size()),
+            vertexCount
+        };
+
+        buffer.vertexBuffer.insert(buffer.vertexBuffer.end(), mesh.vertices.begin(), mesh.vertices.end());
+        buffer.indexBuffer.insert(buffer.indexBuffer.end(), mesh.indices.begin(), mesh.indices.end());
+    }
+};
+
+#endif //CLIPMAPMESHGENERATOR_H
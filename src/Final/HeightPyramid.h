@@ -0,0 +1,99 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef HEIGHTPYRAMID_H
+#define HEIGHTPYRAMID_H
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+struct HeightBounds {
+    float min;
+    float max;
+};
+
+// Min/max mip chain over a square grid of height samples
+// Level 0 has one cell per quad of samples, every further level merges 2x2 cells until a single one is left
+class HeightPyramid {
+public:
+    HeightPyramid() = default;
+
+    // (cellCount + 1)^2 samples in row major order, cellCount has to be a power of two
+    HeightPyramid(const std::vector<float> &samples, const int cellCount) : m_cellCount(cellCount) {
+        assert(samples.size() == static_cast<std::size_t>((cellCount + 1) * (cellCount + 1)));
+        const int sampleRow = cellCount + 1;
+
+        std::vector<HeightBounds> base(cellCount * cellCount);
+        for (int z = 0; z < cellCount; z++) {
+            for (int x = 0; x < cellCount; x++) {
+                const float h00 = samples[z * sampleRow + x];
+                const float h10 = samples[z * sampleRow + x + 1];
+                const float h01 = samples[(z + 1) * sampleRow + x];
+                const float h11 = samples[(z + 1) * sampleRow + x + 1];
+
+                base[z * cellCount + x] = {std::min({h00, h10, h01, h11}), std::max({h00, h10, h01, h11})};
+            }
+        }
+        m_levels.push_back(std::move(base));
+        buildLevels();
+    }
+
+    // Level 0 given directly, cellCount^2 bounds in row major order
+    HeightPyramid(std::vector<HeightBounds> cells, const int cellCount) : m_cellCount(cellCount) {
+        assert(cells.size() == static_cast<std::size_t>(cellCount * cellCount));
+        m_levels.push_back(std::move(cells));
+        buildLevels();
+    }
+
+    [[nodiscard]] bool isEmpty() const {
+        return m_levels.empty();
+    }
+
+    [[nodiscard]] int getLevelCount() const {
+        return static_cast<int>(m_levels.size());
+    }
+
+    [[nodiscard]] int getCellCount(const int level) const {
+        return m_cellCount >> level;
+    }
+
+    [[nodiscard]] HeightBounds getBounds(const int level, const int x, const int z) const {
+        return m_levels[level][z * getCellCount(level) + x];
+    }
+
+    // Whole grid
+    [[nodiscard]] HeightBounds getBounds() const {
+        return m_levels.back().front();
+    }
+
+private:
+    int m_cellCount{0};
+    std::vector<std::vector<HeightBounds> > m_levels;
+
+    void buildLevels() {
+        for (int size = m_cellCount / 2; size >= 1; size /= 2) {
+            const std::vector<HeightBounds> &finer = m_levels.back();
+            const int finerSize = size * 2;
+            std::vector<HeightBounds> level(size * size);
+
+            for (int z = 0; z < size; z++) {
+                for (int x = 0; x < size; x++) {
+                    const HeightBounds &b00 = finer[(2 * z) * finerSize + 2 * x];
+                    const HeightBounds &b10 = finer[(2 * z) * finerSize + 2 * x + 1];
+                    const HeightBounds &b01 = finer[(2 * z + 1) * finerSize + 2 * x];
+                    const HeightBounds &b11 = finer[(2 * z + 1) * finerSize + 2 * x + 1];
+
+                    level[z * size + x] = {
+                        std::min({b00.min, b10.min, b01.min, b11.min}),
+                        std::max({b00.max, b10.max, b01.max, b11.max})
+                    };
+                }
+            }
+
+            m_levels.push_back(std::move(level));
+        }
+    }
+};
+
+#endif //HEIGHTPYRAMID_H
@@ -4,10 +4,12 @@
 
 #ifndef INSTANCINGMANAGER_H
 #define INSTANCINGMANAGER_H
+#include <array>
 #include <glm/vec3.hpp>
 
 #include "../ComputeShader.h"
 #include "../RenderCall.h"
+#include "../VertexBindings.h"
 #include "../../external/glfw/src/internal.h"
 #include "../Shaders/BaseShaderProgram.h"
 
@@ -17,10 +19,11 @@
 // 1. Add models to be instanced
 // 2. Initialize the SSBO
 //   -> Generate instance count atomics and set to 0
-// 3. On terrain compute recalculations
-//   -> Set Shader offset uniforms
-//   -> Retrieve instancing amounts
-//   -> Reset atomics to 0
+// 3. On terrain recalculations, placement runs into the back buffers while the front ones are drawn
+//   -> beginPlacement resets the back atomics and the cell grid
+//   -> Bind the placement buffers and set the shader offset uniforms before every chunk dispatch, chunks can span frames
+//   -> endPlacement, the instancing amounts are read back once the GPU is done
+//   -> swapPlacement makes the back buffers the drawn ones
 // 4. Issue draw calls in render loop
 class InstancingManager {
 public:
@@ -41,9 +44,50 @@ public:
         });
     }
 
-    void prepareAtomicCounterFetching() {
-        m_fenceHandle = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-        m_isComputeShaderDone = false;
+    // Starts placing a new set of instances into the back buffers
+    void beginPlacement() {
+        if (m_placementFence) {
+            glDeleteSync(m_placementFence);
+            m_placementFence = nullptr;
+        }
+
+        m_placementDone = false;
+        resetInstanceCountAtomics(getBackBuffer());
+        clearGridCellBuffer();
+    }
+
+    // Placement dispatches write the back buffers, draw calls rebind the front ones
+    void bindPlacementBuffers() const {
+        const int back = getBackBuffer();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBOHandles[back]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_SSBOHandleCellGrid);
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, m_atomicCounterBuffers[back]);
+    }
+
+    // Every chunk got dispatched
+    void endPlacement() {
+        m_placementFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // True once the GPU finished the placement and the instancing amounts got read back
+    bool isPlacementDone() {
+        if (!m_placementDone && m_placementFence && pollFenceState()) {
+            retrieveInstancingAmountsFromGPU();
+            m_placementDone = true;
+        }
+
+        return m_placementDone;
+    }
+
+    // Draws the placed instances from now on, expects isPlacementDone
+    void swapPlacement() {
+        m_frontBuffer = getBackBuffer();
+
+        for (size_t i = 0; i < m_instancedDrawCalls.size(); i++) {
+            m_instancedDrawCalls[i].instanceCount = m_instanceCounts[i];
+        }
+
+        m_placementDone = false;
     }
 
     // The SSBO will store instance data for each type of model in its own region inside the buffer
@@ -51,13 +95,15 @@ public:
     // Example structure: [InstanceData grass, InstanceData grass2, [OffsetSpace], InstanceData tree..]
     void initializeSSBOBuffers() {
         // This wastes memory on the GPU since we will never need that amount of memory but makes working with it easier
-        // Instancing data buffer
+        // Instancing data buffers, front and back
         GLuint bufferSize = m_totalVertexCount * m_instancedDrawCalls.size() * sizeof(InstancingData);
 
-        glGenBuffers(1, &m_SSBOHandle);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_SSBOHandle);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, GL_DYNAMIC_DRAW);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBOHandle);
+        glGenBuffers(2, m_SSBOHandles.data());
+        for (const GLuint SSBOHandle: m_SSBOHandles) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBOHandle);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBOHandles[m_frontBuffer]);
 
         // Grid cell buffer - Used to check if a cell is already in use
         m_totalCells = std::ceil(m_terrainSize / m_gridCellSize) * std::ceil(m_terrainSize / m_gridCellSize);
@@ -73,14 +119,16 @@ public:
     }
 
     void setupInstanceCountAtomics() {
-        glGenBuffers(1, &m_atomicCounterBuffer);
-        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_atomicCounterBuffer);
+        glGenBuffers(2, m_atomicCounterBuffers.data());
 
         m_instanceCounts.resize(m_instancedDrawCalls.size(), 0);
-        glBufferData(GL_ATOMIC_COUNTER_BUFFER, m_instanceCounts.size() * sizeof(GLuint), m_instanceCounts.data(),
-                     GL_DYNAMIC_DRAW);
+        for (const GLuint atomicCounterBuffer: m_atomicCounterBuffers) {
+            glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, atomicCounterBuffer);
+            glBufferData(GL_ATOMIC_COUNTER_BUFFER, m_instanceCounts.size() * sizeof(GLuint), m_instanceCounts.data(),
+                         GL_DYNAMIC_DRAW);
+        }
 
-        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, m_atomicCounterBuffer);
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, m_atomicCounterBuffers[m_frontBuffer]);
     }
 
     // Used to set the starting memory regions in the instancing SSBO for each model type
@@ -95,17 +143,10 @@ public:
     }
 
     void issueDrawCalls() {
-        if (!m_isComputeShaderDone) {
-            if (!pollFenceState()) {
-                return;
-            } else {
-                retrieveInstancingAmountsFromGPU();
-            }
-        }
-
-        clearGridCellBuffer();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBOHandles[m_frontBuffer]);
 
         BaseShaderProgram *currentShader = nullptr;
+
         for (const InstancedDrawCall &model: m_instancedDrawCalls) {
             // Avoid unnecessary rebindings
             if (!currentShader || currentShader->getProgramId() != model.shader->getProgramId()) {
@@ -117,22 +158,25 @@ public:
             currentShader->setInt("u_baseInstance", model.instanceDataElementOffset);
 
             for (const RenderCall &renderCall: model.modelRenderCalls) {
-                glBindVertexArray(renderCall.vao);
+                // Models share arena VAOs
+                VertexBindings::instance().bind(renderCall);
+
                 currentShader->preRender(renderCall);
 
                 // Resulted in a lot of headaches, baseInstance does not set the starting point of
                 // gl_InstanceID, it only sets gl_BaseInstance which is OpenGL 4.6+, passed as uniform instead
-                glDrawElementsInstancedBaseInstance(GL_TRIANGLES,
-                                                    renderCall.elemCount,
-                                                    renderCall.componentType,
-                                                    (void *) nullptr,
-                                                    model.instanceCount,
-                                                    model.instanceDataElementOffset
+                glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES,
+                                                              renderCall.elemCount,
+                                                              renderCall.componentType,
+                                                              renderCall.getIndexOffset(),
+                                                              model.instanceCount,
+                                                              renderCall.baseVertex,
+                                                              model.instanceDataElementOffset
                 );
-
-                glBindVertexArray(0);
             }
         }
+
+        VertexBindings::instance().unbind();
     }
 
 private:
@@ -150,36 +194,40 @@ private:
     };
 
     const ComputeShader &m_computeShader;
-    bool m_isComputeShaderDone;
-    GLsync m_fenceHandle;
-    GLuint m_atomicCounterBuffer;
-    std::vector<GLuint> m_instanceCounts;
+    GLsync m_placementFence{nullptr};
+    bool m_placementDone{false};
+    int m_frontBuffer{0};
+    std::array<GLuint, 2> m_atomicCounterBuffers{};
+    std::vector<GLuint> m_instanceCounts; // Of the last finished placement
     std::vector<InstancedDrawCall> m_instancedDrawCalls;
     uint m_gridCellSize;
     uint m_terrainSize;
     uint m_totalVertexCount;
     uint m_totalCells;
-    GLuint m_SSBOHandle;
+    std::array<GLuint, 2> m_SSBOHandles{};
     GLuint m_SSBOHandleCellGrid;
 
+    [[nodiscard]] int getBackBuffer() const {
+        return 1 - m_frontBuffer;
+    }
+
     bool pollFenceState() {
-        GLenum waitRet = glClientWaitSync(m_fenceHandle, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        GLenum waitRet = glClientWaitSync(m_placementFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
 
         if (waitRet == GL_ALREADY_SIGNALED || waitRet == GL_CONDITION_SATISFIED) {
             // Compute shader is done
-            m_isComputeShaderDone = true;
-            glDeleteSync(m_fenceHandle);
-            m_fenceHandle = nullptr;
+            glDeleteSync(m_placementFence);
+            m_placementFence = nullptr;
             return true;
         }
 
         return false;
     }
 
-    void resetInstanceCountAtomics() {
-        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_atomicCounterBuffer);
-        std::fill(m_instanceCounts.begin(), m_instanceCounts.end(), 0);
-        glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, m_instanceCounts.size() * sizeof(GLuint), m_instanceCounts.data());
+    void resetInstanceCountAtomics(const int buffer) const {
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_atomicCounterBuffers[buffer]);
+        const std::vector<GLuint> zeros(m_instancedDrawCalls.size(), 0);
+        glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, zeros.size() * sizeof(GLuint), zeros.data());
     }
 
     void clearGridCellBuffer() const {
@@ -188,17 +236,11 @@ private:
         glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_totalCells * sizeof(GLuint), initialCellBuffer.data());
     }
 
+    // Only after the placement fence signaled, the read doesn't stall then
     void retrieveInstancingAmountsFromGPU() {
-        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_atomicCounterBuffer);
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_atomicCounterBuffers[getBackBuffer()]);
         glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, m_instancedDrawCalls.size() * sizeof(GLuint),
                            m_instanceCounts.data());
-
-        // Update the instance counts for each draw call
-        for (size_t i = 0; i < m_instancedDrawCalls.size(); i++) {
-            m_instancedDrawCalls[i].instanceCount = m_instanceCounts[i];
-        }
-
-        resetInstanceCountAtomics();
     }
 };
 
@@ -4,6 +4,9 @@
 
 #ifndef PROJECT_H
 #define PROJECT_H
+#include <algorithm>
+#include <optional>
+
 #include "TerrainGenerator.h"
 #include "TerrainManager.h"
 #include "TerrainPatchLODGenerator.h"
@@ -12,8 +15,11 @@
 #include "../Renderer.h"
 #include "../RenderBase.h"
 #include "../RenderQueue.h"
+#include "../TextureStreamer.h"
 #include "../Shaders/SkyboxShader/SkyboxShaderProgram.h"
 #include "../Shaders/TerrainShader/TerrainShaderProgram.h"
+#include "../Shaders/TerrainCDLODShader/TerrainCDLODShaderProgram.h"
+#include "../Shaders/TerrainClipmapShader/TerrainClipmapShaderProgram.h"
 #include "../GPUModelUploader.h"
 #include "../Shaders/ModelShader/ModelShaderProgram.h"
 #include "../Shaders/GrassShaderInstanced/GrassShaderInstancedProgram.h"
@@ -30,18 +36,11 @@ public:
         // Skybox
         RenderEntity skybox = generateSkybox();
 
-        // Terrain - Water
-        geometry_utils::TriangulatedPlaneMesh waterMesh = geometry_utils::generateTriangulatedPlaneMesh(400, 2, true);
-        GLuint waterMeshVao = geometry_utils::uploadTriangulatedPlaneMeshToGPU(waterMesh);
-        RenderCall waterMeshRc = {
-            waterMeshVao, (GLuint) waterMesh.indices.size(), GL_UNSIGNED_INT,
-            {{TextureType::CUBE_MAP, m_skyboxHandle}}
-        };
+        // Terrain - Water, only drawn for underwater tiles of the terrain grid
+        m_terrainManager.setWaterEnvironmentMap(m_skyboxHandle);
 
-        GltfLoader loader{};
-        GltfScene suzanne = loader.loadModel("../assets/models/tv.glb");
-        GPUModelUploader uploader;
-        std::vector<RenderCall> suzanneCalls = uploader.uploadGltfModel(suzanne);
+        GPUModelUploader uploader{true};
+        std::vector<RenderCall> suzanneCalls = uploader.uploadModel("../assets/models/tv.glb");
 
         // Sun
         RenderEntity sun = generateSun();
@@ -51,20 +50,29 @@ public:
                 .addEntity("skybox", skybox)
                 .setShader(&m_sunShader)
                 .addEntity("sun", sun)
-                .setShader(&m_waterShader)
-                .addEntity("water", {waterMeshRc})
                 .setShader(&m_modelShader)
                 .addEntity("suzanne", {suzanneCalls});
         m_renderer.addRenderQueue(&m_renderQueue);
     }
 
     void render() override {
+        // Finish textures that got decoded since the last frame
+        TextureStreamer::instance().processUploads();
+        VertexBindings::instance().endFrame();
+
         GLint viewport[4];
         glGetIntegerv(GL_VIEWPORT, viewport);
         m_program.setVec2f("u_windowDimensions", glm::vec2(viewport[2], viewport[3]));
         float aspectRatio = static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]);
         glm::mat4 view = m_cam.getViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(m_cam.getFov()), aspectRatio, 0.1f, 500.0f);
+        // Clipmap and CDLOD reach kilometres further than the chunk grid
+        m_terrainManager.setBackend(static_cast<TerrainBackend>(m_terrainBackend));
+        m_terrainManager.setHeightQueryMode(static_cast<HeightQueryMode>(m_heightQueryMode));
+        m_terrainManager.setHeightSource(static_cast<TerrainHeightSource>(m_heightSource));
+        m_terrainManager.setGenerationBudget(m_generationBudgetMs);
+        const float farPlane = m_terrainManager.getViewDistance();
+        glm::mat4 projection = glm::perspective(glm::radians(m_cam.getFov()), aspectRatio, 0.1f, farPlane);
+        const float pixelsPerUnit = static_cast<float>(viewport[3]) / (2.0f * glm::tan(glm::radians(m_cam.getFov()) * 0.5f));
 
         const TerrainChunk &centerChunk = m_terrainManager.getTerrainChunk(2, 2);
         float angle = glm::radians(m_orbitangle);
@@ -116,10 +124,6 @@ public:
         m_waterShader.setMat4f("u_projection", projection);
         m_waterShader.setFloat("u_time", getElapsedTime());
         m_waterShader.setVec3f("u_camPos", m_cam.getCamPos());
-        m_waterShader.setFloat("u_scale", m_terrainScale);
-        m_waterShader.setFloat("u_persistance", m_terrainPersistence);
-        m_waterShader.setFloat("u_lucunarity", m_terrainLucunarity);
-        m_waterShader.setInt("u_octaves", m_terrainOctaves);
         m_waterShader.setVec3f("u_lightDirection", m_lightDirection);
         m_waterShader.setFloat("u_ambientIntensity", m_ambientIntensity);
         m_waterShader.setFloat("u_specularIntensity", m_specularIntensity);
@@ -162,13 +166,34 @@ public:
         m_terrainShader.setVec3f("u_cameraPos", m_cam.getCamPos());
         m_terrainShader.setFloat("u_ambientIntensity", m_ambientIntensity);
         m_terrainShader.setFloat("u_specularIntensity", m_specularIntensity);
+
+        glUseProgram(m_terrainClipmapShader.getProgramId());
+        m_terrainClipmapShader.setMat4f("u_view", view);
+        m_terrainClipmapShader.setMat4f("u_projection", projection);
+        m_terrainClipmapShader.setVec3f("u_lightDirection", m_lightDirection);
+        m_terrainClipmapShader.setVec3f("u_cameraPos", m_cam.getCamPos());
+        m_terrainClipmapShader.setFloat("u_ambientIntensity", m_ambientIntensity);
+        m_terrainClipmapShader.setFloat("u_specularIntensity", m_specularIntensity);
+
+        glUseProgram(m_terrainCDLODShader.getProgramId());
+        m_terrainCDLODShader.setMat4f("u_view", view);
+        m_terrainCDLODShader.setMat4f("u_projection", projection);
+        m_terrainCDLODShader.setVec3f("u_lightDirection", m_lightDirection);
+        m_terrainCDLODShader.setVec3f("u_cameraPos", m_cam.getCamPos());
+        m_terrainCDLODShader.setFloat("u_ambientIntensity", m_ambientIntensity);
+        m_terrainCDLODShader.setFloat("u_specularIntensity", m_specularIntensity);
+        m_terrainManager.setView(projection * view, pixelsPerUnit, m_cdlodTrianglePixels);
         m_terrainManager.update(m_cam.getCamPos());
 
+        m_renderer.setLodSelection(m_cam.getCamPos(), pixelsPerUnit, m_lodPixelError);
         m_renderer.renderAllQueues();
 
         float height = m_terrainManager.getHeight(m_cam.getCamPos());
         m_cam.updateHeight(height + 2.0f);
 
+        // Terrain under the crosshair, -1 if the view ray doesn't hit it
+        const TerrainRayHit &crosshairHit = updateCrosshairPick();
+
         ImGuiWindowCreator terrainWindow{"Terrain parameters"};
         terrainWindow
                 .slider("Terrain height", &m_terrainHeight, 10.0f, 200.0f)
@@ -176,7 +201,80 @@ public:
                 .slider("Persistance", &m_terrainPersistence, 0.1f, 1.0f)
                 .slider("Lucunarity", &m_terrainLucunarity, 1.0f, 10.0f)
                 .slider("Octaves", &m_terrainOctaves, 1, 10)
-                .slider("Light orbit angle", &m_orbitangle, 0.0f, 360.0f);
+                .slider("Light orbit angle", &m_orbitangle, 0.0f, 360.0f)
+                .slider("Model LOD error (px)", &m_lodPixelError, 0.1f, 10.0f)
+                .slider("Terrain backend (chunks, clipmap, CDLOD)", &m_terrainBackend, 0, 2)
+                .slider("CDLOD triangle size (px)", &m_cdlodTrianglePixels, 1.0f, 32.0f)
+                .slider("Height queries (exact, bilinear, bicubic)", &m_heightQueryMode, 0, 2)
+                .slider("Height source (noise, baked)", &m_heightSource, 0, 1)
+                .slider("Chunk generation budget (ms)", &m_generationBudgetMs, 0.25f, 16.0f)
+                .display("Terrain view distance", m_terrainManager.getViewDistance())
+                .display("Terrain distance (crosshair)", crosshairHit.hit ? crosshairHit.distance : -1.0f);
+
+        if (m_terrainManager.getBackend() == TerrainBackend::CLIPMAP) {
+            const TerrainClipmapStats &clipmapStats = m_terrainManager.getClipmap().getStats();
+            terrainWindow
+                    .display("Clipmap vertices", static_cast<int>(clipmapStats.vertexCount))
+                    .display("Clipmap draws", static_cast<int>(clipmapStats.drawCalls))
+                    .display("Clipmap texels updated", static_cast<int>(clipmapStats.updatedTexels));
+        } else if (m_terrainManager.getBackend() == TerrainBackend::CDLOD) {
+            const TerrainCDLODStats &cdlodStats = m_terrainManager.getCDLOD().getStats();
+            terrainWindow
+                    .display("CDLOD nodes", static_cast<int>(cdlodStats.selectedNodes))
+                    .display("CDLOD vertices", static_cast<int>(cdlodStats.vertexCount))
+                    .display("CDLOD resident roots", static_cast<int>(cdlodStats.residentRoots))
+                    .display("CDLOD pending roots", static_cast<int>(cdlodStats.pendingRoots));
+        }
+
+        const TerrainHeightCacheStats heightCacheStats = m_terrainManager.takeHeightCacheStats();
+        terrainWindow
+                .display("Height cache hits", static_cast<int>(heightCacheStats.hits))
+                .display("Height cache misses", static_cast<int>(heightCacheStats.misses))
+                .display("Height cache tiles", static_cast<int>(heightCacheStats.residentTiles));
+
+        const TerrainChunkPoolStats &chunkPoolStats = m_terrainManager.getChunkPoolStats();
+        terrainWindow
+                .display("Chunk pool hits", static_cast<int>(chunkPoolStats.hits))
+                .display("Chunk pool misses", static_cast<int>(chunkPoolStats.misses))
+                .display("Chunk pool evictions", static_cast<int>(chunkPoolStats.evictions))
+                .display("Chunks prefetched", static_cast<int>(m_terrainManager.getPrefetchedChunkCount()))
+                .display("Recenter pending", static_cast<int>(m_terrainManager.isRecenterPending()))
+                .display("LOD 0 chunk estimate (ms)", m_terrainManager.getGenerationBudget().getEstimatedMs(0))
+                .display("Last chunk GPU time (ms)", m_terrainManager.getGenerationBudget().getLastMeasuredMs());
+
+        const ChunkDiskCacheStats chunkCacheStats = m_terrainManager.getChunkDiskCacheStats();
+        terrainWindow
+                .display("Chunk disk cache hits", static_cast<int>(chunkCacheStats.hits))
+                .display("Chunk disk cache misses", static_cast<int>(chunkCacheStats.misses))
+                .display("Chunk disk cache (MB)", static_cast<float>(chunkCacheStats.bytes) / (1024.0f * 1024.0f));
+
+        const WaterLODStats &waterStats = m_terrainManager.getWaterSurface().getStats();
+        terrainWindow
+                .display("Water tiles", static_cast<int>(waterStats.tileCount))
+                .display("Water vertices", static_cast<int>(waterStats.vertexCount))
+                .display("Water triangles", static_cast<int>(waterStats.triangleCount));
+
+        const TextureCacheStats &textureStats = TextureCache::instance().getStats();
+        terrainWindow
+                .display("Model textures", static_cast<int>(textureStats.uniqueTextures))
+                .display("Texture cache hits", static_cast<int>(textureStats.hits))
+                .display("Texture VRAM (MB)", static_cast<float>(textureStats.vramBytes) / (1024.0f * 1024.0f))
+                .display("Texture VRAM saved (MB)", static_cast<float>(textureStats.vramBytesSaved) / (1024.0f * 1024.0f))
+                .display("Texture upload saved (ms)", textureStats.uploadMsSaved);
+
+        const VertexBindingStats &bindingStats = VertexBindings::instance().getLastFrameStats();
+        terrainWindow
+                .display("Model draws", static_cast<int>(bindingStats.draws))
+                .display("VAO binds", static_cast<int>(bindingStats.vaoBinds))
+                .display("Vertex buffer binds", static_cast<int>(bindingStats.vertexBufferBinds));
+
+        const GeometryArenaStats geometryStats = GeometryArena::instance().getStats();
+        terrainWindow
+                .display("Vertex formats", static_cast<int>(geometryStats.formatCount))
+                .display("Geometry pools", static_cast<int>(geometryStats.poolCount))
+                .display("Geometry meshes", static_cast<int>(geometryStats.allocationCount))
+                .display("Geometry used (MB)", static_cast<float>(geometryStats.vertexBytesUsed + geometryStats.indexBytesUsed) / (1024.0f * 1024.0f))
+                .display("Geometry reserved (MB)", static_cast<float>(geometryStats.vertexBytesCapacity + geometryStats.indexBytesCapacity) / (1024.0f * 1024.0f));
 
         if (ImGui::Button("Toggle Wireframe")) {
             toggleTerrainWireframe();
@@ -197,6 +295,8 @@ private:
     TreeShaderInstancedProgram m_treeShaderInstanced;
     SkyboxShaderProgram m_skyboxShader;
     TerrainShaderProgram m_terrainShader;
+    TerrainClipmapShaderProgram m_terrainClipmapShader;
+    TerrainCDLODShaderProgram m_terrainCDLODShader;
     WaterShaderProgram m_waterShader;
     SunShaderProgram m_sunShader;
 
@@ -205,16 +305,34 @@ private:
     float m_ambientIntensity = 0.3f;
     float m_specularIntensity = 64.0f;
     float m_orbitangle = 0.0f;
+    float m_lodPixelError = 1.0f;
+
+    // Last crosshair raycast, only repeated once the ray or the surface changed
+    struct CrosshairPick {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        TerrainNoiseParams params;
+        TerrainHeightSource heightSource;
+        TerrainRayHit hit;
+    };
+
+    static constexpr float CROSSHAIR_PICK_DISTANCE = 500.0f; // Further hits aren't worth the marching steps
+    std::optional<CrosshairPick> m_crosshairPick;
 
     // Terrain
     bool m_terrainWireframe{false};
+    int m_terrainBackend{0}; // TerrainBackend
+    int m_heightQueryMode{1}; // HeightQueryMode
+    int m_heightSource{0}; // TerrainHeightSource, stays on the noise without a baked heightmap
+    float m_cdlodTrianglePixels{8.0f};
+    float m_generationBudgetMs{2.0f};
     float m_terrainHeight{30.0f};
     float m_terrainScale{300.0f};
     float m_terrainPersistence{0.244f};
     float m_terrainLucunarity{10.0f};
     int m_terrainOctaves{4};
     TerrainManager m_terrainManager{
-        256, m_terrainShader, m_GrassShaderInstanced, m_treeShaderInstanced, m_terrainHeight, m_terrainOctaves, m_terrainScale, m_terrainPersistence,
+        256, m_terrainShader, m_terrainClipmapShader, m_terrainCDLODShader, m_GrassShaderInstanced, m_treeShaderInstanced, m_waterShader, m_terrainHeight, m_terrainOctaves, m_terrainScale, m_terrainPersistence,
         m_terrainLucunarity
     };
 
@@ -228,6 +346,24 @@ private:
         }
     }
 
+    const TerrainRayHit &updateCrosshairPick() {
+        const glm::vec3 origin = m_cam.getCamPos();
+        const glm::vec3 direction = m_cam.getFront();
+        const TerrainNoiseParams &params = m_terrainManager.getRaycastParams();
+        const TerrainHeightSource heightSource = m_terrainManager.getHeightSource();
+
+        if (m_crosshairPick && m_crosshairPick->origin == origin && m_crosshairPick->direction == direction &&
+            m_crosshairPick->params == params && m_crosshairPick->heightSource == heightSource) {
+            return m_crosshairPick->hit;
+        }
+
+        const float pickDistance = std::min(CROSSHAIR_PICK_DISTANCE, m_terrainManager.getViewDistance());
+        const TerrainRayHit hit = m_terrainManager.raycast({origin, direction, pickDistance});
+        m_crosshairPick = CrosshairPick{origin, direction, params, heightSource, hit};
+
+        return m_crosshairPick->hit;
+    }
+
     // Used to setup base uniforms common in majority of shaders
     // Most for projection, lighting
     void setBaseUniforms(BaseShaderProgram const *shader, float aspectRatio, const glm::mat4 &view,
@@ -284,14 +420,12 @@ private:
             IndexBufferArray{spherePrimitive.ebo}
         );
 
-        ImageData sunImg = opengl_utils::loadImage("../assets/textures/sun.jpg");
-        TextureHandle sunTex = opengl_utils::createTexture(sunImg, false);
-        opengl_utils::updateTextureData(sunTex, sunImg);
+        std::shared_ptr<TextureHandle> sunTex = TextureStreamer::instance().requestTexture("../assets/textures/sun.jpg");
 
         RenderEntity sun = {
             RenderCall {
                 sphereHandle.id, sphereHandle.elemenCount, GL_UNSIGNED_INT,
-                { { TextureType::DIFFUSE, sunTex.handle }}
+                { { TextureType::DIFFUSE, sunTex->handle }}
             }
         };
 
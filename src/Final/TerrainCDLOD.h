@@ -0,0 +1,382 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINCDLOD_H
+#define TERRAINCDLOD_H
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "HeightPyramid.h"
+#include "TerrainNoise.h"
+#include "../ThreadPool.h"
+#include "../Shaders/TerrainCDLODShader/TerrainCDLODShaderProgram.h"
+
+struct TerrainCDLODStats {
+    GLuint selectedNodes;
+    GLuint vertexCount;
+    GLuint residentRoots;
+    GLuint pendingRoots;
+};
+
+// Alternative terrain backend, continuous distance-dependent LOD (CDLOD)
+// Flow
+// 1. The world is split into root tiles, every root is a quadtree down to LEAF_SIZE nodes
+//   -> A min/max height pyramid per root gets sampled on the worker pool the first time it comes into range
+// 2. Each frame nodes are selected top down, a node gets refined while its bounds intersect the range of the next finer LOD
+//   -> LOD ranges double per level, the base range follows the wanted on screen triangle size
+//   -> Children that are out of range are drawn as a quarter of their parent
+// 3. Every selected node draws the same grid patch, scaled to its size
+//   -> Heights come from the noise in the vertex shader, odd vertices morph onto the coarser grid towards the end
+//      of each range, so neighbouring LODs always meet without cracks or popping
+class TerrainCDLOD {
+public:
+    static constexpr int LOD_COUNT = 6;
+    static constexpr int LEAF_SIZE = 32; // World units
+    static constexpr int PATCH_RESOLUTION = 32; // Quads per patch side, LOD 0 has a spacing of 1
+    static constexpr int ROOT_SIZE = LEAF_SIZE << (LOD_COUNT - 1);
+    static constexpr int HEIGHT_SAMPLE_SPACING = 8; // Spacing of the bound samples, a leaf spans 4x4 cells
+    static constexpr float MORPH_START = 0.7f; // Morphing covers the last 30% of a range
+
+    explicit TerrainCDLOD(TerrainCDLODShaderProgram &shader) : m_shader(shader) {
+        createPatchMesh();
+    }
+
+    // trianglePixels is the wanted screen size of a patch quad, pixelsPerUnit as in Renderer::setLodSelection
+    void setView(const glm::mat4 &viewProjection, float pixelsPerUnit, float trianglePixels) {
+        m_frustum = extractFrustum(viewProjection);
+
+        // Ranges have to stay well above the node size, otherwise morphing can't finish before the next LOD starts
+        const float screenRange = pixelsPerUnit * (static_cast<float>(LEAF_SIZE) / PATCH_RESOLUTION) / trianglePixels;
+        m_ranges[0] = std::max(screenRange, 2.5f * LEAF_SIZE);
+
+        for (int lod = 1; lod < LOD_COUNT; lod++) {
+            m_ranges[lod] = m_ranges[lod - 1] * 2.0f;
+        }
+    }
+
+    // Selects the nodes for this frame, bounds of roots that came into range are requested in the background
+    void update(const glm::vec3 &camPos, const TerrainNoiseParams &params) {
+        if (params != m_params) {
+            // Pending tasks still finish, their results are dropped together with the futures
+            m_roots.clear();
+            m_params = params;
+            m_heightRange = TerrainNoise::getHeightRange(params);
+            // Every point of a cell lies within half a diagonal of one of its samples
+            m_boundsMargin = TerrainNoise::getMaxSlope(params) * HEIGHT_SAMPLE_SPACING * 0.5f * std::sqrt(2.0f);
+        }
+
+        m_camPos = camPos;
+        m_selection.clear();
+        m_stats.vertexCount = 0;
+
+        const float viewDistance = getViewDistance();
+        const glm::ivec2 rootMin = {
+            static_cast<int>(std::floor((camPos.x - viewDistance) / ROOT_SIZE)),
+            static_cast<int>(std::floor((camPos.z - viewDistance) / ROOT_SIZE))
+        };
+        const glm::ivec2 rootMax = {
+            static_cast<int>(std::floor((camPos.x + viewDistance) / ROOT_SIZE)),
+            static_cast<int>(std::floor((camPos.z + viewDistance) / ROOT_SIZE))
+        };
+
+        evictRoots(rootMin, rootMax);
+
+        for (int rootZ = rootMin.y; rootZ <= rootMax.y; rootZ++) {
+            for (int rootX = rootMin.x; rootX <= rootMax.x; rootX++) {
+                RootTile &root = acquireRoot({rootX, rootZ});
+                selectNode(root, LOD_COUNT - 1, {0, 0});
+            }
+        }
+
+        m_stats.selectedNodes = static_cast<GLuint>(m_selection.size());
+        m_stats.residentRoots = 0;
+        m_stats.pendingRoots = 0;
+        for (const auto &[key, root] : m_roots) {
+            root.pyramid.isEmpty() ? m_stats.pendingRoots++ : m_stats.residentRoots++;
+        }
+    }
+
+    // Expects the terrain layer textures on units 0 and 1
+    void render() {
+        m_shader.use();
+        m_shader.setFloat("u_terrainHeight", m_params.terrainHeight);
+        m_shader.setFloat("u_scale", m_params.scale);
+        m_shader.setFloat("u_persistance", m_params.persistance);
+        m_shader.setFloat("u_lucunarity", m_params.lucunarity);
+        m_shader.setInt("u_octaves", m_params.octaves);
+        m_shader.setFloat("u_patchResolution", static_cast<float>(PATCH_RESOLUTION));
+
+        glBindVertexArray(m_VAO);
+
+        for (const SelectedNode &node : m_selection) {
+            const float previousRange = node.lod > 0 ? m_ranges[node.lod - 1] : 0.0f;
+            const float morphStart = previousRange + (m_ranges[node.lod] - previousRange) * MORPH_START;
+
+            m_shader.setVec2f("u_nodeOrigin", node.origin);
+            m_shader.setFloat("u_nodeSize", node.size);
+            m_shader.setVec2f("u_morphRange", {morphStart, m_ranges[node.lod]});
+
+            // Quadrants are stored one after another, a whole node draws all 4
+            const GLuint firstIndex = node.quadrant < 0 ? 0 : node.quadrant * m_quadrantIndexCount;
+            const GLuint indexCount = node.quadrant < 0 ? 4 * m_quadrantIndexCount : m_quadrantIndexCount;
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void *) (firstIndex * sizeof(GLuint)));
+        }
+
+        // Cleanup
+        glBindVertexArray(0);
+    }
+
+    [[nodiscard]] float getViewDistance() const {
+        return m_ranges[LOD_COUNT - 1];
+    }
+
+    [[nodiscard]] const TerrainCDLODStats &getStats() const {
+        return m_stats;
+    }
+
+    [[nodiscard]] TerrainCDLODShaderProgram &getShader() const {
+        return m_shader;
+    }
+
+private:
+    struct RootTile {
+        glm::ivec2 coord;
+        std::future<HeightPyramid> pending;
+        HeightPyramid pyramid; // Empty until the worker finished, worst case bounds are used until then
+    };
+
+    struct SelectedNode {
+        glm::vec2 origin;
+        float size;
+        int lod;
+        int quadrant; // -1 for the whole node
+    };
+
+    struct Plane {
+        glm::vec3 normal;
+        float distance;
+    };
+
+    TerrainCDLODShaderProgram &m_shader;
+    GLuint m_VAO;
+    GLuint m_quadrantIndexCount{0};
+
+    TerrainNoiseParams m_params{0.0f, 0, 0.0f, 0.0f, 0.0f};
+    HeightBounds m_heightRange{0.0f, 0.0f}; // Everything the noise can reach
+    float m_boundsMargin{0.0f}; // Lipschitz margin for the surface between bound samples
+    glm::vec3 m_camPos{0.0f};
+    std::array<float, LOD_COUNT> m_ranges{};
+    std::array<Plane, 6> m_frustum{};
+    std::unordered_map<std::uint64_t, RootTile> m_roots;
+    std::vector<SelectedNode> m_selection;
+    TerrainCDLODStats m_stats{0, 0, 0, 0};
+
+    static std::uint64_t rootKey(const glm::ivec2 &coord) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) << 32) |
+               static_cast<std::uint32_t>(coord.y);
+    }
+
+    RootTile &acquireRoot(const glm::ivec2 &coord) {
+        auto [it, inserted] = m_roots.try_emplace(rootKey(coord));
+        RootTile &root = it->second;
+
+        if (inserted) {
+            root.coord = coord;
+            root.pending = ThreadPool::decodePool().submit([params = m_params, coord] {
+                return buildPyramid(params, coord);
+            });
+        } else if (root.pending.valid() &&
+                   root.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            root.pyramid = root.pending.get();
+        }
+
+        return root;
+    }
+
+    void evictRoots(const glm::ivec2 &rootMin, const glm::ivec2 &rootMax) {
+        // One root of slack, turning around at a border shouldn't resample
+        for (auto it = m_roots.begin(); it != m_roots.end();) {
+            const glm::ivec2 &coord = it->second.coord;
+            const bool inRange = coord.x >= rootMin.x - 1 && coord.x <= rootMax.x + 1 &&
+                                 coord.y >= rootMin.y - 1 && coord.y <= rootMax.y + 1;
+            it = inRange ? std::next(it) : m_roots.erase(it);
+        }
+    }
+
+    static HeightPyramid buildPyramid(const TerrainNoiseParams &params, const glm::ivec2 &coord) {
+        const int cellCount = ROOT_SIZE / HEIGHT_SAMPLE_SPACING;
+        const glm::vec2 origin = glm::vec2(coord * ROOT_SIZE);
+
+        std::vector<float> samples;
+        samples.reserve((cellCount + 1) * (cellCount + 1));
+
+        for (int z = 0; z <= cellCount; z++) {
+            for (int x = 0; x <= cellCount; x++) {
+                const glm::vec2 xzPos = origin + glm::vec2(x, z) * static_cast<float>(HEIGHT_SAMPLE_SPACING);
+                samples.push_back(TerrainNoise::getHeight(params, xzPos));
+            }
+        }
+
+        return HeightPyramid{samples, cellCount};
+    }
+
+    [[nodiscard]] HeightBounds getNodeBounds(const RootTile &root, const int lod, const glm::ivec2 &node) const {
+        if (root.pyramid.isEmpty()) {
+            return m_heightRange;
+        }
+
+        // Leaves span LEAF_SIZE / HEIGHT_SAMPLE_SPACING cells, every LOD is one pyramid level up
+        const int leafLevel = static_cast<int>(std::log2(LEAF_SIZE / HEIGHT_SAMPLE_SPACING));
+        const HeightBounds bounds = root.pyramid.getBounds(leafLevel + lod, node.x, node.y);
+
+        return {
+            std::max(bounds.min - m_boundsMargin, m_heightRange.min),
+            std::min(bounds.max + m_boundsMargin, m_heightRange.max)
+        };
+    }
+
+    // Returns false if the node is out of its LOD range, the parent covers the area then
+    bool selectNode(const RootTile &root, const int lod, const glm::ivec2 &node) {
+        const float size = static_cast<float>(LEAF_SIZE << lod);
+        const glm::vec2 origin = glm::vec2(root.coord * ROOT_SIZE) + glm::vec2(node) * size;
+        const HeightBounds bounds = getNodeBounds(root, lod, node);
+
+        const glm::vec3 boxMin = {origin.x, bounds.min, origin.y};
+        const glm::vec3 boxMax = {origin.x + size, bounds.max, origin.y + size};
+
+        if (!intersectsSphere(boxMin, boxMax, m_ranges[lod])) {
+            return false;
+        }
+
+        // Handled, just not visible
+        if (!intersectsFrustum(boxMin, boxMax)) {
+            return true;
+        }
+
+        if (lod == 0 || !intersectsSphere(boxMin, boxMax, m_ranges[lod - 1])) {
+            addSelection({origin, size, lod, -1});
+            return true;
+        }
+
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            const glm::ivec2 child = node * 2 + glm::ivec2{quadrant & 1, quadrant >> 1};
+
+            if (!selectNode(root, lod - 1, child)) {
+                addSelection({origin, size, lod, quadrant});
+            }
+        }
+
+        return true;
+    }
+
+    void addSelection(const SelectedNode &node) {
+        const GLuint quadrantVertices = (PATCH_RESOLUTION / 2 + 1) * (PATCH_RESOLUTION / 2 + 1);
+        m_stats.vertexCount += node.quadrant < 0 ? (PATCH_RESOLUTION + 1) * (PATCH_RESOLUTION + 1) : quadrantVertices;
+        m_selection.push_back(node);
+    }
+
+    [[nodiscard]] bool intersectsSphere(const glm::vec3 &boxMin, const glm::vec3 &boxMax, float radius) const {
+        const glm::vec3 closest = glm::clamp(m_camPos, boxMin, boxMax);
+        const glm::vec3 delta = closest - m_camPos;
+
+        return glm::dot(delta, delta) <= radius * radius;
+    }
+
+    [[nodiscard]] bool intersectsFrustum(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const {
+        for (const Plane &plane : m_frustum) {
+            // Corner furthest along the plane normal
+            const glm::vec3 positive = {
+                plane.normal.x >= 0.0f ? boxMax.x : boxMin.x,
+                plane.normal.y >= 0.0f ? boxMax.y : boxMin.y,
+                plane.normal.z >= 0.0f ? boxMax.z : boxMin.z
+            };
+
+            if (glm::dot(plane.normal, positive) + plane.distance < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Planes point inwards
+    static std::array<Plane, 6> extractFrustum(const glm::mat4 &viewProjection) {
+        const glm::mat4 m = glm::transpose(viewProjection);
+        const std::array<glm::vec4, 6> rows = {
+            m[3] + m[0], m[3] - m[0], // Left, right
+            m[3] + m[1], m[3] - m[1], // Bottom, top
+            m[3] + m[2], m[3] - m[2] // Near, far
+        };
+
+        std::array<Plane, 6> planes{};
+        for (std::size_t i = 0; i < rows.size(); i++) {
+            const float length = glm::length(glm::vec3(rows[i]));
+            planes[i] = {glm::vec3(rows[i]) / length, rows[i].w / length};
+        }
+
+        return planes;
+    }
+
+    // One patch for every node, indices are sorted by quadrant so parts of a node can be drawn on their own
+    void createPatchMesh() {
+        const int vertexRow = PATCH_RESOLUTION + 1;
+        const int half = PATCH_RESOLUTION / 2;
+
+        std::vector<GLfloat> vertices;
+        for (int z = 0; z <= PATCH_RESOLUTION; z++) {
+            for (int x = 0; x <= PATCH_RESOLUTION; x++) {
+                vertices.push_back(static_cast<GLfloat>(x));
+                vertices.push_back(static_cast<GLfloat>(z));
+            }
+        }
+
+        std::vector<GLuint> indices;
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            const int startX = (quadrant & 1) * half;
+            const int startZ = (quadrant >> 1) * half;
+
+            for (int z = startZ; z < startZ + half; z++) {
+                for (int x = startX; x < startX + half; x++) {
+                    const GLuint topLeft = z * vertexRow + x;
+                    const GLuint topRight = topLeft + 1;
+                    const GLuint bottomLeft = topLeft + vertexRow;
+                    const GLuint bottomRight = bottomLeft + 1;
+
+                    indices.insert(indices.end(), {bottomLeft, bottomRight, topRight});
+                    indices.insert(indices.end(), {bottomLeft, topRight, topLeft});
+                }
+            }
+        }
+
+        m_quadrantIndexCount = static_cast<GLuint>(indices.size() / 4);
+
+        GLuint VBO, EBO;
+        glGenVertexArrays(1, &m_VAO);
+        glBindVertexArray(m_VAO);
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+        // XZ Coord in patch units
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void *) nullptr);
+        glEnableVertexAttribArray(0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+#endif //TERRAINCDLOD_H
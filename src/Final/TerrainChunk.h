@@ -6,6 +6,7 @@
 #define TERRAINCHUNK_H
 #include <glm/glm.hpp>
 
+#include "HeightPyramid.h"
 #include "TerrainPatchLODGenerator.h"
 #include "../Shaders/TerrainShader/TerrainShaderProgram.h"
 
@@ -17,17 +18,22 @@ public:
     // Bottom left corner of the chunk
     glm::vec2 localGridPos;
     MeshBufferPosition bufferPos;
+    GLuint dataOffset; // First vertex of the chunk in the TerrainChunkPool SSBO
 
     float gridSpacing;
     GLuint indexBufferOffset;
     GLuint drawCount;
 
+    // Min/max of the generated vertex heights, empty until read back from the GPU
+    HeightPyramid heightPyramid;
+
     void render(const TerrainShaderProgram &shader) const {
         glm::mat4 model = glm::mat4{1.0f};
         model = glm::translate(model, glm::vec3(globalPos.x, 0.0f, globalPos.y));
 
         shader.setMat4f("u_model", model);
         shader.setVec2f("u_chunkOffset", globalPos);
+        shader.setInt("u_dataOffset", static_cast<GLint>(dataOffset) - static_cast<GLint>(bufferPos.vertexOffset));
         glDrawElements(GL_TRIANGLES, bufferPos.indexCount, GL_UNSIGNED_INT, (void*)(bufferPos.indexOffset * sizeof(GLuint)));
     }
 };
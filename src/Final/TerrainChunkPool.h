@@ -0,0 +1,163 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINCHUNKPOOL_H
+#define TERRAINCHUNKPOOL_H
+#include <cstdint>
+#include <vector>
+
+#include "TerrainPatchLODGenerator.h"
+#include "glad/glad.h"
+
+struct TerrainChunkPoolStats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+};
+
+// Generated chunk vertices in fixed size slots of one SSBO, keyed by ChunkCacheKey::hash
+// Chunks drawn by the grid only point at their slot, so moving back to an earlier grid position
+// finds its chunks still resident instead of generating them again
+// Flow
+// 1. beginGeneration on every frame and grid rebuild, touch everything that has to stay resident
+// 2. find all chunks of the new grid first, so acquire never evicts one of them
+// 3. acquire slots for the rest, least recently used slots get reused
+class TerrainChunkPool {
+public:
+    static constexpr int SLOT_COUNT = 64; // Two full 5x5 grids with room to spare
+
+    explicit TerrainChunkPool(const GLuint slotVertexCount) : m_slotVertexCount(slotVertexCount),
+                                                              m_slots(SLOT_COUNT) {
+        glGenBuffers(1, &m_SSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_SSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, SLOT_COUNT * m_slotVertexCount * sizeof(TerrainVertexData), nullptr,
+                     GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~TerrainChunkPool() {
+        glDeleteBuffers(1, &m_SSBO);
+    }
+
+    TerrainChunkPool(const TerrainChunkPool &) = delete;
+    TerrainChunkPool &operator=(const TerrainChunkPool &) = delete;
+
+    void beginGeneration() {
+        m_generation++;
+    }
+
+    // Slot holding the chunk or -1, a found slot is protected from eviction until the next generation
+    int find(const std::uint64_t keyHash) {
+        for (int slot = 0; slot < SLOT_COUNT; slot++) {
+            if (m_slots[slot].valid && m_slots[slot].keyHash == keyHash) {
+                m_slots[slot].lastUse = m_generation;
+                m_stats.hits++;
+                return slot;
+            }
+        }
+
+        m_stats.misses++;
+        return -1;
+    }
+
+    // Like find without counting, for chunks that are not drawn yet
+    int touch(const std::uint64_t keyHash) {
+        const int slot = peek(keyHash);
+
+        if (slot >= 0) {
+            m_slots[slot].lastUse = m_generation;
+        }
+
+        return slot;
+    }
+
+    // Protects a slot by index, for chunks whose key is no longer current
+    void touchSlot(const int slot) {
+        m_slots[slot].lastUse = m_generation;
+    }
+
+    // Slot holding the chunk or -1, without affecting the eviction order
+    [[nodiscard]] int peek(const std::uint64_t keyHash) const {
+        for (int slot = 0; slot < SLOT_COUNT; slot++) {
+            if (m_slots[slot].valid && m_slots[slot].keyHash == keyHash) {
+                return slot;
+            }
+        }
+
+        return -1;
+    }
+
+    // Takes over the least recently used slot not in use by the current generation, its contents are undefined
+    // -1 if every slot is in use, can't happen for the grid itself right after beginGeneration
+    int acquire(const std::uint64_t keyHash) {
+        int oldest = -1;
+        for (int slot = 0; slot < SLOT_COUNT; slot++) {
+            const Slot &candidate = m_slots[slot];
+
+            if (candidate.lastUse == m_generation && candidate.valid) {
+                continue;
+            }
+
+            if (oldest < 0 || !candidate.valid || (m_slots[oldest].valid && candidate.lastUse < m_slots[oldest].lastUse)) {
+                oldest = slot;
+            }
+        }
+
+        if (oldest < 0) {
+            return -1;
+        }
+
+        Slot &slot = m_slots[oldest];
+        m_stats.evictions += slot.valid;
+        slot = {keyHash, true, m_generation, {}};
+        return oldest;
+    }
+
+    // Ordered min/max bits per bounds cell, dropped if the slot got reused in the meantime
+    bool setBounds(const int slot, const std::uint64_t keyHash, std::vector<GLuint> bounds) {
+        if (!m_slots[slot].valid || m_slots[slot].keyHash != keyHash) {
+            return false;
+        }
+
+        m_slots[slot].bounds = std::move(bounds);
+        return true;
+    }
+
+    // Empty until the chunk got read back
+    [[nodiscard]] const std::vector<GLuint> &getBounds(const int slot) const {
+        return m_slots[slot].bounds;
+    }
+
+    [[nodiscard]] GLuint getVertexOffset(const int slot) const {
+        return slot * m_slotVertexCount;
+    }
+
+    [[nodiscard]] GLuint getSlotVertexCount() const {
+        return m_slotVertexCount;
+    }
+
+    [[nodiscard]] GLuint getBuffer() const {
+        return m_SSBO;
+    }
+
+    [[nodiscard]] const TerrainChunkPoolStats &getStats() const {
+        return m_stats;
+    }
+
+private:
+    struct Slot {
+        std::uint64_t keyHash;
+        bool valid;
+        std::uint64_t lastUse;
+        std::vector<GLuint> bounds;
+    };
+
+    GLuint m_slotVertexCount;
+    GLuint m_SSBO{0};
+    std::vector<Slot> m_slots;
+    std::uint64_t m_generation{0};
+    TerrainChunkPoolStats m_stats{0, 0, 0};
+};
+
+#endif //TERRAINCHUNKPOOL_H
@@ -0,0 +1,240 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINCLIPMAP_H
+#define TERRAINCLIPMAP_H
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <glm/glm.hpp>
+
+#include "ClipmapMeshGenerator.h"
+#include "TerrainNoise.h"
+#include "../ComputeShader.h"
+#include "../Shaders/TerrainClipmapShader/TerrainClipmapShaderProgram.h"
+
+struct TerrainClipmapStats {
+    GLuint updatedTexels; // Last update
+    GLuint vertexCount;
+    GLuint drawCalls;
+};
+
+// Alternative terrain backend based on geometry clipmaps
+// Flow
+// 1. Every level keeps a TEXTURE_SIZE^2 window of heights around the camera in one layer of a R32F texture array
+//   -> Level l has a texel spacing of 2^l world units, texels are addressed modulo TEXTURE_SIZE (toroidally)
+// 2. Once the camera moves, the window of a level only moves by whole texels
+//   -> Just the newly exposed L-shaped strips get recomputed, the rest of the texture stays in place
+// 3. The same few meshes are drawn for every level, the vertex shader fetches heights and normals
+//   -> Vertex count is independent of the view distance, each level doubles it
+class TerrainClipmap {
+public:
+    static constexpr int LEVEL_COUNT = 6;
+    static constexpr int TEXTURE_SIZE = 256; // Power of two, leaves room for the trims and normal fetches
+    static constexpr int BLOCK_SIZE = 60; // Level is 4 * BLOCK_SIZE + 1 quads wide
+
+    explicit TerrainClipmap(TerrainClipmapShaderProgram &shader)
+        : m_shader(shader),
+          m_updateComputeShader{"../src/Shaders/TerrainClipmapShader/shader.compute"} {
+        createMeshes();
+        createHeightTexture();
+    }
+
+    // Recomputes the strips of every level that moved, or all levels if the terrain parameters changed
+    void update(const glm::vec3 &camPos, const TerrainNoiseParams &params) {
+        const bool parametersChanged = params != m_params;
+        m_params = params;
+        m_stats.updatedTexels = 0;
+
+        glUseProgram(m_updateComputeShader.getProgramId());
+        m_updateComputeShader.setFloat("u_terrainHeight", params.terrainHeight);
+        m_updateComputeShader.setFloat("u_scale", params.scale);
+        m_updateComputeShader.setFloat("u_persistance", params.persistance);
+        m_updateComputeShader.setFloat("u_lucunarity", params.lucunarity);
+        m_updateComputeShader.setInt("u_octaves", params.octaves);
+        m_updateComputeShader.setInt("u_textureSize", TEXTURE_SIZE);
+
+        glBindImageTexture(1, m_heightTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        for (int level = 0; level < LEVEL_COUNT; level++) {
+            ClipmapLevel &clipmapLevel = m_levels[level];
+            const int spacing = 1 << level;
+
+            const glm::ivec2 center = {
+                static_cast<int>(std::floor(camPos.x / static_cast<float>(spacing))),
+                static_cast<int>(std::floor(camPos.z / static_cast<float>(spacing)))
+            };
+            const glm::ivec2 origin = center - TEXTURE_SIZE / 2;
+            const glm::ivec2 delta = origin - clipmapLevel.origin;
+
+            m_updateComputeShader.setInt("u_level", level);
+            m_updateComputeShader.setInt("u_spacing", spacing);
+
+            if (!clipmapLevel.valid || parametersChanged ||
+                std::abs(delta.x) >= TEXTURE_SIZE || std::abs(delta.y) >= TEXTURE_SIZE) {
+                updateRegion(origin, glm::ivec2{TEXTURE_SIZE});
+            } else if (delta != glm::ivec2{0}) {
+                // Columns that entered the window, over its full height
+                const int columnStart = delta.x > 0 ? clipmapLevel.origin.x + TEXTURE_SIZE : origin.x;
+                updateRegion({columnStart, origin.y}, {std::abs(delta.x), TEXTURE_SIZE});
+
+                // Rows that entered the window, without the columns done above
+                const int rowStart = delta.y > 0 ? clipmapLevel.origin.y + TEXTURE_SIZE : origin.y;
+                const int keptStart = std::max(origin.x, clipmapLevel.origin.x);
+                updateRegion({keptStart, rowStart}, {TEXTURE_SIZE - std::abs(delta.x), std::abs(delta.y)});
+            }
+
+            clipmapLevel.center = center;
+            clipmapLevel.origin = origin;
+            clipmapLevel.valid = true;
+        }
+
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        // Unbind
+        glBindImageTexture(1, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+    }
+
+    // Expects the terrain layer textures on units 0 and 1
+    void render() {
+        m_shader.use();
+        m_shader.setInt("u_textureSize", TEXTURE_SIZE);
+        m_shader.setFloat("u_terrainHeight", m_params.terrainHeight);
+
+        m_shader.setInt("u_heightmap", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_heightTexture);
+
+        glBindVertexArray(m_VAO);
+        m_stats.vertexCount = 0;
+        m_stats.drawCalls = 0;
+
+        for (int level = 0; level < LEVEL_COUNT; level++) {
+            const ClipmapLevel &clipmapLevel = m_levels[level];
+            const int spacing = 1 << level;
+
+            m_shader.setInt("u_level", level);
+            m_shader.setInt("u_spacing", spacing);
+
+            // The level grid starts 2 blocks before its center
+            const glm::ivec2 levelOrigin = clipmapLevel.center - 2 * BLOCK_SIZE;
+            drawMesh(level == 0 ? CLIPMAP_MESH_FULL : CLIPMAP_MESH_RING, levelOrigin, spacing);
+
+            // Nothing to fit into beyond the last level
+            if (level == LEVEL_COUNT - 1) {
+                continue;
+            }
+
+            // Hole origin of the parent in texels of this level, this level starts 0 or 1 texel after it
+            const glm::ivec2 holeOrigin = 2 * (m_levels[level + 1].center - BLOCK_SIZE);
+            const glm::ivec2 offset = levelOrigin - holeOrigin;
+
+            drawMesh(CLIPMAP_MESH_TRIM + offset.x + 2 * offset.y, holeOrigin, spacing);
+            drawMesh(CLIPMAP_MESH_SEAM, holeOrigin, spacing);
+        }
+
+        // Cleanup
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Distance from the camera to the edge of the last level
+    [[nodiscard]] static float getViewDistance() {
+        return static_cast<float>(2 * BLOCK_SIZE * (1 << (LEVEL_COUNT - 1)));
+    }
+
+    [[nodiscard]] const TerrainClipmapStats &getStats() const {
+        return m_stats;
+    }
+
+    [[nodiscard]] TerrainClipmapShaderProgram &getShader() const {
+        return m_shader;
+    }
+
+private:
+    struct ClipmapLevel {
+        glm::ivec2 center{0}; // Snapped camera position in texels of the level
+        glm::ivec2 origin{0}; // First texel of the resident window
+        bool valid{false};
+    };
+
+    TerrainClipmapShaderProgram &m_shader;
+    ComputeShader m_updateComputeShader;
+
+    GLuint m_VAO;
+    GLuint m_heightTexture;
+    ClipmapMeshBuffer m_meshBuffer;
+    std::array<ClipmapLevel, LEVEL_COUNT> m_levels{};
+    TerrainClipmapStats m_stats{0, 0, 0};
+
+    TerrainNoiseParams m_params{0.0f, 0, 0.0f, 0.0f, 0.0f}; // Parameters of the resident heights
+
+    void updateRegion(const glm::ivec2 &origin, const glm::ivec2 &size) {
+        if (size.x <= 0 || size.y <= 0) {
+            return;
+        }
+
+        const uint workGroupSize = 8;
+        const uint numGroupsX = (size.x + workGroupSize - 1) / workGroupSize;
+        const uint numGroupsY = (size.y + workGroupSize - 1) / workGroupSize;
+
+        m_updateComputeShader.setIVec2("u_regionOrigin", origin);
+        m_updateComputeShader.setIVec2("u_regionSize", size);
+
+        glDispatchCompute(numGroupsX, numGroupsY, 1);
+        m_stats.updatedTexels += size.x * size.y;
+    }
+
+    // Origin in texels of the level
+    void drawMesh(const int meshIndex, const glm::ivec2 &origin, const int spacing) {
+        const ClipmapMeshDescriptor &mesh = m_meshBuffer.meshes[meshIndex];
+
+        m_shader.setVec2f("u_meshOrigin", glm::vec2(origin * spacing));
+        glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+                                 (void *) (mesh.indexOffset * sizeof(GLuint)), mesh.baseVertex);
+
+        m_stats.vertexCount += mesh.vertexCount;
+        m_stats.drawCalls++;
+    }
+
+    void createMeshes() {
+        m_meshBuffer = ClipmapMeshGenerator::generateMeshBuffer(BLOCK_SIZE);
+
+        GLuint VBO, EBO;
+        glGenVertexArrays(1, &m_VAO);
+        glBindVertexArray(m_VAO);
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, m_meshBuffer.vertexBuffer.size() * sizeof(GLfloat),
+                     m_meshBuffer.vertexBuffer.data(), GL_STATIC_DRAW);
+
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_meshBuffer.indexBuffer.size() * sizeof(GLuint),
+                     m_meshBuffer.indexBuffer.data(), GL_STATIC_DRAW);
+
+        // XZ Coord
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void *) nullptr);
+        glEnableVertexAttribArray(0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void createHeightTexture() {
+        glGenTextures(1, &m_heightTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_heightTexture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R32F, TEXTURE_SIZE, TEXTURE_SIZE, LEVEL_COUNT);
+
+        // Only accessed with texelFetch, wrapping is done in the shaders
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+};
+
+#endif //TERRAINCLIPMAP_H
@@ -0,0 +1,154 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINHEIGHTCACHE_H
+#define TERRAINHEIGHTCACHE_H
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "TerrainNoise.h"
+
+enum class HeightQueryMode {
+    EXACT = 0, // Full fBm per query
+    BILINEAR, // Matches the piecewise linear LOD 0 mesh
+    BICUBIC // Catmull-Rom, smooth slopes for ground following
+};
+
+struct TerrainHeightCacheStats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int residentTiles;
+};
+
+// Heights sampled once per world unit in square tiles, queries interpolate between the samples
+// Tiles carry one sample of apron on the low and two on the high side, so a query never needs a second tile
+// Not thread safe, meant for queries on the render thread
+class TerrainHeightCache {
+public:
+    static constexpr int TILE_SIZE = 32; // World units per tile axis
+    static constexpr int TILE_SAMPLES = TILE_SIZE + 3; // Samples per tile axis, -1 to TILE_SIZE + 1
+    static constexpr std::size_t MAX_TILES = 256; // About 1.2 MB of samples
+
+    [[nodiscard]] float getHeight(const TerrainNoiseParams &params, const glm::vec2 &xzPos,
+                                  const HeightQueryMode mode) {
+        if (mode == HeightQueryMode::EXACT) {
+            return TerrainNoise::getHeight(params, xzPos);
+        }
+
+        if (params != m_params) {
+            clear();
+            m_params = params;
+        }
+
+        const glm::vec2 base = glm::floor(xzPos);
+        const glm::vec2 fraction = xzPos - base;
+        const glm::ivec2 sample = glm::ivec2(base);
+        const glm::ivec2 tileCoord = {floorDiv(sample.x, TILE_SIZE), floorDiv(sample.y, TILE_SIZE)};
+        const glm::ivec2 local = sample - tileCoord * TILE_SIZE;
+        const Tile &tile = acquireTile(tileCoord);
+
+        if (mode == HeightQueryMode::BILINEAR) {
+            const float h0 = glm::mix(tile.at(local.x, local.y), tile.at(local.x + 1, local.y), fraction.x);
+            const float h1 = glm::mix(tile.at(local.x, local.y + 1), tile.at(local.x + 1, local.y + 1), fraction.x);
+            return glm::mix(h0, h1, fraction.y);
+        }
+
+        float rows[4];
+        for (int z = 0; z < 4; z++) {
+            const int row = local.y - 1 + z;
+            rows[z] = catmullRom(tile.at(local.x - 1, row), tile.at(local.x, row), tile.at(local.x + 1, row),
+                                 tile.at(local.x + 2, row), fraction.x);
+        }
+
+        return catmullRom(rows[0], rows[1], rows[2], rows[3], fraction.y);
+    }
+
+    void clear() {
+        m_tiles.clear();
+    }
+
+    // Counters since the last call
+    TerrainHeightCacheStats takeStats() {
+        TerrainHeightCacheStats stats = m_stats;
+        stats.residentTiles = static_cast<unsigned int>(m_tiles.size());
+        m_stats = {0, 0, 0};
+        return stats;
+    }
+
+private:
+    struct Tile {
+        std::vector<float> samples; // TILE_SAMPLES^2, row major, starting at sample (-1, -1)
+        std::uint64_t lastUse;
+
+        [[nodiscard]] float at(const int x, const int z) const {
+            return samples[(z + 1) * TILE_SAMPLES + x + 1];
+        }
+    };
+
+    TerrainNoiseParams m_params{0.0f, 0, 0.0f, 0.0f, 0.0f};
+    std::unordered_map<std::uint64_t, Tile> m_tiles;
+    std::uint64_t m_useCounter{0};
+    TerrainHeightCacheStats m_stats{0, 0, 0};
+
+    static int floorDiv(const int value, const int divisor) {
+        return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+    }
+
+    static std::uint64_t tileKey(const glm::ivec2 &coord) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) << 32) |
+               static_cast<std::uint32_t>(coord.y);
+    }
+
+    static float catmullRom(const float p0, const float p1, const float p2, const float p3, const float t) {
+        return p1 + 0.5f * t * (p2 - p0 + t * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 +
+                                               t * (3.0f * (p1 - p2) + p3 - p0)));
+    }
+
+    const Tile &acquireTile(const glm::ivec2 &coord) {
+        auto [it, inserted] = m_tiles.try_emplace(tileKey(coord));
+        Tile &tile = it->second;
+        tile.lastUse = ++m_useCounter;
+
+        if (!inserted) {
+            m_stats.hits++;
+            return tile;
+        }
+
+        m_stats.misses++;
+        tile.samples.resize(TILE_SAMPLES * TILE_SAMPLES);
+        const glm::ivec2 firstSample = coord * TILE_SIZE - 1;
+
+        for (int z = 0; z < TILE_SAMPLES; z++) {
+            for (int x = 0; x < TILE_SAMPLES; x++) {
+                const glm::vec2 xzPos = glm::vec2(firstSample + glm::ivec2(x, z));
+                tile.samples[z * TILE_SAMPLES + x] = TerrainNoise::getHeight(m_params, xzPos);
+            }
+        }
+
+        if (m_tiles.size() > MAX_TILES) {
+            evictLeastRecentlyUsed(it->first);
+        }
+
+        return tile;
+    }
+
+    // Only runs on a miss, a scan over the few resident tiles is cheaper than keeping a list in order
+    void evictLeastRecentlyUsed(const std::uint64_t keepKey) {
+        auto oldest = m_tiles.end();
+        for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+            if (it->first != keepKey && (oldest == m_tiles.end() || it->second.lastUse < oldest->second.lastUse)) {
+                oldest = it;
+            }
+        }
+
+        if (oldest != m_tiles.end()) {
+            m_tiles.erase(oldest);
+        }
+    }
+};
+
+#endif //TERRAINHEIGHTCACHE_H
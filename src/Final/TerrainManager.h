@@ -4,31 +4,73 @@
 
 #ifndef TERRAINMANAGER_H
 #define TERRAINMANAGER_H
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <limits>
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "BakedHeightmap.h"
+#include "ChunkDiskCache.h"
+#include "ChunkGenerationBudget.h"
 #include "InstancingManager.h"
+#include "TerrainCDLOD.h"
 #include "TerrainChunk.h"
+#include "TerrainChunkPool.h"
+#include "TerrainClipmap.h"
+#include "TerrainHeightCache.h"
+#include "TerrainNoise.h"
 #include "TerrainPatchLODGenerator.h"
+#include "TerrainRaycaster.h"
+#include "WaterSurface.h"
 #include "../ComputeShader.h"
 #include "../GPUModelUploader.h"
+#include "../TextureStreamer.h"
+#include "../ThreadPool.h"
 #include "../Shaders/GrassShaderInstanced/GrassShaderInstancedProgram.h"
+#include "../Shaders/TerrainCDLODShader/TerrainCDLODShaderProgram.h"
+#include "../Shaders/TerrainClipmapShader/TerrainClipmapShaderProgram.h"
 #include "../Shaders/TerrainShader/TerrainShaderProgram.h"
 #include "../Shaders/TreeShaderInstance/TreeShaderInstancedProgram.h"
+#include "../Shaders/WaterShader/WaterShaderProgram.h"
 
 
+// Instancing and water always run off the chunk grid, the backends only differ in how the terrain surface is drawn
+enum class TerrainBackend {
+    CHUNKS = 0, // 5x5 chunks with stitched LODs, vertices generated by compute on recenter
+    CLIPMAP, // Geometry clipmap, heights in a toroidally updated texture stack
+    CDLOD // Quadtree selection with morphing, heights evaluated in the vertex shader
+};
+
+// Where the chunk grid, the water mask and CPU queries take their heights from
+enum class TerrainHeightSource {
+    NOISE = 0, // fBm evaluated on the fly
+    BAKED // Tiles of BakedHeightmap::DEFAULT_PATH, see realtime_cg_bake
+};
+
 class TerrainManager {
 public:
     static constexpr int XZ_CHUNK_AMOUNT = 5;
+    static constexpr int BOUNDS_CELL_SIZE = 16; // World units per cell of the chunk height pyramids
+    static constexpr float RECENTER_MARGIN = 32.0f; // How far the camera has to leave the center chunk to recenter
+    static constexpr float PREFETCH_LOOKAHEAD = 2.0f; // Seconds of camera movement chunks get generated ahead
+    static constexpr std::size_t GENERATION_BOUNDS_CHUNKS = 8; // Bounds regions for generation batches
+    static constexpr double PARAMETER_DEBOUNCE = 0.25; // Seconds the noise parameters have to stay unchanged
 
     TerrainManager(const int chunkSize, TerrainShaderProgram &terrainShader,
+                   TerrainClipmapShaderProgram &terrainClipmapShader, TerrainCDLODShaderProgram &terrainCDLODShader,
                    GrassShaderInstancedProgram &modelShaderInstanced, TreeShaderInstancedProgram &treeShaderInstanced,
-                   const float &terrainHeight,
+                   WaterShaderProgram &waterShader, const float &terrainHeight,
                    const int &octaves, const float &scale, const float &persistance,
                    const float &lucunarity) : m_chunkSize(chunkSize),
                                               m_terrainShader(terrainShader),
                                               m_modelShaderInstanced(modelShaderInstanced),
                                               m_treeShaderInstanced(treeShaderInstanced),
+                                              m_waterShader(waterShader),
                                               m_terrainGrid(
                                                   5, std::vector<TerrainChunk>(5)),
                                               m_terrainHeight(terrainHeight),
@@ -39,49 +81,118 @@ public:
                                               } {
         generateChunkMeshes();
         setupInstancingManager();
+        m_waterSurface = std::make_unique<WaterSurface>(m_chunkSize, XZ_CHUNK_AMOUNT, TerrainChunkPool::SLOT_COUNT,
+                                                        m_waterShader);
+        m_clipmap = std::make_unique<TerrainClipmap>(terrainClipmapShader);
+        m_cdlod = std::make_unique<TerrainCDLOD>(terrainCDLODShader);
         uploadTextures();
-        recalculateChunks(glm::vec3{0.0f});
-        dispatchCompute();
+        createChunkBoundsBuffer();
+        m_gridHeightBounds = {0.0f, m_terrainHeight};
+        m_pendingParams = m_activeParams = getLiveNoiseParams();
+        buildInitialGrid();
         renderGrid();
     }
 
+    ~TerrainManager() {
+        // The region read captures this
+        if (m_pendingBakedRegion.valid()) {
+            m_pendingBakedRegion.wait();
+        }
+    }
+
+    TerrainManager(const TerrainManager &) = delete;
+    TerrainManager &operator=(const TerrainManager &) = delete;
+
     // Regenerate chunks if required
     void update(const glm::vec3 &camPos) {
-        // Determine the grid position of the current center chunk (LOD 0)
-        glm::vec2 currentCenterChunkPos = {
-            std::floor(camPos.x / m_chunkSize),
-            std::floor(camPos.z / m_chunkSize)
-        };
+        // Only recenter once the camera is clearly past the center chunk (LOD 0), moving along a border
+        // would otherwise rebuild the grid on every crossing
+        const glm::vec2 centerChunkMin = m_terrainGrid[2][2].globalPos - RECENTER_MARGIN;
+        const glm::vec2 centerChunkMax = m_terrainGrid[2][2].globalPos + static_cast<float>(m_chunkSize) +
+                                         RECENTER_MARGIN;
+        const bool leftCenterChunk = camPos.x < centerChunkMin.x || camPos.x >= centerChunkMax.x ||
+                                     camPos.z < centerChunkMin.y || camPos.z >= centerChunkMax.y;
 
-        // Determine the grid position of the last known center chunk (LOD 0)
-        glm::vec2 lastCenterChunkPos = {
-            std::floor(m_terrainGrid[2][2].globalPos.x / m_chunkSize),
-            std::floor(m_terrainGrid[2][2].globalPos.y / m_chunkSize)
-        };
+        debounceParameterChanges();
+
+        // If the camera has left the center chunk or the parameters changed, move to a new grid
+        if (leftCenterChunk || m_regenerate) {
+            m_targetGridStart = getGridStartPos(camPos);
+            m_recenterPending = true;
+            m_regenerate = false;
+        }
+
+        retrieveFinishedWork();
+
+        // Everything drawn right now has to stay resident
+        m_chunkPool->beginGeneration();
+        for (const int poolSlot: m_gridPoolSlots) {
+            if (poolSlot >= 0) {
+                m_chunkPool->touchSlot(poolSlot);
+            }
+        }
+
+        updateVelocity(camPos);
+        m_generationBudget.beginFrame();
+        if (m_recenterPending) {
+            advanceRecenter();
+        } else {
+            prefetchPredictedChunks(camPos);
+        }
+        m_raycaster.setSurface(m_gridParams, m_gridHeightmap);
 
-        // If the camera has moved into a new chunk, recalculate the terrain grid
-        if (currentCenterChunkPos != lastCenterChunkPos) {
-            recalculateChunks(camPos);
-            dispatchCompute();
+        if (m_backend == TerrainBackend::CLIPMAP) {
+            m_clipmap->update(camPos, m_activeParams);
+        } else if (m_backend == TerrainBackend::CDLOD) {
+            m_cdlod->update(camPos, m_activeParams);
         }
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_camPos = camPos;
         renderGrid();
     }
 
+    // Interpolated from cached samples unless the query mode is exact, baked heights are read directly
+    // Follows the drawn grid, so a pending regeneration only changes the result once it is swapped in
     [[nodiscard]] float getHeight(const glm::vec3 &pos) const {
-        float noiseHeight = 0.0f;
-        float amplitude = 1.0f;
-        float frequency = 1.0f;
+        if (m_gridHeightmap) {
+            return m_gridParams.terrainHeight * m_gridHeightmap->getHeight(glm::vec2{pos.x, pos.z});
+        }
 
-        for (int i = 0; i < m_octaves; i++) {
-            const glm::vec2 xzPos = glm::vec2{pos.x, pos.z};
+        return m_heightCache.getHeight(m_gridParams, glm::vec2{pos.x, pos.z}, m_heightQueryMode);
+    }
 
-            noiseHeight += amplitude * SimplexNoise::snoise(xzPos / (m_scale * frequency));
-            amplitude *= m_persistance;
-            frequency *= m_lucunarity;
-        }
+    void setHeightQueryMode(HeightQueryMode mode) {
+        m_heightQueryMode = mode;
+    }
+
+    // Height cache counters since the last call
+    TerrainHeightCacheStats takeHeightCacheStats() {
+        return m_heightCache.takeStats();
+    }
+
+    // First intersection with the terrain surface, chunks without read back bounds fall back to the noise
+    [[nodiscard]] TerrainRayHit raycast(const TerrainRay &ray) const {
+        return m_raycaster.raycast(ray);
+    }
+
+    [[nodiscard]] std::vector<TerrainRayHit> raycast(const std::vector<TerrainRay> &rays,
+                                                     const bool multithreaded = true) const {
+        return m_raycaster.raycast(rays, multithreaded);
+    }
+
+    // Parameters of the surface rays currently hit, lags behind the sliders until the grid got rebuilt
+    [[nodiscard]] const TerrainNoiseParams &getRaycastParams() const {
+        return m_raycaster.getParams();
+    }
+
+    // Height range of the drawn chunk grid, swapped together with the grid
+    [[nodiscard]] HeightBounds getGridHeightBounds() const {
+        return m_gridHeightBounds;
+    }
 
-        return m_terrainHeight * (noiseHeight + 1.0f) * 0.5f;
+    // Parameters the drawn grid was generated with
+    [[nodiscard]] TerrainNoiseParams getNoiseParams() const {
+        return m_gridParams;
     }
 
     glm::vec3 calculateNormal(const glm::vec3 &localPos, const TerrainChunk &chunk) const {
@@ -109,21 +220,176 @@ public:
         return glm::vec3{worldPosXZ.x, getHeight(glm::vec3{worldPosXZ.x, 0.0f, worldPosXZ.y}), worldPosXZ.y};
     }
 
+    // Reflections on the water surface
+    void setWaterEnvironmentMap(GLuint cubeMapHandle) {
+        m_waterSurface->setEnvironmentMap(cubeMapHandle);
+    }
+
+    // GPU milliseconds per frame for chunk generation, recenters and prefetching spread over as many frames as needed
+    void setGenerationBudget(const float budgetMs) {
+        m_generationBudget.setBudgetMs(budgetMs);
+    }
+
+    [[nodiscard]] const ChunkGenerationBudget &getGenerationBudget() const {
+        return m_generationBudget;
+    }
+
+    // The grid the camera moved to is still being generated, the previous one is drawn meanwhile
+    [[nodiscard]] bool isRecenterPending() const {
+        return m_recenterPending;
+    }
+
+    [[nodiscard]] unsigned int getPrefetchedChunkCount() const {
+        return m_prefetchedChunks;
+    }
+
+    [[nodiscard]] const TerrainChunkPoolStats &getChunkPoolStats() const {
+        return m_chunkPool->getStats();
+    }
+
+    [[nodiscard]] ChunkDiskCacheStats getChunkDiskCacheStats() const {
+        return m_chunkDiskCache.getStats();
+    }
+
+    [[nodiscard]] const WaterSurface &getWaterSurface() const {
+        return *m_waterSurface;
+    }
+
+    // Falls back to the noise if there is no valid baked heightmap
+    void setHeightSource(TerrainHeightSource source) {
+        if (source == TerrainHeightSource::BAKED && !m_bakedHeightmap.isValid()) {
+            source = TerrainHeightSource::NOISE;
+        }
+
+        if (source != m_heightSource) {
+            m_heightSource = source;
+            m_regenerate = true;
+        }
+    }
+
+    [[nodiscard]] TerrainHeightSource getHeightSource() const {
+        return m_heightSource;
+    }
+
+    void setBackend(TerrainBackend backend) {
+        m_backend = backend;
+    }
+
+    [[nodiscard]] TerrainBackend getBackend() const {
+        return m_backend;
+    }
+
+    // CDLOD selection needs the frustum and the screen size of a world unit, see TerrainCDLOD::setView
+    void setView(const glm::mat4 &viewProjection, float pixelsPerUnit, float trianglePixels) {
+        m_cdlod->setView(viewProjection, pixelsPerUnit, trianglePixels);
+    }
+
+    // How far the terrain surface of the active backend reaches
+    [[nodiscard]] float getViewDistance() const {
+        switch (m_backend) {
+            case TerrainBackend::CLIPMAP:
+                return TerrainClipmap::getViewDistance();
+            case TerrainBackend::CDLOD:
+                return m_cdlod->getViewDistance();
+            default:
+                return 500.0f;
+        }
+    }
+
+    [[nodiscard]] const TerrainClipmap &getClipmap() const {
+        return *m_clipmap;
+    }
+
+    [[nodiscard]] const TerrainCDLOD &getCDLOD() const {
+        return *m_cdlod;
+    }
+
 private:
     int m_chunkSize;
+    glm::vec3 m_camPos{0.0f};
     MeshBufferInfo m_meshBufferPositions; // Contains buffer positions of all LODs and Meshes
     std::vector<std::vector<TerrainChunk> > m_terrainGrid;
     TerrainShaderProgram m_terrainShader;
     TerrainBufferHandles m_terrainBufferHandles;
     ComputeShader m_terrainComputeShader;
     std::unique_ptr<InstancingManager> m_instancingManager;
+    std::unique_ptr<WaterSurface> m_waterSurface;
+    std::unique_ptr<TerrainClipmap> m_clipmap;
+    std::unique_ptr<TerrainCDLOD> m_cdlod;
+    TerrainBackend m_backend{TerrainBackend::CHUNKS};
+
+    // Chunk bounds of the generation batch, reduced by the terrain compute and read back once it finished
+    GLuint m_chunkBoundsSSBO;
+    // Bounds and vertices of the generation batch get copied here on the GPU, mapped once the batch fence signaled
+    GLuint m_generationReadbackBuffer;
+    HeightBounds m_gridHeightBounds;
+    TerrainNoiseParams m_gridParams{0.0f, 0, 0.0f, 0.0f, 0.0f}; // Parameters the drawn grid got generated with
+    const BakedHeightmap *m_gridHeightmap{nullptr};
+    TerrainRaycaster m_raycaster;
+
+    // Vertices of the grid and recently left chunks, resident chunks are only re-pointed on a recenter
+    std::unique_ptr<TerrainChunkPool> m_chunkPool;
+    // Generated chunks from earlier runs
+    ChunkDiskCache m_chunkDiskCache{ChunkDiskCache::DEFAULT_DIRECTORY};
+
+    // Chunks generated into the pool, for a pending recenter or ahead of the camera
+    // Chunk i of a batch reduces its bounds into region i of the bounds buffer
+    struct GeneratedChunk {
+        ChunkCacheKey key;
+        int poolSlot;
+        GLuint dataOffset;
+        GLuint vertexCount;
+    };
+
+    struct GenerationBatch {
+        GLsync fence;
+        std::vector<GeneratedChunk> chunks;
+    };
+
+    GenerationBatch m_generationBatch{nullptr, {}};
+
+    // Instances and water masks of the target grid, placed and baked chunk by chunk once its vertices are resident
+    struct GridStaging {
+        bool active;
+        std::uint64_t centerKeyHash; // Changes with the target grid and its parameters
+        int placedChunks; // Row major, the instances of these went into the back buffers
+    };
+
+    GridStaging m_staging{false, 0, 0};
+    ChunkGenerationBudget m_generationBudget;
+    std::vector<int> m_gridPoolSlots; // Pool slots of the drawn grid, row * XZ_CHUNK_AMOUNT + column
+    std::uint64_t m_gridCenterKeyHash{0}; // Key of the drawn center chunk, identifies the drawn grid
+    glm::vec2 m_targetGridStart{0.0f};
+    bool m_recenterPending{false};
+    glm::vec3 m_camVelocity{0.0f}; // Smoothed, world units per second
+    double m_lastUpdateTime{-1.0};
+    unsigned int m_prefetchedChunks{0};
+
+    // Samples for CPU height queries, rebuilt on demand once the parameters change
+    mutable TerrainHeightCache m_heightCache;
+    HeightQueryMode m_heightQueryMode{HeightQueryMode::BILINEAR};
+
+    // Noise parameters, live ones from the UI, pending ones waiting for the debounce, active ones being generated
+    TerrainNoiseParams m_pendingParams{0.0f, 0, 0.0f, 0.0f, 0.0f};
+    TerrainNoiseParams m_activeParams{0.0f, 0, 0.0f, 0.0f, 0.0f};
+    double m_parametersChangedTime{0.0};
+
+    // Baked heights, the grid area gets copied into a texture for the compute shaders on every recenter
+    BakedHeightmap m_bakedHeightmap{BakedHeightmap::DEFAULT_PATH};
+    TerrainHeightSource m_heightSource{TerrainHeightSource::NOISE};
+    GLuint m_bakedRegionTexture{0};
+    glm::vec2 m_bakedRegionGridStart{0.0f}; // Grid start the region texture got uploaded for
+    std::future<std::vector<float> > m_pendingBakedRegion; // Read on the decode pool, one at a time
+    glm::vec2 m_pendingBakedRegionGridStart{0.0f};
+    bool m_regenerate{false};
 
     // Shaders
     GrassShaderInstancedProgram &m_modelShaderInstanced;
     TreeShaderInstancedProgram &m_treeShaderInstanced;
+    WaterShaderProgram &m_waterShader;
     // Textures
-    TextureHandle m_texLayerOne;
-    TextureHandle m_texLayerTwo;
+    std::shared_ptr<TextureHandle> m_texLayerOne;
+    std::shared_ptr<TextureHandle> m_texLayerTwo;
     TextureHandle m_texLayerThree;
 
     // Terrain noise parameters
@@ -172,71 +438,101 @@ private:
         // Generate and set up VAO/EBO/SSBO
         m_terrainBufferHandles = TerrainPatchLODGenerator::generateTerrainBufferHandles(m_meshBufferPositions);
 
+        // Every slot fits the largest mesh, the LOD 0 chunk
+        GLuint slotVertexCount = 0;
+        for (const MeshBufferDescriptor &descriptor: m_meshBufferPositions.meshes) {
+            slotVertexCount = std::max(slotVertexCount, descriptor.bufferPosition.vertexCount);
+        }
+        m_chunkPool = std::make_unique<TerrainChunkPool>(slotVertexCount);
+
         // Cleanup
         glBindVertexArray(0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
     void uploadTextures() {
-        ImageData imgTexLayerOne = opengl_utils::loadImage("../assets/textures/terrain/dirt.png");
-        m_texLayerOne = opengl_utils::createTexture(imgTexLayerOne, true);
-        opengl_utils::updateTextureData(m_texLayerOne, imgTexLayerOne);
-
-        ImageData imgTexLayerTwo = opengl_utils::loadImage("../assets/textures/terrain/rocky_terrain.png");
-        m_texLayerTwo = opengl_utils::createTexture(imgTexLayerTwo, true);
-        opengl_utils::updateTextureData(m_texLayerTwo, imgTexLayerTwo);
+        // Decoded in the background, the handles stay valid while the images stream in
+        TextureStreamer &streamer = TextureStreamer::instance();
+        m_texLayerOne = streamer.requestTexture("../assets/textures/terrain/dirt.png", true);
+        m_texLayerTwo = streamer.requestTexture("../assets/textures/terrain/rocky_terrain.png", true);
     }
 
-    void recalculateChunks(const glm::vec3 &currPos) {
+    // Global position of chunk [0][0] for a grid centered on the chunk containing pos
+    [[nodiscard]] glm::vec2 getGridStartPos(const glm::vec3 &pos) const {
         glm::vec2 gridChunk = {
-            std::floor(currPos.x / m_chunkSize),
-            std::floor(currPos.z / m_chunkSize)
+            std::floor(pos.x / m_chunkSize),
+            std::floor(pos.z / m_chunkSize)
         };
-        glm::vec2 gridStartPos = {
+
+        return {
             (gridChunk.x * m_chunkSize) - (2 * m_chunkSize),
             (gridChunk.y * m_chunkSize) - (2 * m_chunkSize)
         };
+    }
 
-        for (int row = 0; row < XZ_CHUNK_AMOUNT; row++) {
-            for (int column = 0; column < XZ_CHUNK_AMOUNT; column++) {
-                int lod = calculateLod(row, column);
-                int meshIndex = row * XZ_CHUNK_AMOUNT + column;
-
-                TerrainChunk chunk;
-                chunk.globalPos = {
-                    gridStartPos.x + column * m_chunkSize,
-                    gridStartPos.y + row * m_chunkSize
-                };
-                chunk.lod = lod;
+    // Chunk of the grid at gridStartPos without its pool slot and bounds
+    [[nodiscard]] TerrainChunk createChunk(const glm::vec2 &gridStartPos, const int row, const int column) const {
+        const MeshBufferDescriptor &descriptor = m_meshBufferPositions.meshes[row * XZ_CHUNK_AMOUNT + column];
 
-                chunk.localGridPos = {
-                    column * m_chunkSize,
-                    (row + 1) * m_chunkSize
-                };
+        TerrainChunk chunk;
+        chunk.globalPos = {
+            gridStartPos.x + column * m_chunkSize,
+            gridStartPos.y + row * m_chunkSize
+        };
+        chunk.lod = calculateLod(row, column);
 
-                const MeshBufferDescriptor &descriptor = m_meshBufferPositions.meshes[meshIndex];
-                chunk.bufferPos = descriptor.bufferPosition;
-                chunk.gridSpacing = descriptor.stepSize;
+        chunk.localGridPos = {
+            column * m_chunkSize,
+            (row + 1) * m_chunkSize
+        };
 
-                m_terrainGrid[row][column] = chunk;
-            }
-        }
+        chunk.bufferPos = descriptor.bufferPosition;
+        chunk.gridSpacing = descriptor.stepSize;
+        return chunk;
     }
 
-    void renderGrid() {
-        m_terrainShader.use();
+    // Layer textures and the height range used to blend them
+    void setupSurfaceShader(BaseShaderProgram &shader) const {
+        shader.use();
+        shader.setFloat("u_minHeight", m_gridHeightBounds.min);
+        shader.setFloat("u_maxHeight", m_gridHeightBounds.max);
 
-        // Texture setup
-        m_terrainShader.setInt("u_texLayerOne", 0);
+        shader.setInt("u_texLayerOne", 0);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_texLayerOne.handle);
+        glBindTexture(GL_TEXTURE_2D, m_texLayerOne->handle);
 
-        m_terrainShader.setInt("u_texLayerTwo", 1);
+        shader.setInt("u_texLayerTwo", 1);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, m_texLayerTwo.handle);
+        glBindTexture(GL_TEXTURE_2D, m_texLayerTwo->handle);
+    }
+
+    void renderGrid() {
+        switch (m_backend) {
+            case TerrainBackend::CLIPMAP:
+                setupSurfaceShader(m_clipmap->getShader());
+                m_clipmap->render();
+                break;
+            case TerrainBackend::CDLOD:
+                setupSurfaceShader(m_cdlod->getShader());
+                m_cdlod->render();
+                break;
+            default:
+                renderChunks();
+                break;
+        }
+
+        m_instancingManager->issueDrawCalls();
+        m_waterSurface->render(m_camPos);
+    }
+
+    void renderChunks() {
+        setupSurfaceShader(m_terrainShader);
+        m_terrainShader.setFloat("u_terrainHeight", m_gridParams.terrainHeight);
 
         glBindVertexArray(m_terrainBufferHandles.VAO);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_terrainBufferHandles.SSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_chunkPool->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TerrainPatchLODGenerator::TEMPLATE_SSBO_BINDING,
+                         m_terrainBufferHandles.templateSSBO);
 
         // Render chunks
         for (auto &row: m_terrainGrid) {
@@ -248,8 +544,7 @@ private:
         // Cleanup
         glBindVertexArray(0);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
-
-        m_instancingManager->issueDrawCalls();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TerrainPatchLODGenerator::TEMPLATE_SSBO_BINDING, 0);
     }
 
     void setupInstancingManager() {
@@ -259,15 +554,12 @@ private:
                                                                   widthHeightTerrain);
 
         // Set models to be instanced
-        GltfLoader loader;
-        GPUModelUploader uploader;
+        GPUModelUploader uploader{true};
 
-        GltfScene grassBlade = loader.loadModel("../assets/models/terrain/grass.glb");
-        std::vector<RenderCall> grassBladeRenderCalls = uploader.uploadGltfModel(grassBlade);
+        std::vector<RenderCall> grassBladeRenderCalls = uploader.uploadModel("../assets/models/terrain/grass.glb");
         m_instancingManager->addModelToBeInstanced(grassBladeRenderCalls, &m_modelShaderInstanced);
 
-        GltfScene tv = loader.loadModel("../assets/models/terrain/LOW_POLY_TREE.glb");
-        std::vector<RenderCall> tvRenderCalls = uploader.uploadGltfModel(tv);
+        std::vector<RenderCall> tvRenderCalls = uploader.uploadModel("../assets/models/terrain/LOW_POLY_TREE.glb");
         m_instancingManager->addModelToBeInstanced(tvRenderCalls, &m_treeShaderInstanced);
 
         // Initialize buffers
@@ -276,43 +568,631 @@ private:
         m_instancingManager->setupInstanceCountAtomics();
     }
 
-    void dispatchCompute() {
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_terrainBufferHandles.SSBO);
+    [[nodiscard]] int boundsCellsPerAxis() const {
+        return m_chunkSize / BOUNDS_CELL_SIZE;
+    }
+
+    void createChunkBoundsBuffer() {
+        glGenBuffers(1, &m_chunkBoundsSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_chunkBoundsSSBO);
+        // One region per chunk of a generation batch, see GENERATION_BOUNDS_CHUNKS
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GENERATION_BOUNDS_CHUNKS * cellsPerChunk * 2 * sizeof(GLuint), nullptr,
+                     GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glGenBuffers(1, &m_generationReadbackBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_generationReadbackBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, getReadbackVertexOffset(GENERATION_BOUNDS_CHUNKS), nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // Byte offset of chunk i of a batch in the readback buffer, the bounds of the whole batch come first
+    [[nodiscard]] GLintptr getReadbackVertexOffset(const std::size_t chunk) const {
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+        return GENERATION_BOUNDS_CHUNKS * cellsPerChunk * 2 * sizeof(GLuint) +
+               chunk * m_chunkPool->getSlotVertexCount() * sizeof(TerrainVertexData);
+    }
+
+    // GPU side copy of the batch into the readback buffer, nothing waits on it until the batch fence signals
+    void copyGenerationBatchForReadback() const {
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_generationReadbackBuffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_chunkBoundsSSBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                            m_generationBatch.chunks.size() * cellsPerChunk * 2 * sizeof(GLuint));
+
+        glBindBuffer(GL_COPY_READ_BUFFER, m_chunkPool->getBuffer());
+        for (std::size_t i = 0; i < m_generationBatch.chunks.size(); i++) {
+            const GeneratedChunk &generated = m_generationBatch.chunks[i];
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                generated.dataOffset * sizeof(TerrainVertexData), getReadbackVertexOffset(i),
+                                generated.vertexCount * sizeof(TerrainVertexData));
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    void resetChunkBounds(const int firstChunk, const int chunkCount) const {
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+
+        // Min starts at the largest, max at the smallest ordered value
+        std::vector<GLuint> initialBounds(chunkCount * cellsPerChunk * 2);
+        for (std::size_t i = 0; i < initialBounds.size(); i += 2) {
+            initialBounds[i] = 0xFFFFFFFFu;
+            initialBounds[i + 1] = 0u;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_chunkBoundsSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, firstChunk * cellsPerChunk * 2 * sizeof(GLuint),
+                        initialBounds.size() * sizeof(GLuint), initialBounds.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Inverse of orderedBits in the compute shader
+    static float decodeOrderedBits(GLuint bits) {
+        bits = (bits & 0x80000000u) != 0u ? bits & 0x7FFFFFFFu : ~bits;
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    // Grid start is the global position of chunk [0][0]
+    [[nodiscard]] ChunkCacheKey getChunkCacheKey(const glm::vec2 &gridStartPos, const int row, const int column) const {
+        const glm::ivec2 gridStartCoord = glm::ivec2(glm::floor(gridStartPos / static_cast<float>(m_chunkSize)));
+
+        // Baked heights only get scaled, the other parameters don't affect them, the heightmap file does
+        TerrainNoiseParams params = m_activeParams;
+        std::uint64_t heightmapIdentity = 0;
+        if (m_heightSource == TerrainHeightSource::BAKED) {
+            params = {params.terrainHeight, 0, 0.0f, 0.0f, 0.0f};
+            heightmapIdentity = m_bakedHeightmap.getIdentity();
+        }
+
+        return {
+            params, gridStartCoord + glm::ivec2{column, row}, m_chunkSize, calculateLod(row, column),
+            row * XZ_CHUNK_AMOUNT + column, static_cast<int>(m_heightSource), heightmapIdentity
+        };
+    }
+
+    // Uploads the vertices of a chunk found on disk into its pool slot, the bounds go to the pool
+    bool loadCachedChunk(const ChunkCacheKey &key, const int poolSlot, const GLuint vertexCount) {
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+        const std::optional<ChunkCacheEntry> entry = m_chunkDiskCache.load(key, vertexCount, cellsPerChunk);
+
+        if (!entry) {
+            return false;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_chunkPool->getBuffer());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_chunkPool->getVertexOffset(poolSlot) * sizeof(TerrainVertexData),
+                        vertexCount * sizeof(TerrainVertexData), entry->vertices);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        m_chunkPool->setBounds(poolSlot, key.hash(),
+                               std::vector<GLuint>(entry->bounds, entry->bounds + cellsPerChunk * 2));
+        return true;
+    }
+
+    [[nodiscard]] TerrainNoiseParams getLiveNoiseParams() const {
+        return {m_terrainHeight, m_octaves, m_scale, m_persistance, m_lucunarity};
+    }
+
+    // Slider drags change the parameters every frame, regeneration only starts once they settled
+    // It runs like a recenter within the frame budget, see advanceRecenter
+    // Until the regenerated grid is swapped in, the drawn grid and CPU queries keep the previous parameters
+    void debounceParameterChanges() {
+        const double time = glfwGetTime();
+        const TerrainNoiseParams liveParams = getLiveNoiseParams();
+
+        if (liveParams != m_pendingParams) {
+            m_pendingParams = liveParams;
+            m_parametersChangedTime = time;
+        }
+
+        if (m_pendingParams != m_activeParams && time - m_parametersChangedTime >= PARAMETER_DEBOUNCE) {
+            m_activeParams = m_pendingParams;
+            m_regenerate = true;
+        }
+    }
+
+    [[nodiscard]] const BakedHeightmap *getActiveHeightmap() const {
+        return m_heightSource == TerrainHeightSource::BAKED ? &m_bakedHeightmap : nullptr;
+    }
+
+    // One texel per world unit, a texel of apron around the uploaded grid for the normals
+    [[nodiscard]] glm::vec2 getBakedRegionOrigin() const {
+        return m_bakedRegionGridStart - 1.0f;
+    }
+
+    [[nodiscard]] int getBakedRegionSize() const {
+        return XZ_CHUNK_AMOUNT * m_chunkSize + 3;
+    }
+
+    // Reads the region on the decode pool if it moved, true once the texture holds the region of gridStartPos
+    bool uploadBakedRegion(const glm::vec2 &gridStartPos) {
+        if (m_bakedRegionTexture && gridStartPos == m_bakedRegionGridStart) {
+            return true;
+        }
+
+        if (m_pendingBakedRegion.valid()) {
+            if (m_pendingBakedRegion.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return false;
+            }
+
+            // A read for a grid the camera already left only gets dropped
+            const std::vector<float> heights = m_pendingBakedRegion.get();
+            if (m_pendingBakedRegionGridStart == gridStartPos) {
+                uploadBakedRegionTexture(gridStartPos, heights);
+                return true;
+            }
+        }
+
+        const glm::ivec2 origin = glm::ivec2(gridStartPos - 1.0f);
+        const int size = getBakedRegionSize();
+        m_pendingBakedRegionGridStart = gridStartPos;
+        m_pendingBakedRegion = ThreadPool::decodePool().submit([this, origin, size] {
+            std::vector<float> heights;
+            m_bakedHeightmap.readRegion(origin, size, heights);
+            return heights;
+        });
+        return false;
+    }
+
+    void uploadBakedRegionTexture(const glm::vec2 &gridStartPos, const std::vector<float> &heights) {
+        m_bakedRegionGridStart = gridStartPos;
+        const int size = getBakedRegionSize();
+        const glm::vec2 origin = getBakedRegionOrigin();
+
+        if (!m_bakedRegionTexture) {
+            glGenTextures(1, &m_bakedRegionTexture);
+            glBindTexture(GL_TEXTURE_2D, m_bakedRegionTexture);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, size, size);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_bakedRegionTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_FLOAT, heights.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // The next recenter moves by one chunk, page in the ring around the grid ahead of it
+        const glm::vec2 chunkMargin = glm::vec2{static_cast<float>(m_chunkSize)};
+        m_bakedHeightmap.prefetchRegion(origin - chunkMargin, origin + static_cast<float>(size) + chunkMargin);
+    }
+
+    void updateVelocity(const glm::vec3 &camPos) {
+        const double time = glfwGetTime();
+
+        if (m_lastUpdateTime >= 0.0 && time > m_lastUpdateTime) {
+            const glm::vec3 velocity = (camPos - m_camPos) / static_cast<float>(time - m_lastUpdateTime);
+            m_camVelocity = glm::mix(m_camVelocity, velocity, 0.2f);
+        }
+
+        m_lastUpdateTime = time;
+    }
+
+    // Generates chunks of the grid around the predicted camera position with what is left of the budget
+    // The swap happens with the regular recenter, which then finds the chunks in the pool
+    void prefetchPredictedChunks(const glm::vec3 &camPos) {
+        // The baked region texture only covers the current grid
+        if (getActiveHeightmap()) {
+            return;
+        }
+
+        const glm::vec2 predictedGridStart = getGridStartPos(camPos + m_camVelocity * PREFETCH_LOOKAHEAD);
+        if (predictedGridStart != m_terrainGrid[0][0].globalPos) {
+            m_prefetchedChunks += generateMissingChunks(predictedGridStart);
+        }
+    }
+
+    // Starts generating missing chunks of the grid at gridStartPos within the frame budget, closest LOD first
+    // Every resident chunk of that grid gets protected from eviction, only one batch is in flight at a time
+    // Returns the amount of chunks started
+    int generateMissingChunks(const glm::vec2 &gridStartPos) {
+        const BakedHeightmap *heightmap = getActiveHeightmap();
+        const bool batchInFlight = m_generationBatch.fence != nullptr;
+        bool buffersBound = false;
+
+        for (int lod = 0; lod < ChunkGenerationBudget::LOD_COUNT; lod++) {
+            for (int row = 0; row < XZ_CHUNK_AMOUNT; row++) {
+                for (int column = 0; column < XZ_CHUNK_AMOUNT; column++) {
+                    if (calculateLod(row, column) != lod) {
+                        continue;
+                    }
+
+                    const ChunkCacheKey key = getChunkCacheKey(gridStartPos, row, column);
+                    int poolSlot = m_chunkPool->touch(key.hash());
+                    if (poolSlot >= 0 && !m_chunkPool->getBounds(poolSlot).empty()) {
+                        continue;
+                    }
+
+                    if (batchInFlight || m_generationBatch.chunks.size() == GENERATION_BOUNDS_CHUNKS ||
+                        !m_generationBudget.fits(lod)) {
+                        continue;
+                    }
+
+                    if (poolSlot < 0) {
+                        poolSlot = m_chunkPool->acquire(key.hash());
+                    }
+
+                    if (poolSlot < 0) {
+                        continue;
+                    }
+
+                    const MeshBufferDescriptor &descriptor =
+                            m_meshBufferPositions.meshes[row * XZ_CHUNK_AMOUNT + column];
+                    const GLuint vertexCount = descriptor.bufferPosition.vertexCount;
+                    const int boundsChunk = static_cast<int>(m_generationBatch.chunks.size());
+
+                    const auto loadStart = std::chrono::steady_clock::now();
+                    const bool cached = loadCachedChunk(key, poolSlot, vertexCount);
+                    m_generationBudget.spend(std::chrono::duration<float, std::milli>(
+                        std::chrono::steady_clock::now() - loadStart).count());
+                    if (cached) {
+                        continue;
+                    }
+
+                    if (!buffersBound) {
+                        bindComputeBuffers();
+                        setComputeSurfaceUniforms(heightmap);
+                        m_terrainComputeShader.setInt("u_useCachedVertices", false);
+                        m_terrainComputeShader.setInt("u_placeInstances", false);
+                        buffersBound = true;
+                    }
+
+                    resetChunkBounds(boundsChunk, 1);
+                    const glm::vec2 globalPos = gridStartPos + glm::vec2{column, row} * static_cast<float>(m_chunkSize);
+                    m_terrainComputeShader.setVec2f("u_chunkOffset", globalPos);
+                    m_terrainComputeShader.setInt("u_stepSize", static_cast<int>(descriptor.stepSize));
+                    m_terrainComputeShader.setInt("u_chunkIndex", boundsChunk);
+
+                    const GLuint dataOffset = m_chunkPool->getVertexOffset(poolSlot);
+                    m_generationBudget.beginChunk(lod);
+                    dispatchChunkVertices(descriptor.bufferPosition.vertexOffset, dataOffset, vertexCount);
+                    m_generationBudget.endChunk();
+
+                    m_generationBatch.chunks.push_back({key, poolSlot, dataOffset, vertexCount});
+                }
+            }
+        }
+
+        if (batchInFlight || m_generationBatch.chunks.empty()) {
+            return 0;
+        }
+
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        copyGenerationBatchForReadback();
+        m_generationBatch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return static_cast<int>(m_generationBatch.chunks.size());
+    }
+
+    // True once every chunk of the grid at gridStartPos has its vertices and bounds in the pool
+    [[nodiscard]] bool isGridResident(const glm::vec2 &gridStartPos) const {
+        for (int row = 0; row < XZ_CHUNK_AMOUNT; row++) {
+            for (int column = 0; column < XZ_CHUNK_AMOUNT; column++) {
+                const int poolSlot = m_chunkPool->peek(getChunkCacheKey(gridStartPos, row, column).hash());
+
+                if (poolSlot < 0 || m_chunkPool->getBounds(poolSlot).empty()) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool pollGenerationFence() {
+        GLenum waitRet = glClientWaitSync(m_generationBatch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (waitRet == GL_ALREADY_SIGNALED || waitRet == GL_CONDITION_SATISFIED) {
+            glDeleteSync(m_generationBatch.fence);
+            m_generationBatch.fence = nullptr;
+            return true;
+        }
+
+        return false;
+    }
+
+    // The batch fence signaled, so mapping the readback buffer doesn't wait on the GPU
+    void retrieveGeneratedChunks() {
+        const int cellsPerChunk = boundsCellsPerAxis() * boundsCellsPerAxis();
+        const GLsizeiptr readbackSize = getReadbackVertexOffset(m_generationBatch.chunks.size());
+
+        glBindBuffer(GL_COPY_READ_BUFFER, m_generationReadbackBuffer);
+        const auto *readback = static_cast<const std::byte *>(
+            glMapBufferRange(GL_COPY_READ_BUFFER, 0, readbackSize, GL_MAP_READ_BIT));
+
+        if (readback) {
+            const auto *bounds = reinterpret_cast<const GLuint *>(readback);
+
+            for (std::size_t i = 0; i < m_generationBatch.chunks.size(); i++) {
+                const GeneratedChunk &generated = m_generationBatch.chunks[i];
+                const GLuint *firstBound = bounds + i * cellsPerChunk * 2;
+                std::vector<GLuint> chunkBounds(firstBound, firstBound + cellsPerChunk * 2);
+
+                // A recenter in the meantime may have given the slot to another chunk
+                if (!m_chunkPool->setBounds(generated.poolSlot, generated.key.hash(), chunkBounds)) {
+                    continue;
+                }
+
+                std::vector<std::uint32_t> vertices(generated.vertexCount * 2);
+                std::memcpy(vertices.data(), readback + getReadbackVertexOffset(i),
+                            vertices.size() * sizeof(std::uint32_t));
+                m_chunkDiskCache.store(generated.key, std::move(vertices), std::move(chunkBounds));
+            }
+
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        m_generationBatch.chunks.clear();
+    }
+
+    void bindComputeBuffers() {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_chunkBoundsSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_chunkPool->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TerrainPatchLODGenerator::TEMPLATE_SSBO_BINDING,
+                         m_terrainBufferHandles.templateSSBO);
         glUseProgram(m_terrainComputeShader.getProgramId());
+    }
 
-        m_terrainComputeShader.setFloat("u_terrainHeight", m_terrainHeight);
-        m_terrainComputeShader.setFloat("u_scale", m_scale);
-        m_terrainComputeShader.setFloat("u_persistance", m_persistance);
-        m_terrainComputeShader.setFloat("u_lucunarity", m_lucunarity);
-        m_terrainComputeShader.setInt("u_octaves", m_octaves);
+    // Noise parameters and the baked region, nullptr evaluates the noise
+    void setComputeSurfaceUniforms(const BakedHeightmap *heightmap) {
+        m_terrainComputeShader.setFloat("u_terrainHeight", m_activeParams.terrainHeight);
+        m_terrainComputeShader.setFloat("u_scale", m_activeParams.scale);
+        m_terrainComputeShader.setFloat("u_persistance", m_activeParams.persistance);
+        m_terrainComputeShader.setFloat("u_lucunarity", m_activeParams.lucunarity);
+        m_terrainComputeShader.setInt("u_octaves", m_activeParams.octaves);
+        m_terrainComputeShader.setInt("u_boundsCellSize", BOUNDS_CELL_SIZE);
+        m_terrainComputeShader.setInt("u_boundsCellsPerAxis", boundsCellsPerAxis());
+        m_terrainComputeShader.setInt("u_useBakedHeights", heightmap != nullptr);
+        m_terrainComputeShader.setVec2f("u_bakedOrigin", getBakedRegionOrigin());
+        m_terrainComputeShader.setInt("u_bakedHeights", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, heightmap ? m_bakedRegionTexture : 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
+    // Runs the bound compute shader over the vertices of one chunk, in batches
+    void dispatchChunkVertices(const GLuint templateOffset, const GLuint dataOffset, const GLuint vertexCount) {
         const uint workGroupSize = 256;
         const uint verticesPerDispatch = 1024;
-        for (const auto &row: m_terrainGrid) {
-            for (const TerrainChunk &chunk: row) {
-                const uint amountVertices = chunk.bufferPos.vertexCount;
-                const uint baseOffset = chunk.bufferPos.vertexOffset;
-
-                m_terrainComputeShader.setVec2f("u_chunkOffset", chunk.globalPos);
-                m_terrainComputeShader.setVec2f("u_chunkLocalGridPos", chunk.localGridPos);
-                m_terrainComputeShader.setInt("u_stepSize", (int) chunk.gridSpacing);
+
+        for (uint offset = 0; offset < vertexCount; offset += verticesPerDispatch) {
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            uint count = std::min(verticesPerDispatch, (vertexCount - offset));
+            uint numGroups = (count + workGroupSize - 1) / workGroupSize;
+
+            m_terrainComputeShader.setInt("u_bufferOffset", templateOffset + offset);
+            m_terrainComputeShader.setInt("u_dataOffset", dataOffset + offset);
+            m_terrainComputeShader.setInt("u_count", count);
+
+            glDispatchCompute(numGroups, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+    }
+
+    // Generated chunks and water masks are read back once the GPU finished them
+    void retrieveFinishedWork() {
+        if (m_generationBatch.fence && pollGenerationFence()) {
+            retrieveGeneratedChunks();
+        }
+
+        m_waterSurface->pollBake();
+    }
+
+    // The first grid has nothing to show in the meantime, so it gets built right away without a frame budget
+    void buildInitialGrid() {
+        const float budgetMs = m_generationBudget.getBudgetMs();
+        m_generationBudget.setBudgetMs(std::numeric_limits<float>::max());
+
+        m_targetGridStart = getGridStartPos(glm::vec3{0.0f});
+        m_recenterPending = true;
+        while (m_recenterPending) {
+            retrieveFinishedWork();
+            m_chunkPool->beginGeneration();
+            m_generationBudget.beginFrame();
+            advanceRecenter();
+            glFinish();
+        }
+
+        m_generationBudget.setBudgetMs(budgetMs);
+    }
+
+    // Spends the frame budget on the target grid, vertices first, then water masks and instances chunk by chunk
+    // The old grid stays visible until all of it is done, then the grids swap at once
+    void advanceRecenter() {
+        // Parameters the chunks don't depend on (baked heights only get scaled) leave the drawn grid as it is
+        const std::uint64_t centerKeyHash = getChunkCacheKey(m_targetGridStart, 2, 2).hash();
+        if (!m_gridPoolSlots.empty() && centerKeyHash == m_gridCenterKeyHash) {
+            m_gridParams = m_activeParams;
+            m_staging.active = false;
+            m_recenterPending = false;
+            return;
+        }
+
+        // Chunks and water masks of a baked grid sample the region texture, they wait until it is uploaded
+        if (getActiveHeightmap() && !uploadBakedRegion(m_targetGridStart)) {
+            return;
+        }
+
+        generateMissingChunks(m_targetGridStart);
+        if (!isGridResident(m_targetGridStart)) {
+            return;
+        }
+
+        // A new target or new parameters restart the placement, the water masks of resident chunks are kept
+        if (!m_staging.active || m_staging.centerKeyHash != centerKeyHash) {
+            m_staging = {true, centerKeyHash, 0};
+            m_instancingManager->beginPlacement();
+        }
+
+        const bool waterBaked = bakeMissingWater(m_targetGridStart);
+        placeInstances(m_targetGridStart);
+
+        if (waterBaked && m_staging.placedChunks == XZ_CHUNK_AMOUNT * XZ_CHUNK_AMOUNT &&
+            m_instancingManager->isPlacementDone()) {
+            swapGrid(m_targetGridStart);
+        }
+    }
+
+    // Bakes the water masks of the grid into the layers of its pool slots, closest LOD first
+    // Returns true once every mask of the grid got read back
+    bool bakeMissingWater(const glm::vec2 &gridStartPos) {
+        const bool bakeInFlight = m_waterSurface->isBakeInFlight();
+        const BakedHeightmap *heightmap = getActiveHeightmap();
+        bool baked = true;
+        bool batchStarted = false;
+
+        for (int lod = 0; lod < ChunkGenerationBudget::LOD_COUNT; lod++) {
+            for (int row = 0; row < XZ_CHUNK_AMOUNT; row++) {
+                for (int column = 0; column < XZ_CHUNK_AMOUNT; column++) {
+                    if (calculateLod(row, column) != lod) {
+                        continue;
+                    }
+
+                    const std::uint64_t keyHash = getChunkCacheKey(gridStartPos, row, column).hash();
+                    const int poolSlot = m_chunkPool->peek(keyHash);
+                    if (m_waterSurface->isBaked(poolSlot, keyHash)) {
+                        continue;
+                    }
+
+                    baked = false;
+                    if (bakeInFlight || !m_generationBudget.fits(lod, ChunkWork::WATER)) {
+                        continue;
+                    }
+
+                    if (!batchStarted) {
+                        m_waterSurface->beginBake(m_activeParams, heightmap ? m_bakedRegionTexture : 0,
+                                                  getBakedRegionOrigin());
+                        batchStarted = true;
+                    }
+
+                    const glm::vec2 globalPos = gridStartPos + glm::vec2{column, row} * static_cast<float>(m_chunkSize);
+                    m_generationBudget.beginChunk(lod, ChunkWork::WATER);
+                    m_waterSurface->bakeChunk(poolSlot, keyHash, globalPos);
+                    m_generationBudget.endChunk();
+                }
+            }
+        }
+
+        if (batchStarted) {
+            m_waterSurface->endBake();
+        }
+
+        return baked;
+    }
+
+    // Places grass and trees of the grid into the back instance buffers from the resident vertices, row major
+    // The cell grid keeps trees apart across chunks, so the placement only restarts with a new target
+    void placeInstances(const glm::vec2 &gridStartPos) {
+        const int chunkCount = XZ_CHUNK_AMOUNT * XZ_CHUNK_AMOUNT;
+        bool buffersBound = false;
+
+        while (m_staging.placedChunks < chunkCount) {
+            const int row = m_staging.placedChunks / XZ_CHUNK_AMOUNT;
+            const int column = m_staging.placedChunks % XZ_CHUNK_AMOUNT;
+            const int lod = calculateLod(row, column);
+
+            if (!m_generationBudget.fits(lod, ChunkWork::INSTANCES)) {
+                break;
+            }
+
+            if (!buffersBound) {
+                bindComputeBuffers();
+                m_instancingManager->bindPlacementBuffers();
                 m_instancingManager->setComputeShaderOffsetUniforms();
+                setComputeSurfaceUniforms(getActiveHeightmap());
+                m_terrainComputeShader.setInt("u_useCachedVertices", true);
+                m_terrainComputeShader.setInt("u_placeInstances", true);
+                buffersBound = true;
+            }
+
+            const TerrainChunk chunk = createChunk(gridStartPos, row, column);
+            const int poolSlot = m_chunkPool->peek(getChunkCacheKey(gridStartPos, row, column).hash());
+
+            m_terrainComputeShader.setVec2f("u_chunkOffset", chunk.globalPos);
+            m_terrainComputeShader.setVec2f("u_chunkLocalGridPos", chunk.localGridPos);
+            m_terrainComputeShader.setInt("u_stepSize", (int) chunk.gridSpacing);
 
-                for (uint offset = 0; offset < amountVertices; offset += verticesPerDispatch) {
-                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-                    uint count = std::min(verticesPerDispatch, (amountVertices - offset));
-                    uint numGroups = (count + workGroupSize - 1) / workGroupSize;
+            m_generationBudget.beginChunk(lod, ChunkWork::INSTANCES);
+            dispatchChunkVertices(chunk.bufferPos.vertexOffset, m_chunkPool->getVertexOffset(poolSlot),
+                                  chunk.bufferPos.vertexCount);
+            m_generationBudget.endChunk();
 
-                    m_terrainComputeShader.setInt("u_bufferOffset", baseOffset + offset);
-                    m_terrainComputeShader.setInt("u_count", count);
+            m_staging.placedChunks++;
+        }
+
+        if (!buffersBound) {
+            return;
+        }
+
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0);
+
+        if (m_staging.placedChunks == chunkCount) {
+            m_instancingManager->endPlacement();
+        }
+    }
+
+    // Every chunk of the target grid is resident, baked and placed, draw it from now on
+    void swapGrid(const glm::vec2 &gridStartPos) {
+        const int cellsPerAxis = boundsCellsPerAxis();
+        const int cellsPerChunk = cellsPerAxis * cellsPerAxis;
+        HeightBounds gridBounds = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+        std::vector<TerrainRaycastTile> raycastTiles;
+        std::vector<int> poolSlots(XZ_CHUNK_AMOUNT * XZ_CHUNK_AMOUNT);
 
-                    glDispatchCompute(numGroups, 1, 1);
-                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        for (int row = 0; row < XZ_CHUNK_AMOUNT; row++) {
+            for (int column = 0; column < XZ_CHUNK_AMOUNT; column++) {
+                const int poolSlot = m_chunkPool->find(getChunkCacheKey(gridStartPos, row, column).hash());
+                const std::vector<GLuint> &bounds = m_chunkPool->getBounds(poolSlot);
+
+                std::vector<HeightBounds> cells(cellsPerChunk);
+                for (int cell = 0; cell < cellsPerChunk; cell++) {
+                    cells[cell] = {decodeOrderedBits(bounds[cell * 2]), decodeOrderedBits(bounds[cell * 2 + 1])};
                 }
 
-                m_instancingManager->prepareAtomicCounterFetching();
+                TerrainChunk chunk = createChunk(gridStartPos, row, column);
+                chunk.dataOffset = m_chunkPool->getVertexOffset(poolSlot);
+                chunk.heightPyramid = HeightPyramid{std::move(cells), cellsPerAxis};
+
+                raycastTiles.push_back({chunk.heightPyramid, chunk.gridSpacing});
+
+                const HeightBounds chunkBounds = chunk.heightPyramid.getBounds();
+                gridBounds.min = std::min(gridBounds.min, chunkBounds.min);
+                gridBounds.max = std::max(gridBounds.max, chunkBounds.max);
+
+                m_terrainGrid[row][column] = std::move(chunk);
+                poolSlots[row * XZ_CHUNK_AMOUNT + column] = poolSlot;
             }
         }
+
+        m_gridPoolSlots = poolSlots;
+        m_gridCenterKeyHash = getChunkCacheKey(gridStartPos, 2, 2).hash();
+        m_gridParams = m_activeParams;
+        m_gridHeightmap = getActiveHeightmap();
+        m_gridHeightBounds = gridBounds;
+        m_raycaster.setTiles(m_gridParams, m_gridHeightmap, gridStartPos, static_cast<float>(m_chunkSize),
+                             XZ_CHUNK_AMOUNT, std::move(raycastTiles));
+
+        m_instancingManager->swapPlacement();
+        m_waterSurface->setGrid(m_terrainGrid, poolSlots);
+
+        m_staging.active = false;
+        m_recenterPending = false;
     }
 };
 
@@ -0,0 +1,80 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINNOISE_H
+#define TERRAINNOISE_H
+#include <glm/glm.hpp>
+
+#include "HeightPyramid.h"
+#include "SimplexNoise.h"
+
+// Snapshot of the terrain noise parameters, safe to hand to worker threads
+struct TerrainNoiseParams {
+    float terrainHeight;
+    int octaves;
+    float scale;
+    float persistance;
+    float lucunarity;
+
+    bool operator==(const TerrainNoiseParams &other) const {
+        return terrainHeight == other.terrainHeight && octaves == other.octaves && scale == other.scale &&
+               persistance == other.persistance && lucunarity == other.lucunarity;
+    }
+
+    bool operator!=(const TerrainNoiseParams &other) const {
+        return !(*this == other);
+    }
+};
+
+// CPU side of the fBm the terrain shaders evaluate
+class TerrainNoise {
+public:
+    static constexpr float GRADIENT_BOUND = 8.0f; // Max slope of SimplexNoise::snoise, measured around 7.2
+
+    static float getHeight(const TerrainNoiseParams &params, const glm::vec2 &xzPos) {
+        float noiseHeight = 0.0f;
+        float amplitude = 1.0f;
+        float frequency = 1.0f;
+
+        for (int i = 0; i < params.octaves; i++) {
+            noiseHeight += amplitude * SimplexNoise::snoise(xzPos / (params.scale * frequency));
+            amplitude *= params.persistance;
+            frequency *= params.lucunarity;
+        }
+
+        return params.terrainHeight * (noiseHeight + 1.0f) * 0.5f;
+    }
+
+    // Every octave spans [-amplitude, amplitude]
+    static HeightBounds getHeightRange(const TerrainNoiseParams &params) {
+        float amplitudeSum = 0.0f;
+        float amplitude = 1.0f;
+        for (int i = 0; i < params.octaves; i++) {
+            amplitudeSum += amplitude;
+            amplitude *= params.persistance;
+        }
+
+        return {
+            params.terrainHeight * (1.0f - amplitudeSum) * 0.5f,
+            params.terrainHeight * (1.0f + amplitudeSum) * 0.5f
+        };
+    }
+
+    // Max height change per horizontal world unit
+    // Every octave adds at most amplitude * GRADIENT_BOUND / wavelength of slope
+    static float getMaxSlope(const TerrainNoiseParams &params) {
+        float slope = 0.0f;
+        float amplitude = 1.0f;
+        float frequency = 1.0f;
+        for (int i = 0; i < params.octaves; i++) {
+            slope += amplitude * GRADIENT_BOUND / (params.scale * frequency);
+            amplitude *= params.persistance;
+            frequency *= params.lucunarity;
+        }
+
+        return params.terrainHeight * 0.5f * slope;
+    }
+};
+
+#endif //TERRAINNOISE_H
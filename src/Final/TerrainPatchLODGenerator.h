@@ -10,6 +10,7 @@
 #include <GL/glext.h>
 
 #include "../../Linking/include/glad/glad.h"
+#include "../MeshOptimizer.h"
 
 enum class STITCHED_EDGE {
     NONE = 0,
@@ -20,7 +21,7 @@ enum class STITCHED_EDGE {
 };
 
 struct TerrainBufferHandles {
-    GLuint SSBO;
+    GLuint templateSSBO; // Packed XZ positions of the patch templates, static
     GLuint VAO;
 };
 
@@ -41,12 +42,10 @@ struct LODBufferPos {
     std::unordered_map<STITCHED_EDGE, LODMeshBufferPos> stitchedMeshes;
 };
 
-// Respects GPU memory alignment
-struct VertexData {
-    glm::vec3 pos;
-    float padding;
-    glm::vec3 normal;
-    float paddding2;
+// Only height and normal depend on the terrain, XZ come from the patch template (std430, 8 bytes)
+struct TerrainVertexData {
+    GLfloat height;
+    GLuint normal; // Octahedron encoded, packSnorm2x16
 };
 
 struct MeshBufferPosition {
@@ -64,7 +63,7 @@ struct MeshBufferDescriptor {
 };
 
 struct MeshBufferInfo {
-    std::vector<VertexData> vertexBuffer;
+    std::vector<GLuint> templateBuffer; // XZ per vertex, see packTemplatePosition
     std::vector<GLuint> indexBuffer;
     uint totalVertexCount;
     std::vector<MeshBufferDescriptor> meshes;
@@ -92,6 +91,18 @@ struct TerrainPatchHandle {
 
 class TerrainPatchLODGenerator {
 public:
+    // Stitching puts vertices on half steps, template positions are stored in half units
+    static constexpr float TEMPLATE_POSITION_SCALE = 2.0f;
+    static constexpr GLuint TEMPLATE_SSBO_BINDING = 6;
+
+    // 16 bit x | 16 bit z, chunk sizes up to 32767
+    static GLuint packTemplatePosition(GLfloat x, GLfloat z) {
+        const auto packedX = static_cast<GLuint>(x * TEMPLATE_POSITION_SCALE);
+        const auto packedZ = static_cast<GLuint>(z * TEMPLATE_POSITION_SCALE);
+
+        return (packedX & 0xFFFFu) | (packedZ << 16);
+    }
+
     static TerrainPatch generateBasePatch(const int basePatchSize, const int lodLevel) {
         TerrainPatch patch;
         patch.basePatchSize = basePatchSize;
@@ -299,6 +310,15 @@ public:
         return std::move(indices);
     }
 
+    // Row order triangulation thrashes the vertex cache, reorder triangles and vertices for it
+    // Heights are generated later on the GPU, so there is nothing to sort for overdraw
+    static void optimizePatch(std::vector<GLfloat> &vertexBuffer, std::vector<GLuint> &indices) {
+        const auto vertexCount = static_cast<std::uint32_t>(vertexBuffer.size() / 2);
+
+        indices = MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+        MeshOptimizer::optimizeVertexFetch(vertexBuffer, 2, indices);
+    }
+
     static std::vector<GLfloat> generateVertexBuffer(const TerrainPatch &patch) {
         std::vector<GLfloat> buffer;
 
@@ -323,17 +343,14 @@ public:
 
     static MeshBufferInfo generateMultiMeshBuffer(const int meshBaseSize, const std::vector<std::pair<int, STITCHED_EDGE>> &meshes) {
         MeshBufferInfo bufferInfo;
-        std::vector<VertexData> vertexBuffer;
+        std::vector<GLuint> templateBuffer;
         std::vector<GLuint> indexBuffer;
         uint totalVertexCount = 0;
 
         auto insertMeshVertexData = [&](const std::vector<GLfloat> &toInsert) -> uint {
-            uint startIndex = vertexBuffer.size();
+            uint startIndex = templateBuffer.size();
             for (int index = 0; index < toInsert.size(); index += 2) {
-                vertexBuffer.push_back({
-                    {toInsert[index], 0.0f, toInsert[index + 1]},
-                    0.0f, {0.0f, 0.0f, 0.0f}, 0.0f
-                });
+                templateBuffer.push_back(packTemplatePosition(toInsert[index], toInsert[index + 1]));
             }
 
             totalVertexCount += toInsert.size() / 2;
@@ -358,6 +375,7 @@ public:
 
             std::vector<GLfloat> vertexAttribBuffer = generateVertexBuffer(patch);
             std::vector<GLuint> meshIndexBuffer = triangulatePatch(patch);
+            optimizePatch(vertexAttribBuffer, meshIndexBuffer);
 
             uint baseVertexOffset = insertMeshVertexData(vertexAttribBuffer);
             uint baseIndexOffset = insertIndexData(meshIndexBuffer, baseVertexOffset);
@@ -377,7 +395,7 @@ public:
             });
         }
 
-        bufferInfo.vertexBuffer = std::move(vertexBuffer);
+        bufferInfo.templateBuffer = std::move(templateBuffer);
         bufferInfo.indexBuffer = std::move(indexBuffer);
         bufferInfo.totalVertexCount = totalVertexCount;
 
@@ -399,20 +417,17 @@ public:
         return VAO;
     }
 
-    // Accessible by vertex/fragment shaders, modified by the compute shader
-    static GLuint generateMultiLODBufferSSBOHandle(const MeshBufferInfo &bufferInfo) {
+    // Read by the compute and vertex shader, never changes
+    static GLuint generateMultiLODTemplateSSBOHandle(const MeshBufferInfo &bufferInfo) {
         GLuint SSBO;
         glGenBuffers(1, &SSBO);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
 
         glBufferData(GL_SHADER_STORAGE_BUFFER,
-                     bufferInfo.vertexBuffer.size() * sizeof(VertexData),
-                     bufferInfo.vertexBuffer.data(),
-                     GL_DYNAMIC_DRAW);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, SSBO);
+                     bufferInfo.templateBuffer.size() * sizeof(GLuint),
+                     bufferInfo.templateBuffer.data(),
+                     GL_STATIC_DRAW);
 
-        // Unbind both the base and the buffer
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
         return SSBO;
@@ -432,8 +447,8 @@ public:
     static TerrainBufferHandles generateTerrainBufferHandles(const MeshBufferInfo &bufferInfo) {
         TerrainBufferHandles handles;
 
-        // SSBO
-        handles.SSBO = generateMultiLODBufferSSBOHandle(bufferInfo);
+        // SSBO, the vertex data itself lives in TerrainChunkPool
+        handles.templateSSBO = generateMultiLODTemplateSSBOHandle(bufferInfo);
 
         // Generate EBO
         // Automatically bound by the VAO
@@ -454,6 +469,8 @@ public:
 
         // VBO
         std::vector<GLfloat> vertexBuffer = generateVertexBuffer(patch);
+        std::vector<GLuint> ebo = triangulatePatch(patch);
+        optimizePatch(vertexBuffer, ebo);
         glGenBuffers(1, &VBO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertexBuffer.size() * sizeof(GLfloat), vertexBuffer.data(), GL_STATIC_DRAW);
@@ -462,7 +479,6 @@ public:
         glEnableVertexAttribArray(0); // Enable the attribute
 
         // EBO
-        std::vector<GLuint> ebo = triangulatePatch(patch);
         glGenBuffers(1, &EBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, ebo.size() * sizeof(GLuint), ebo.data(), GL_STATIC_DRAW);
@@ -0,0 +1,364 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINRAYCASTER_H
+#define TERRAINRAYCASTER_H
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BakedHeightmap.h"
+#include "HeightPyramid.h"
+#include "TerrainNoise.h"
+#include "../ThreadPool.h"
+
+struct TerrainRay {
+    glm::vec3 origin;
+    glm::vec3 direction; // Does not have to be normalized
+    float maxDistance;
+};
+
+struct TerrainRayHit {
+    bool hit;
+    float distance; // Along the normalized direction
+    glm::vec3 position;
+};
+
+// Height bounds of one tile, the pyramid spans the whole tile
+struct TerrainRaycastTile {
+    HeightPyramid pyramid; // Empty tiles are traversed like the area outside the grid
+    float sampleSpacing; // Distance of the samples the bounds were reduced from
+};
+
+// Ray queries against the exact terrain noise, or the bilinear surface of a baked heightmap
+// Flow
+// 1. The ray gets clipped to the height range the surface can reach at all
+// 2. Inside the tile grid the min/max pyramids are traversed top down, cells the ray passes above get skipped whole
+//   -> Bounds only contain the samples, a Lipschitz margin covers the surface in between
+// 3. Only level 0 cells the ray may touch evaluate the surface, stepping by the largest distance that can't cross it
+//   -> Outside the grid or in tiles without bounds the same stepping runs on the global range
+// 4. The first step below the surface gets bisected down to HIT_TOLERANCE
+class TerrainRaycaster {
+public:
+    static constexpr float HIT_TOLERANCE = 0.01f;
+    static constexpr float MIN_STEP = 0.02f; // Keeps grazing rays from stalling
+    static constexpr int BATCH_SIZE = 256; // Rays per worker task
+
+    // Tiles in row major order starting at origin, pyramids have to be built from the given surface
+    void setTiles(const TerrainNoiseParams &params, const BakedHeightmap *heightmap, const glm::vec2 &origin,
+                  const float tileSize, const int tilesPerAxis, std::vector<TerrainRaycastTile> tiles) {
+        setSurface(params, heightmap);
+        m_origin = origin;
+        m_tileSize = tileSize;
+        m_tilesPerAxis = tilesPerAxis;
+        m_tiles = std::move(tiles);
+    }
+
+    // Drops the tiles once the surface differs from the one they were built from
+    // Without a heightmap the noise is evaluated, with one only the terrain height of the parameters is used
+    void setSurface(const TerrainNoiseParams &params, const BakedHeightmap *heightmap) {
+        if (params == m_params && heightmap == m_heightmap) {
+            return;
+        }
+
+        m_params = params;
+        m_heightmap = heightmap;
+        m_tiles.clear();
+        m_tilesPerAxis = 0;
+
+        if (heightmap) {
+            const HeightBounds bounds = heightmap->getBounds();
+            m_lipschitz = params.terrainHeight * heightmap->getMaxSlope();
+            m_globalBounds = {params.terrainHeight * bounds.min, params.terrainHeight * bounds.max};
+            return;
+        }
+
+        m_lipschitz = TerrainNoise::getMaxSlope(params);
+        m_globalBounds = TerrainNoise::getHeightRange(params);
+    }
+
+    [[nodiscard]] TerrainRayHit raycast(const TerrainRay &ray) const {
+        const TerrainRayHit miss = {false, ray.maxDistance, glm::vec3{0.0f}};
+        const float length = glm::length(ray.direction);
+        if (length == 0.0f || (!m_heightmap && m_params.octaves <= 0)) {
+            return miss;
+        }
+
+        const RayState state = {ray.origin, ray.direction / length};
+
+        // Nothing to hit above the highest or below the lowest possible height
+        float tStart = 0.0f;
+        float tEnd = ray.maxDistance;
+        if (!clipSlab(state.origin.y, state.direction.y, m_globalBounds.min, m_globalBounds.max, tStart, tEnd)) {
+            // A ray fully below the terrain starts inside of it
+            return state.origin.y < m_globalBounds.min ? TerrainRayHit{true, 0.0f, state.origin} : miss;
+        }
+
+        float tGridStart = tStart;
+        float tGridEnd = tEnd;
+        const glm::vec2 gridEnd = m_origin + m_tileSize * static_cast<float>(m_tilesPerAxis);
+        const bool crossesGrid = m_tilesPerAxis > 0 &&
+                                 clipSlab(state.origin.x, state.direction.x, m_origin.x, gridEnd.x, tGridStart,
+                                          tGridEnd) &&
+                                 clipSlab(state.origin.z, state.direction.z, m_origin.y, gridEnd.y, tGridStart,
+                                          tGridEnd);
+
+        float hitDistance;
+        if (!crossesGrid) {
+            if (marchExact(state, tStart, tEnd, m_globalBounds, hitDistance)) {
+                return makeHit(state, hitDistance);
+            }
+            return miss;
+        }
+
+        if (marchExact(state, tStart, tGridStart, m_globalBounds, hitDistance) ||
+            traverseGrid(state, tGridStart, tGridEnd, hitDistance) ||
+            marchExact(state, tGridEnd, tEnd, m_globalBounds, hitDistance)) {
+            return makeHit(state, hitDistance);
+        }
+
+        return miss;
+    }
+
+    // Results in ray order, the batches run on the shared worker pool
+    // Must not be called from one of its workers, the wait would block the pool
+    [[nodiscard]] std::vector<TerrainRayHit> raycast(const std::vector<TerrainRay> &rays,
+                                                     const bool multithreaded = true) const {
+        std::vector<TerrainRayHit> hits(rays.size());
+
+        if (!multithreaded || rays.size() <= BATCH_SIZE) {
+            for (std::size_t i = 0; i < rays.size(); i++) {
+                hits[i] = raycast(rays[i]);
+            }
+            return hits;
+        }
+
+        std::vector<std::future<void> > batches;
+        for (std::size_t first = 0; first < rays.size(); first += BATCH_SIZE) {
+            const std::size_t last = std::min(first + BATCH_SIZE, rays.size());
+
+            batches.push_back(ThreadPool::decodePool().submit([this, &rays, &hits, first, last] {
+                for (std::size_t i = first; i < last; i++) {
+                    hits[i] = raycast(rays[i]);
+                }
+            }));
+        }
+
+        for (std::future<void> &batch: batches) {
+            batch.get();
+        }
+
+        return hits;
+    }
+
+    // Bounds from noise samples, for areas that have no generated chunk to take them from
+    static TerrainRaycastTile buildTile(const TerrainNoiseParams &params, const glm::vec2 &origin,
+                                        const float tileSize, const int cellCount) {
+        const float spacing = tileSize / static_cast<float>(cellCount);
+        std::vector<float> samples((cellCount + 1) * (cellCount + 1));
+
+        for (int z = 0; z <= cellCount; z++) {
+            for (int x = 0; x <= cellCount; x++) {
+                const glm::vec2 xzPos = origin + glm::vec2(x, z) * spacing;
+                samples[z * (cellCount + 1) + x] = TerrainNoise::getHeight(params, xzPos);
+            }
+        }
+
+        return {HeightPyramid{samples, cellCount}, spacing};
+    }
+
+    [[nodiscard]] const TerrainNoiseParams &getParams() const {
+        return m_params;
+    }
+
+private:
+    struct RayState {
+        glm::vec3 origin;
+        glm::vec3 direction; // Normalized
+    };
+
+    TerrainNoiseParams m_params{0.0f, 0, 0.0f, 0.0f, 0.0f};
+    const BakedHeightmap *m_heightmap{nullptr};
+    float m_lipschitz{0.0f}; // Max height change per horizontal world unit
+    HeightBounds m_globalBounds{0.0f, 0.0f};
+
+    glm::vec2 m_origin{0.0f};
+    float m_tileSize{0.0f};
+    int m_tilesPerAxis{0};
+    std::vector<TerrainRaycastTile> m_tiles;
+
+    [[nodiscard]] float getSurfaceHeight(const glm::vec2 &xzPos) const {
+        return m_heightmap
+                   ? m_params.terrainHeight * m_heightmap->getHeight(xzPos)
+                   : TerrainNoise::getHeight(m_params, xzPos);
+    }
+
+    static TerrainRayHit makeHit(const RayState &state, const float distance) {
+        return {true, distance, state.origin + state.direction * distance};
+    }
+
+    // Narrows [tMin, tMax] to where origin + t * direction lies within [low, high] on one axis
+    static bool clipSlab(const float origin, const float direction, const float low, const float high,
+                         float &tMin, float &tMax) {
+        if (direction == 0.0f) {
+            return origin >= low && origin <= high && tMin <= tMax;
+        }
+
+        float tLow = (low - origin) / direction;
+        float tHigh = (high - origin) / direction;
+        if (tLow > tHigh) {
+            std::swap(tLow, tHigh);
+        }
+
+        tMin = std::max(tMin, tLow);
+        tMax = std::min(tMax, tHigh);
+        return tMin <= tMax;
+    }
+
+    // Distance until the ray leaves the cell on the x or z axis
+    static float cellExit(const RayState &state, const glm::vec2 &cellOrigin, const float cellSize) {
+        float tExit = std::numeric_limits<float>::max();
+
+        if (state.direction.x != 0.0f) {
+            const float boundary = cellOrigin.x + (state.direction.x > 0.0f ? cellSize : 0.0f);
+            tExit = std::min(tExit, (boundary - state.origin.x) / state.direction.x);
+        }
+
+        if (state.direction.z != 0.0f) {
+            const float boundary = cellOrigin.y + (state.direction.z > 0.0f ? cellSize : 0.0f);
+            tExit = std::min(tExit, (boundary - state.origin.z) / state.direction.z);
+        }
+
+        return tExit;
+    }
+
+    // Cell the ray is in right after t, nudged so boundaries resolve in ray direction
+    static glm::ivec2 cellAt(const RayState &state, const float t, const glm::vec2 &origin, const float cellSize) {
+        const glm::vec3 pos = state.origin + state.direction * (t + HIT_TOLERANCE * 0.1f);
+        return {
+            static_cast<int>(std::floor((pos.x - origin.x) / cellSize)),
+            static_cast<int>(std::floor((pos.z - origin.y) / cellSize))
+        };
+    }
+
+    [[nodiscard]] bool traverseGrid(const RayState &state, float t, const float tEnd, float &hitDistance) const {
+        while (t < tEnd) {
+            glm::ivec2 tile = cellAt(state, t, m_origin, m_tileSize);
+            tile = glm::clamp(tile, glm::ivec2{0}, glm::ivec2{m_tilesPerAxis - 1});
+
+            const glm::vec2 tileOrigin = m_origin + glm::vec2(tile) * m_tileSize;
+            const float tTileEnd = std::min(tEnd, std::max(cellExit(state, tileOrigin, m_tileSize), t));
+            const TerrainRaycastTile &rayTile = m_tiles[tile.y * m_tilesPerAxis + tile.x];
+
+            const bool hit = rayTile.pyramid.isEmpty()
+                                 ? marchExact(state, t, tTileEnd, m_globalBounds, hitDistance)
+                                 : traverseTile(state, rayTile, tileOrigin, t, tTileEnd, hitDistance);
+            if (hit) {
+                return true;
+            }
+
+            t = tTileEnd + (tTileEnd <= t ? HIT_TOLERANCE : 0.0f);
+        }
+
+        return false;
+    }
+
+    // Top down through the pyramid, after a skipped cell it continues one level up
+    [[nodiscard]] bool traverseTile(const RayState &state, const TerrainRaycastTile &tile, const glm::vec2 &tileOrigin,
+                                    float t, const float tEnd, float &hitDistance) const {
+        const HeightPyramid &pyramid = tile.pyramid;
+        const int topLevel = pyramid.getLevelCount() - 1;
+        const float baseCellSize = m_tileSize / static_cast<float>(pyramid.getCellCount(0));
+        const float margin = m_lipschitz * tile.sampleSpacing; // Covers every point within a sample spacing
+
+        int level = topLevel;
+        while (t < tEnd) {
+            const float cellSize = baseCellSize * static_cast<float>(1 << level);
+            const int cellCount = pyramid.getCellCount(level);
+            const glm::ivec2 cell = glm::clamp(cellAt(state, t, tileOrigin, cellSize), glm::ivec2{0},
+                                               glm::ivec2{cellCount - 1});
+
+            const glm::vec2 cellOrigin = tileOrigin + glm::vec2(cell) * cellSize;
+            const float tCellEnd = std::min(tEnd, std::max(cellExit(state, cellOrigin, cellSize), t));
+
+            HeightBounds bounds = pyramid.getBounds(level, cell.x, cell.y);
+            bounds = {
+                std::max(bounds.min - margin, m_globalBounds.min),
+                std::min(bounds.max + margin, m_globalBounds.max)
+            };
+
+            // Only the lowest point of the ray inside the cell matters, below the surface is a hit as well
+            const float lowestY = std::min(state.origin.y + state.direction.y * t,
+                                           state.origin.y + state.direction.y * tCellEnd);
+
+            if (lowestY > bounds.max) {
+                t = tCellEnd + (tCellEnd <= t ? HIT_TOLERANCE : 0.0f);
+                level = std::min(level + 1, topLevel);
+            } else if (level > 0) {
+                level--;
+            } else {
+                if (marchExact(state, t, tCellEnd, bounds, hitDistance)) {
+                    return true;
+                }
+
+                t = tCellEnd + (tCellEnd <= t ? HIT_TOLERANCE : 0.0f);
+                level = std::min(level + 1, topLevel);
+            }
+        }
+
+        return false;
+    }
+
+    // Steps can't cross the surface: the gap to it shrinks by at most |direction.y| + L * |direction.xz| per unit
+    [[nodiscard]] bool marchExact(const RayState &state, float t, const float tEnd, const HeightBounds &bounds,
+                                  float &hitDistance) const {
+        const float horizontal = glm::length(glm::vec2{state.direction.x, state.direction.z});
+        const float closingRate = std::abs(state.direction.y) + m_lipschitz * horizontal;
+        float tPrevious = t;
+
+        while (t <= tEnd) {
+            const glm::vec3 pos = state.origin + state.direction * t;
+
+            // Above the cell bounds no noise is needed, the gap to them is a safe step as well
+            const float gap = pos.y > bounds.max
+                                  ? pos.y - bounds.max
+                                  : pos.y - getSurfaceHeight(glm::vec2{pos.x, pos.z});
+
+            if (gap <= 0.0f) {
+                hitDistance = t == tPrevious ? t : bisect(state, tPrevious, t);
+                return true;
+            }
+
+            if (t == tEnd) {
+                break;
+            }
+
+            tPrevious = t;
+            t = std::min(tEnd, t + std::max(gap / closingRate, MIN_STEP));
+        }
+
+        return false;
+    }
+
+    // Above the surface at tAbove, on or below it at tBelow
+    [[nodiscard]] float bisect(const RayState &state, float tAbove, float tBelow) const {
+        while (tBelow - tAbove > HIT_TOLERANCE) {
+            const float tMid = 0.5f * (tAbove + tBelow);
+            const glm::vec3 pos = state.origin + state.direction * tMid;
+
+            if (pos.y > getSurfaceHeight(glm::vec2{pos.x, pos.z})) {
+                tAbove = tMid;
+            } else {
+                tBelow = tMid;
+            }
+        }
+
+        return tBelow;
+    }
+};
+
+#endif //TERRAINRAYCASTER_H
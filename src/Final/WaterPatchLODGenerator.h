@@ -0,0 +1,113 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef WATERPATCHLODGENERATOR_H
+#define WATERPATCHLODGENERATOR_H
+#include <array>
+#include <cstdlib>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../GeometryUtils.h"
+
+struct WaterLODMeshDescriptor {
+    int lod;
+    int spacing; // Distance between vertices
+    GLint baseVertex;
+    GLuint indexOffset;
+    GLuint indexCount;
+    GLuint vertexCount;
+};
+
+struct WaterLODMeshBuffer {
+    std::vector<GLfloat> vertexBuffer; // XZ, TexCoord
+    std::vector<GLuint> indexBuffer; // Relative to the base vertex of each mesh
+    std::vector<WaterLODMeshDescriptor> meshes;
+};
+
+struct WaterLODStats {
+    GLuint tileCount;
+    GLuint vertexCount;
+    GLuint triangleCount;
+};
+
+// Water tiles all share the same size, only the vertex spacing changes per LOD
+// LOD selection is based on the ring distance (in tiles) to the tile the camera is in
+//  Ring 0 - 1 -> LOD 0, Ring 2 - 3 -> LOD 1, Ring 4 - 7 -> LOD 2, Ring 8+ -> LOD 3
+// Neighbouring tiles never differ by more than one LOD, cracks get closed in the vertex shader
+class WaterPatchLODGenerator {
+public:
+    static constexpr int LOD_COUNT = 4;
+
+    static WaterLODMeshBuffer generateLODMeshBuffer(const int tileSize, const int baseSpacing) {
+        WaterLODMeshBuffer buffer;
+
+        for (int lod = 0; lod < LOD_COUNT; lod++) {
+            const int spacing = baseSpacing << lod;
+            const int verticesPerAxis = tileSize / spacing + 1;
+
+            geometry_utils::TriangulatedPlaneMesh mesh =
+                    geometry_utils::generateTriangulatedPlaneMesh(verticesPerAxis, spacing, false);
+
+            WaterLODMeshDescriptor descriptor = {
+                lod,
+                spacing,
+                static_cast<GLint>(buffer.vertexBuffer.size() / 4), // 4 GLfloats per vertex
+                static_cast<GLuint>(buffer.indexBuffer.size()),
+                static_cast<GLuint>(mesh.indices.size()),
+                static_cast<GLuint>(mesh.vertices.size() / 4)
+            };
+
+            buffer.vertexBuffer.insert(buffer.vertexBuffer.end(), mesh.vertices.begin(), mesh.vertices.end());
+            buffer.indexBuffer.insert(buffer.indexBuffer.end(), mesh.indices.begin(), mesh.indices.end());
+            buffer.meshes.push_back(descriptor);
+        }
+
+        return buffer;
+    }
+
+    static int calculateLod(const glm::ivec2 &tile, const glm::ivec2 &cameraTile) {
+        const int ring = std::max(std::abs(tile.x - cameraTile.x), std::abs(tile.y - cameraTile.y));
+
+        if (ring <= 1) {
+            return 0;
+        }
+
+        // floor(log2(ring))
+        int lod = 0;
+        while ((2 << lod) <= ring) {
+            lod++;
+        }
+
+        return std::min(lod, LOD_COUNT - 1);
+    }
+
+    // Left (-X), right (+X), top (-Z), bottom (+Z)
+    static glm::ivec4 calculateNeighbourLods(const glm::ivec2 &tile, const glm::ivec2 &cameraTile) {
+        return {
+            calculateLod(tile + glm::ivec2{-1, 0}, cameraTile),
+            calculateLod(tile + glm::ivec2{1, 0}, cameraTile),
+            calculateLod(tile + glm::ivec2{0, -1}, cameraTile),
+            calculateLod(tile + glm::ivec2{0, 1}, cameraTile)
+        };
+    }
+
+    static WaterLODStats calculateStats(const WaterLODMeshBuffer &buffer,
+                                        const std::array<GLuint, LOD_COUNT> &tilesPerLod) {
+        WaterLODStats stats{0, 0, 0};
+
+        for (const WaterLODMeshDescriptor &mesh: buffer.meshes) {
+            const GLuint tiles = tilesPerLod[mesh.lod];
+
+            stats.tileCount += tiles;
+            stats.vertexCount += tiles * mesh.vertexCount;
+            stats.triangleCount += tiles * (mesh.indexCount / 3);
+        }
+
+        return stats;
+    }
+};
+
+
+#endif //WATERPATCHLODGENERATOR_H
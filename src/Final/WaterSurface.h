@@ -0,0 +1,398 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef WATERSURFACE_H
+#define WATERSURFACE_H
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "TerrainChunk.h"
+#include "TerrainNoise.h"
+#include "WaterPatchLODGenerator.h"
+#include "../ComputeShader.h"
+#include "../GeometryUtils.h"
+#include "../Shaders/WaterShader/WaterShaderProgram.h"
+
+
+// Water is only drawn where the terrain is actually below the water line
+// Flow
+// 1. Bake a normalized height mask per chunk into the layer of its pool slot, a few chunks per batch
+//   -> The bake also tracks the lowest height of every water tile
+// 2. Once a batch is done on the GPU, read back the tile heights of its layers
+// 3. setGrid with the layers of the new grid, tiles below the cutoff become instances of a small tile mesh
+// 4. Each frame the tiles get a LOD based on their distance to the camera
+//   -> One instanced draw call per LOD, the water shader samples the mask and stitches LOD borders
+class WaterSurface {
+public:
+    static constexpr int TILES_PER_CHUNK_AXIS = 4;
+    static constexpr int MASK_SPACING = 2; // World units between mask texels, also the water vertex spacing
+    static constexpr float WATER_CUTOFF_HEIGHT = 0.15f; // Normalized terrain height above which no water is drawn
+
+    static constexpr int TILES_PER_CHUNK = TILES_PER_CHUNK_AXIS * TILES_PER_CHUNK_AXIS;
+
+    // One mask layer per terrain chunk pool slot, a grid uses chunkAmount^2 of them
+    WaterSurface(const int chunkSize, const int chunkAmount, const int layerCount, WaterShaderProgram &waterShader)
+        : m_chunkSize(chunkSize),
+          m_chunkAmount(chunkAmount),
+          m_layerCount(layerCount),
+          m_tileSize(chunkSize / TILES_PER_CHUNK_AXIS),
+          m_maskSize(chunkSize / MASK_SPACING + 1),
+          m_waterShader(waterShader),
+          m_bakeComputeShader{"../src/Shaders/WaterShader/shader.compute"},
+          m_layers(layerCount) {
+        createTileMeshes();
+        createMaskTexture();
+        createTileBuffers();
+    }
+
+    void setEnvironmentMap(GLuint cubeMapHandle) {
+        m_environmentMap = cubeMapHandle;
+    }
+
+    // Starts a batch of chunk bakes, bakedHeights holds the normalized heights of the grid area, 0 bakes the noise
+    void beginBake(const TerrainNoiseParams &params, const GLuint bakedHeights, const glm::vec2 &bakedOrigin) {
+        glUseProgram(m_bakeComputeShader.getProgramId());
+
+        m_bakeComputeShader.setFloat("u_terrainHeight", params.terrainHeight);
+        m_bakeComputeShader.setFloat("u_scale", params.scale);
+        m_bakeComputeShader.setFloat("u_persistance", params.persistance);
+        m_bakeComputeShader.setFloat("u_lucunarity", params.lucunarity);
+        m_bakeComputeShader.setInt("u_octaves", params.octaves);
+        m_bakeComputeShader.setInt("u_maskSize", m_maskSize);
+        m_bakeComputeShader.setInt("u_maskSpacing", MASK_SPACING);
+        m_bakeComputeShader.setInt("u_tilesPerChunkAxis", TILES_PER_CHUNK_AXIS);
+        m_bakeComputeShader.setInt("u_texelsPerTile", m_tileSize / MASK_SPACING);
+        m_bakeComputeShader.setInt("u_useBakedHeights", bakedHeights != 0);
+        m_bakeComputeShader.setVec2f("u_bakedOrigin", bakedOrigin);
+        m_bakeComputeShader.setInt("u_bakedHeights", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, bakedHeights);
+
+        glBindImageTexture(0, m_maskTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_tileHeightSSBO);
+    }
+
+    // Bakes the mask of the chunk at chunkOffset into a layer, only between beginBake and endBake
+    void bakeChunk(const int layer, const std::uint64_t keyHash, const glm::vec2 &chunkOffset) {
+        resetTileHeights(layer);
+        m_layers[layer] = {keyHash, false, {}};
+        m_bakeBatch.push_back(layer);
+
+        m_bakeComputeShader.setVec2f("u_chunkOffset", chunkOffset);
+        m_bakeComputeShader.setInt("u_layer", layer);
+
+        const uint workGroupSize = 8;
+        const uint numGroups = (m_maskSize + workGroupSize - 1) / workGroupSize;
+        glDispatchCompute(numGroups, numGroups, 1);
+    }
+
+    // Tile heights of the batch are read back once the GPU finished it, see pollBake
+    void endBake() {
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT |
+                        GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        // Unbind
+        glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+
+        m_fenceHandle = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Only one batch is in flight at a time
+    [[nodiscard]] bool isBakeInFlight() const {
+        return m_fenceHandle != nullptr;
+    }
+
+    void pollBake() {
+        if (m_fenceHandle && pollFenceState()) {
+            retrieveTileHeightsFromGPU();
+        }
+    }
+
+    // True once the layer holds the read back mask of the chunk, a reused layer belongs to another chunk
+    [[nodiscard]] bool isBaked(const int layer, const std::uint64_t keyHash) const {
+        return m_layers[layer].ready && m_layers[layer].keyHash == keyHash;
+    }
+
+    // Draws the water of a new grid, layers are the baked ones of its chunks, row * chunkAmount + column
+    void setGrid(const std::vector<std::vector<TerrainChunk> > &terrainGrid, const std::vector<int> &layers) {
+        m_underwaterTiles.clear();
+
+        for (int row = 0; row < m_chunkAmount; row++) {
+            for (int column = 0; column < m_chunkAmount; column++) {
+                const int layer = layers[row * m_chunkAmount + column];
+                if (layer < 0 || !m_layers[layer].ready) {
+                    continue;
+                }
+
+                addUnderwaterTiles(terrainGrid[row][column], layer);
+            }
+        }
+
+        m_tilesChanged = true;
+    }
+
+    void render(const glm::vec3 &camPos) {
+        const glm::ivec2 cameraTile = {
+            static_cast<int>(std::floor(camPos.x / m_tileSize)),
+            static_cast<int>(std::floor(camPos.z / m_tileSize))
+        };
+
+        // LODs only change if the camera moved into another tile
+        if (m_tilesChanged || cameraTile != m_lastCameraTile) {
+            assignTileLods(cameraTile);
+            m_lastCameraTile = cameraTile;
+            m_tilesChanged = false;
+        }
+
+        if (m_underwaterTiles.empty()) {
+            return;
+        }
+
+        m_waterShader.use();
+        m_waterShader.setInt("u_maskSpacing", MASK_SPACING);
+        m_waterShader.setInt("u_tileSize", m_tileSize);
+        m_waterShader.setFloat("u_waterCutoff", WATER_CUTOFF_HEIGHT);
+
+        m_waterShader.setInt("u_waterMask", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_maskTexture);
+
+        m_waterShader.setInt("u_skybox", 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_environmentMap);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_tileSSBO);
+        glBindVertexArray(m_tileMeshVAO);
+
+        GLuint instanceOffset = 0;
+        for (const WaterLODMeshDescriptor &mesh: m_lodMeshBuffer.meshes) {
+            const GLuint instanceCount = m_tilesPerLod[mesh.lod];
+
+            if (instanceCount > 0) {
+                // Tiles are sorted by LOD, gl_InstanceID always starts at 0 so pass the offset as uniform
+                m_waterShader.setInt("u_baseInstance", instanceOffset);
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+                                                  (void *) (mesh.indexOffset * sizeof(GLuint)),
+                                                  instanceCount, mesh.baseVertex);
+            }
+
+            instanceOffset += instanceCount;
+        }
+
+        // Cleanup
+        glBindVertexArray(0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    [[nodiscard]] GLuint getMaskTexture() const {
+        return m_maskTexture;
+    }
+
+    [[nodiscard]] const WaterLODStats &getStats() const {
+        return m_stats;
+    }
+
+private:
+    // Respects GPU memory alignment
+    struct WaterTile {
+        glm::vec2 chunkOffset;
+        glm::vec2 tileOffset; // Relative to the chunk
+        int layer;
+        int lod;
+        float minHeight;
+        float padding;
+        glm::ivec4 neighbourLods; // Left, right, top, bottom
+    };
+
+    // Chunk a mask layer got baked for, tile heights are valid once ready
+    struct MaskLayer {
+        std::uint64_t keyHash;
+        bool ready;
+        std::array<float, TILES_PER_CHUNK> tileHeights;
+    };
+
+    int m_chunkSize;
+    int m_chunkAmount;
+    int m_layerCount;
+    int m_tileSize;
+    int m_maskSize;
+    WaterShaderProgram &m_waterShader;
+    ComputeShader m_bakeComputeShader;
+
+    GLuint m_maskTexture;
+    GLuint m_environmentMap{0};
+    GLuint m_tileMeshVAO;
+    WaterLODMeshBuffer m_lodMeshBuffer;
+
+    GLuint m_tileHeightSSBO; // Min height per tile, written by the bake
+    GLuint m_tileSSBO; // Underwater tiles sorted by LOD, used as instance data
+    std::vector<WaterTile> m_underwaterTiles;
+    std::array<GLuint, WaterPatchLODGenerator::LOD_COUNT> m_tilesPerLod{};
+    glm::ivec2 m_lastCameraTile{0};
+    bool m_tilesChanged{false};
+    WaterLODStats m_stats{0, 0, 0};
+
+    std::vector<MaskLayer> m_layers;
+    GLsync m_fenceHandle{nullptr};
+    std::vector<int> m_bakeBatch; // Layers of the batch in flight
+
+    [[nodiscard]] int totalTileCount() const {
+        return m_layerCount * TILES_PER_CHUNK;
+    }
+
+    // Tiles a grid draws at most
+    [[nodiscard]] int gridTileCount() const {
+        return m_chunkAmount * m_chunkAmount * TILES_PER_CHUNK;
+    }
+
+    void createTileMeshes() {
+        // LOD 0 has the same vertex density as the mask, every vertex maps to exactly one texel
+        m_lodMeshBuffer = WaterPatchLODGenerator::generateLODMeshBuffer(m_tileSize, MASK_SPACING);
+
+        GLuint VBO, EBO;
+        glGenVertexArrays(1, &m_tileMeshVAO);
+        glBindVertexArray(m_tileMeshVAO);
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, m_lodMeshBuffer.vertexBuffer.size() * sizeof(GLfloat),
+                     m_lodMeshBuffer.vertexBuffer.data(), GL_STATIC_DRAW);
+
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_lodMeshBuffer.indexBuffer.size() * sizeof(GLuint),
+                     m_lodMeshBuffer.indexBuffer.data(), GL_STATIC_DRAW);
+
+        // XZ Coord, TexCoord
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void *) nullptr);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void *) (2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void createMaskTexture() {
+        glGenTextures(1, &m_maskTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_maskTexture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R32F, m_maskSize, m_maskSize, m_layerCount);
+
+        // Only accessed with texelFetch
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void createTileBuffers() {
+        glGenBuffers(1, &m_tileHeightSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileHeightSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, totalTileCount() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+
+        // Worst case every tile is underwater
+        glGenBuffers(1, &m_tileSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, gridTileCount() * sizeof(WaterTile), nullptr, GL_DYNAMIC_DRAW);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void resetTileHeights(const int layer) const {
+        // Heights are compared as uint bits in the shader, positive floats keep their order
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileHeightSSBO);
+        std::array<GLuint, TILES_PER_CHUNK> initialHeights;
+        initialHeights.fill(0xFFFFFFFFu);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, layer * TILES_PER_CHUNK * sizeof(GLuint),
+                        initialHeights.size() * sizeof(GLuint), initialHeights.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    bool pollFenceState() {
+        GLenum waitRet = glClientWaitSync(m_fenceHandle, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (waitRet == GL_ALREADY_SIGNALED || waitRet == GL_CONDITION_SATISFIED) {
+            glDeleteSync(m_fenceHandle);
+            m_fenceHandle = nullptr;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Only the layers of the finished batch, their tile heights are kept until the layer gets baked again
+    void retrieveTileHeightsFromGPU() {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileHeightSSBO);
+        for (const int layer: m_bakeBatch) {
+            MaskLayer &maskLayer = m_layers[layer];
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, layer * TILES_PER_CHUNK * sizeof(float),
+                               maskLayer.tileHeights.size() * sizeof(float), maskLayer.tileHeights.data());
+            maskLayer.ready = true;
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        m_bakeBatch.clear();
+    }
+
+    void addUnderwaterTiles(const TerrainChunk &chunk, const int layer) {
+        for (int tile = 0; tile < TILES_PER_CHUNK; tile++) {
+            const float minHeight = m_layers[layer].tileHeights[tile];
+
+            // Negated so tiles the bake never touched (NaN bits) are skipped as well
+            if (!(minHeight < WATER_CUTOFF_HEIGHT)) {
+                continue;
+            }
+
+            const glm::vec2 tileOffset = {
+                static_cast<float>((tile % TILES_PER_CHUNK_AXIS) * m_tileSize),
+                static_cast<float>((tile / TILES_PER_CHUNK_AXIS) * m_tileSize)
+            };
+
+            m_underwaterTiles.push_back({
+                chunk.globalPos, tileOffset, layer, 0, minHeight, 0.0f, glm::ivec4{0}
+            });
+        }
+    }
+
+    void assignTileLods(const glm::ivec2 &cameraTile) {
+        m_tilesPerLod.fill(0);
+
+        for (WaterTile &tile: m_underwaterTiles) {
+            // Tile offsets are multiples of the tile size, the division is exact
+            const glm::vec2 tileWorldPos = tile.chunkOffset + tile.tileOffset;
+            const glm::ivec2 globalTile = {
+                static_cast<int>(std::floor(tileWorldPos.x / m_tileSize)),
+                static_cast<int>(std::floor(tileWorldPos.y / m_tileSize))
+            };
+
+            tile.lod = WaterPatchLODGenerator::calculateLod(globalTile, cameraTile);
+            tile.neighbourLods = WaterPatchLODGenerator::calculateNeighbourLods(globalTile, cameraTile);
+            m_tilesPerLod[tile.lod]++;
+        }
+
+        // Group by LOD so every LOD is a contiguous instance range
+        std::stable_sort(m_underwaterTiles.begin(), m_underwaterTiles.end(),
+                         [](const WaterTile &a, const WaterTile &b) { return a.lod < b.lod; });
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_underwaterTiles.size() * sizeof(WaterTile),
+                        m_underwaterTiles.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        m_stats = WaterPatchLODGenerator::calculateStats(m_lodMeshBuffer, m_tilesPerLod);
+    }
+};
+
+
+#endif //WATERSURFACE_H
@@ -4,203 +4,187 @@
 
 #ifndef GPUMODELUPLOADER_H
 #define GPUMODELUPLOADER_H
+#include <algorithm>
+#include <string>
 #include <vector>
 
+#include "GeometryArena.h"
 #include "GltfLoader.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 #include "RenderCall.h"
+#include "TextureCache.h"
+#include "VertexInterleaver.h"
 #include "glad/glad.h"
 
 class GPUModelUploader {
 private:
-    GLuint processPrimitive(const GltfPrimitive &primitive, const GltfScene &model, RenderCall &renderCall) {
-        // Create VAO
-        GLuint VAO;
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
-
-        // We always expect the given attributes to be in the primitive
-        const std::vector<GltfAttribute> attribOrder = {
-            GltfAttribute::POSITION,
-            GltfAttribute::NORMAL,
-            GltfAttribute::TANGENT,
-            GltfAttribute::TEXCOORD_0
-        };
-
-        auto getComponentSize = [](int componentType) -> std::size_t {
-            switch (componentType) {
-                case GL_FLOAT: return sizeof(float);
-                case GL_UNSIGNED_INT: return sizeof(unsigned int);
-                case GL_INT: return sizeof(int);
-                default: throw std::runtime_error("Unsupported component type");
-            }
-        };
-
-        // Temp map so also tangents can be generated if missing
-        std::unordered_map<GltfAttribute, const GltfVertexAttrib*> attribs;
-
-        for (auto const &[key, val] : primitive.attributes) {
-            attribs[key] = &val;
-        }
-
-        // Calculate total size of a single vertex and determine vertex count
-        std::size_t vertexSize = 0;
-        std::size_t vertexCount = 0;
+    void processPrimitive(const GltfPrimitive &primitive, const GltfScene &model, RenderCall &renderCall) {
+        // Vertex cache and vertex fetch order get optimized on import
+        const PrimitiveGeometry geometry = MeshOptimizer::buildGltfPrimitive(primitive, m_quantize);
+        const InterleavedVertexData &vertexData = geometry.vertices;
+        const PackedIndexData &indexData = geometry.indices;
+
+        const GeometryAllocation allocation = GeometryArena::instance().allocate(
+            vertexData.attributes, vertexData.stride, vertexData.buffer.data(), vertexData.vertexCount,
+            indexData.componentType, indexData.buffer.data(), indexData.count
+        );
+
+        renderCall.vao = allocation.vao;
+        renderCall.baseVertex = allocation.baseVertex;
+        renderCall.firstIndex = allocation.firstIndex;
+        renderCall.vertexBuffer = allocation.vertexBuffer;
+        renderCall.indexBuffer = allocation.indexBuffer;
+        renderCall.vertexStride = allocation.vertexStride;
+        renderCall.componentType = indexData.componentType;
+        renderCall.elemCount = geometry.lods.front().indexCount;
+        setQuantization(vertexData.quantization, renderCall);
+        setLods(geometry.lods.data(), static_cast<std::uint32_t>(geometry.lods.size()), renderCall);
 
-        for (const auto &attrib : attribOrder) {
-            if (attribs.find(attrib) != attribs.end()) {
-                const auto &attribute = *attribs.at(attrib);
-                std::size_t componentSize = getComponentSize(attribute.componentType);
-                std::size_t componentsPerElement = attribute.bufferSize / (attribute.elemCount * componentSize);
-
-                vertexSize += componentSize * componentsPerElement;
+        // Material processing (returning texture handles)
+        processMaterial(primitive, model, renderCall);
+    }
 
-                if (vertexCount == 0) {
-                    vertexCount = attribute.elemCount;
-                }
-            } else if (attrib == GltfAttribute::TANGENT) {
-                std::vector<float> tmpBuffer(vertexCount * 3, 0.0f);
+    void processMaterial(const GltfPrimitive &primitive, const GltfScene &model, RenderCall &renderCall) {
+        if (primitive.materialIdx >= 0) {
+            const GltfMaterial &mat = model.materials.at(primitive.materialIdx);
 
-                for (std::size_t i = 0; i < vertexCount; i++) {
-                    glm::vec3 defaultTangent(0.0f, 0.0f, 0.0f);
+            // We ignore baseColorFactor for now
+            for (const GltfTextureProperties &properties : mat.textureProperties) {
+                const GltfImage &image = model.images[properties.index];
 
-                    std::memcpy(&tmpBuffer[i * 3], &defaultTangent, sizeof(defaultTangent));
+                // Hash every image only once per model, primitives often share materials
+                if (m_imageHashes.find(properties.index) == m_imageHashes.end()) {
+                    m_imageHashes[properties.index] = TextureCache::hashImage(image);
                 }
 
-                GltfVertexAttrib tmpTangentAttrib = {
-                    "Tangent",
-                    tmpBuffer.data(),
-                    GL_FLOAT,
-                    3,
-                    vertexCount,
-                    tmpBuffer.size()
-                };
-
-                attribs[GltfAttribute::TANGENT] = &tmpTangentAttrib;
-            } else {
-                throw std::runtime_error("Missing vertex attribute in model");
+                renderCall.textureHandles[properties.type] =
+                        TextureCache::instance().acquire(image, m_imageHashes[properties.index]);
             }
         }
+    }
 
-        std::size_t mainBufferSize = vertexSize * vertexCount;
-        auto *mainBuffer = new std::byte[mainBufferSize];
-
-        // Fill the buffer
-        for (std::size_t i = 0; i < vertexCount; ++i) {
-            std::size_t offset = i * vertexSize;
-
-            for (const auto &attrib : attribOrder) {
-                const auto &attribute = *attribs.at(attrib);
+    // Image index -> content hash of the model currently being uploaded
+    std::unordered_map<int, TextureContentHash> m_imageHashes;
+    bool m_quantize;
 
-                std::size_t componentSize = getComponentSize(attribute.componentType);
-                std::size_t componentsPerElement = attribute.bufferSize / (attribute.elemCount * componentSize);
+    static void setQuantization(const VertexQuantization &quantization, RenderCall &renderCall) {
+        const float *scale = quantization.positionScale;
+        const float *offset = quantization.positionOffset;
 
-                // Copy data for the current attribute
-                std::memcpy(
-                    mainBuffer + offset,
-                    static_cast<std::byte *>(attribute.buffer) + i * componentSize * componentsPerElement,
-                    componentSize * componentsPerElement
-                );
+        renderCall.positionScale = glm::vec3{scale[0], scale[1], scale[2]};
+        renderCall.positionOffset = glm::vec3{offset[0], offset[1], offset[2]};
+        renderCall.octEncoded = quantization.octEncoded != 0;
+    }
 
-                // Advance the offset for the next attribute
-                offset += componentSize * componentsPerElement;
-            }
+    // Needs firstIndex of the allocation, a single level is stored without LODs
+    static void setLods(const MeshLodRange *lods, std::uint32_t lodCount, RenderCall &renderCall) {
+        if (lodCount < 2) {
+            return;
         }
 
-        // VBO
-        GLuint VBO;
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, mainBufferSize, mainBuffer, GL_STATIC_DRAW);
-
-        // Setup attribute pointers
-        std::size_t offset = 0;
-        GLuint index = 0;
-
-        for (const auto &attrib : attribOrder) {
-            if (primitive.attributes.find(attrib) != primitive.attributes.end()) {
-                const auto &attribute = primitive.attributes.at(attrib);
-                std::size_t componentSize = getComponentSize(attribute.componentType);
-                std::size_t componentsPerElement = attribute.bufferSize / (attribute.elemCount * componentSize);
-
-                glEnableVertexAttribArray(index);
-                glVertexAttribPointer(
-                    index,
-                    static_cast<GLint>(componentsPerElement),
-                    attribute.componentType,
-                    GL_FALSE,
-                    static_cast<GLsizei>(vertexSize),
-                    reinterpret_cast<void *>(offset)
-                );
-
-                offset += componentSize * componentsPerElement;
-                index++;
-            }
+        for (std::uint32_t i = 0; i < lodCount; i++) {
+            renderCall.lods.push_back({renderCall.firstIndex + lods[i].firstIndex, lods[i].indexCount, lods[i].error});
         }
+    }
 
-        // EBO
-        GLuint EBO;
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, primitive.indexBufferSize, primitive.indexBuffer, GL_STATIC_DRAW);
-
-        // Material processing (returning texture handles)
-        processMaterial(primitive, model, renderCall);
+    // Everything in the cache is ready to be uploaded, buffers are copied straight from the mapping
+    static std::vector<RenderCall> uploadMeshCache(const MappedFile &file) {
+        const MeshCacheHeader &header = MeshCache::getHeader(file);
+        const auto *primitives = MeshCache::getTable<MeshCachePrimitive>(file, header.primitivesOffset);
+        const auto *attributes = MeshCache::getTable<VertexAttribLayout>(file, header.attributesOffset);
+        const auto *materials = MeshCache::getTable<MeshCacheMaterial>(file, header.materialsOffset);
+        const auto *textures = MeshCache::getTable<MeshCacheTexture>(file, header.texturesOffset);
+        const auto *lods = MeshCache::getTable<MeshLodRange>(file, header.lodsOffset);
 
-        // Clean up
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::vector<RenderCall> renderCalls;
 
-        delete[] mainBuffer;
+        for (std::uint32_t i = 0; i < header.primitiveCount; i++) {
+            const MeshCachePrimitive &primitive = primitives[i];
+            RenderCall renderCall{};
 
-        return VAO;
-    }
+            const std::vector<VertexAttribLayout> primitiveAttributes{
+                attributes + primitive.firstAttribute,
+                attributes + primitive.firstAttribute + primitive.attributeCount
+            };
 
-    void processMaterial(const GltfPrimitive &primitive, const GltfScene &model, RenderCall &renderCall) {
-        if (primitive.materialIdx >= 0) {
-            auto uploadTexture = [](const GltfImage &img) -> GLuint {
-                GLuint tex;
-                glGenTextures(1, &tex);
-                glBindTexture(GL_TEXTURE_2D, tex);
-
-                int format = GL_RGBA;
-                switch (img.component) {
-                    case 1: format = GL_R8; break;
-                    case 3: format = GL_RGB; break;
-                    case 4: format = GL_RGBA; break;
-                    default: throw std::runtime_error("Invalid internal pixel format in texture");
+            const GeometryAllocation allocation = GeometryArena::instance().allocate(
+                primitiveAttributes, primitive.vertexStride, file.data() + primitive.vertexOffset, primitive.vertexCount,
+                static_cast<int>(primitive.indexComponentType), file.data() + primitive.indexOffset, primitive.indexCount
+            );
+
+            renderCall.vao = allocation.vao;
+            renderCall.baseVertex = allocation.baseVertex;
+            renderCall.firstIndex = allocation.firstIndex;
+            renderCall.vertexBuffer = allocation.vertexBuffer;
+            renderCall.indexBuffer = allocation.indexBuffer;
+            renderCall.vertexStride = allocation.vertexStride;
+            setQuantization(primitive.quantization, renderCall);
+
+            if (primitive.materialIdx >= 0) {
+                const MeshCacheMaterial &material = materials[primitive.materialIdx];
+
+                for (std::uint32_t j = 0; j < material.textureCount; j++) {
+                    const MeshCacheMaterialTexture &materialTexture = material.textures[j];
+                    renderCall.textureHandles[static_cast<TextureType>(materialTexture.type)] =
+                            acquireCachedTexture(file, textures[materialTexture.textureIdx]);
                 }
+            }
 
-                glTexImage2D(GL_TEXTURE_2D, 0, format, img.width, img.height, 0, format, img.pixelType, img.buffer.data());
-                glGenerateMipmap(GL_TEXTURE_2D);
+            renderCall.elemCount = lods[primitive.firstLod].indexCount;
+            setLods(lods + primitive.firstLod, primitive.lodCount, renderCall);
+            renderCall.componentType = static_cast<int>(primitive.indexComponentType);
+            renderCalls.push_back(renderCall);
+        }
 
-                return tex;
-            };
+        return renderCalls;
+    }
 
-            const GltfMaterial &mat = model.materials.at(primitive.materialIdx);
+    // Mip levels come from the cache, no glGenerateMipmap
+    static GLuint acquireCachedTexture(const MappedFile &file, const MeshCacheTexture &texture) {
+        const TextureCacheKey key{
+            {texture.hash, texture.checkHash}, MeshCache::getMipSize(texture, texture.width, texture.height),
+            texture.width, texture.height, texture.component, texture.pixelType
+        };
 
-            // We ignore baseColorFactor for now
-            for (const GltfTextureProperties &properties : mat.textureProperties) {
-                const GltfImage &image = model.images[properties.index];
+        return TextureCache::instance().acquire(key, texture.dataBytes, [&file, &texture] {
+            GLuint tex;
+            glGenTextures(1, &tex);
+            glBindTexture(GL_TEXTURE_2D, tex);
+
+            const int format = TextureCache::getFormat(texture.component);
+            const std::byte *level = file.data() + texture.dataOffset;
+            int width = texture.width;
+            int height = texture.height;
 
-                renderCall.textureHandles[properties.type] = uploadTexture(image);
+            for (int mip = 0; mip < texture.mipCount; mip++) {
+                glTexImage2D(GL_TEXTURE_2D, mip, format, width, height, 0, format, texture.pixelType, level);
+
+                level += MeshCache::getMipSize(texture, width, height);
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
             }
-        }
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.mipCount - 1);
+            return tex;
+        });
     }
 
 public:
-    GPUModelUploader() = default;
+    // Quantizing stores a vertex in 20 instead of 44+ bytes and narrows indices to 16 bit where possible
+    explicit GPUModelUploader(bool quantize = false) : m_quantize(quantize) {
+    }
 
     std::vector<RenderCall> uploadGltfModel(const GltfScene &model) {
         std::vector<RenderCall> renderCalls;
+        m_imageHashes.clear();
 
         for (const GltfObject &object : model.objects) {
             for (const GltfMesh &mesh : object.meshes) {
                 for (const GltfPrimitive &primitive : mesh.primitives) {
-                    GLuint texture = 0; // Store the texture handle here
                     RenderCall renderCall{};
-                    renderCall.vao = processPrimitive(primitive, model, renderCall);
-                    renderCall.componentType = primitive.componentType;
-                    renderCall.elemCount = primitive.elemCount;
+                    processPrimitive(primitive, model, renderCall);
 
                     renderCalls.push_back(renderCall);
                 }
@@ -209,6 +193,23 @@ public:
 
         return renderCalls;
     }
+
+    // Uses the preprocessed mesh cache if it's up to date, otherwise loads the glTF and rebuilds the cache
+    std::vector<RenderCall> uploadModel(const std::string &path) {
+        MappedFile cache = MeshCache::open(path, m_quantize);
+
+        if (cache.isOpen()) {
+            return uploadMeshCache(cache);
+        }
+
+        GltfLoader loader;
+        GltfScene scene = loader.loadModel(path);
+        std::vector<RenderCall> renderCalls = uploadGltfModel(scene);
+
+        MeshCache::write(scene, path, m_quantize);
+
+        return renderCalls;
+    }
 };
 
 #endif //GPUMODELUPLOADER_H
@@ -0,0 +1,341 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "VertexInterleaver.h"
+#include "glad/glad.h"
+
+// First fit allocator over [0, capacity), neighbouring free ranges get merged
+class RangeAllocator {
+public:
+    static constexpr GLuint INVALID_OFFSET = 0xFFFFFFFF;
+
+    explicit RangeAllocator(GLuint capacity) : m_capacity(capacity) {
+        m_freeRanges[0] = capacity;
+    }
+
+    GLuint allocate(GLuint size) {
+        for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+            if (it->second >= size) {
+                const GLuint offset = it->first;
+                const GLuint remaining = it->second - size;
+
+                m_freeRanges.erase(it);
+
+                if (remaining > 0) {
+                    m_freeRanges[offset + size] = remaining;
+                }
+
+                m_used += size;
+                return offset;
+            }
+        }
+
+        return INVALID_OFFSET;
+    }
+
+    void free(GLuint offset, GLuint size) {
+        m_used -= size;
+        insertFreeRange(offset, size);
+    }
+
+    // Appends free space at the end, merges with a free range ending there
+    void grow(GLuint newCapacity) {
+        insertFreeRange(m_capacity, newCapacity - m_capacity);
+        m_capacity = newCapacity;
+    }
+
+    [[nodiscard]] GLuint getCapacity() const {
+        return m_capacity;
+    }
+
+    [[nodiscard]] GLuint getUsed() const {
+        return m_used;
+    }
+
+private:
+    std::map<GLuint, GLuint> m_freeRanges; // Offset -> size
+    GLuint m_capacity;
+    GLuint m_used{0};
+
+    void insertFreeRange(GLuint offset, GLuint size) {
+        auto next = m_freeRanges.lower_bound(offset);
+
+        // Merge with the following range
+        if (next != m_freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = m_freeRanges.erase(next);
+        }
+
+        // Merge with the preceding range
+        if (next != m_freeRanges.begin()) {
+            auto prev = std::prev(next);
+
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+
+        m_freeRanges[offset] = size;
+    }
+};
+
+struct GeometryAllocation {
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint vertexStride;
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLuint vertexCount;
+    GLuint indexCount;
+    int indexType;
+};
+
+struct GeometryArenaStats {
+    GLuint formatCount;
+    GLuint poolCount;
+    GLuint allocationCount;
+    std::size_t vertexBytesUsed;
+    std::size_t vertexBytesCapacity;
+    std::size_t indexBytesUsed;
+    std::size_t indexBytesCapacity;
+};
+
+// All static meshes share a few large buffers, one pool (VBO + EBO) per vertex format and index type
+// Meshes are addressed with base vertex and first index, so meshes of a pool can be drawn with
+// a single VAO bind and batched with glMultiDrawElementsBaseVertex
+// The layout is described once per vertex format (glVertexAttribFormat), pools of the same format
+// share its VAO and only swap buffers with glBindVertexBuffer
+// Pools grow by doubling in place, existing allocations keep their offsets and buffer names
+class GeometryArena {
+public:
+    static constexpr GLuint INITIAL_VERTEX_CAPACITY = 1 << 16;
+    static constexpr GLuint INITIAL_INDEX_CAPACITY = 1 << 18;
+    static constexpr GLuint VERTEX_BINDING = 0;
+
+    static GeometryArena &instance() {
+        static GeometryArena arena;
+        return arena;
+    }
+
+    GeometryAllocation allocate(const std::vector<VertexAttribLayout> &attributes, GLuint stride,
+                                const void *vertices, GLuint vertexCount,
+                                int indexType, const void *indices, GLuint indexCount) {
+        GeometryPool &pool = getPool(attributes, stride, indexType);
+
+        // Only the buffer that ran out of space gets reallocated
+        GLuint vertexOffset = pool.vertices.allocate(vertexCount);
+        if (vertexOffset == RangeAllocator::INVALID_OFFSET) {
+            growRange(pool.vertices, pool.vbo, pool.format->stride, vertexCount);
+            vertexOffset = pool.vertices.allocate(vertexCount);
+        }
+
+        GLuint indexOffset = pool.indices.allocate(indexCount);
+        if (indexOffset == RangeAllocator::INVALID_OFFSET) {
+            growRange(pool.indices, pool.ebo, pool.indexSize, indexCount);
+            indexOffset = pool.indices.allocate(indexCount);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(vertexOffset) * stride,
+                        static_cast<GLsizeiptr>(vertexCount) * stride, vertices);
+
+        // Element buffer binding is VAO state, use the copy target instead
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.ebo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(indexOffset) * pool.indexSize,
+                        static_cast<GLsizeiptr>(indexCount) * pool.indexSize, indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        GeometryAllocation allocation{
+            pool.format->vao,
+            pool.vbo,
+            pool.ebo,
+            pool.format->stride,
+            static_cast<GLint>(vertexOffset),
+            indexOffset,
+            vertexCount,
+            indexCount,
+            indexType
+        };
+
+        m_allocations.push_back(allocation);
+        return allocation;
+    }
+
+    // Identified by the vertex buffer and base vertex of a RenderCall
+    void free(GLuint vertexBuffer, GLint baseVertex) {
+        auto it = std::find_if(m_allocations.begin(), m_allocations.end(), [&](const GeometryAllocation &allocation) {
+            return allocation.vertexBuffer == vertexBuffer && allocation.baseVertex == baseVertex;
+        });
+
+        if (it == m_allocations.end()) {
+            return;
+        }
+
+        for (std::unique_ptr<GeometryPool> &pool: m_pools) {
+            if (pool->vbo == vertexBuffer) {
+                pool->vertices.free(static_cast<GLuint>(it->baseVertex), it->vertexCount);
+                pool->indices.free(it->firstIndex, it->indexCount);
+                break;
+            }
+        }
+
+        m_allocations.erase(it);
+    }
+
+    [[nodiscard]] GeometryArenaStats getStats() const {
+        GeometryArenaStats stats{
+            static_cast<GLuint>(m_formats.size()),
+            static_cast<GLuint>(m_pools.size()),
+            static_cast<GLuint>(m_allocations.size())
+        };
+
+        for (const std::unique_ptr<GeometryPool> &pool: m_pools) {
+            stats.vertexBytesUsed += static_cast<std::size_t>(pool->vertices.getUsed()) * pool->format->stride;
+            stats.vertexBytesCapacity += static_cast<std::size_t>(pool->vertices.getCapacity()) * pool->format->stride;
+            stats.indexBytesUsed += static_cast<std::size_t>(pool->indices.getUsed()) * pool->indexSize;
+            stats.indexBytesCapacity += static_cast<std::size_t>(pool->indices.getCapacity()) * pool->indexSize;
+        }
+
+        return stats;
+    }
+
+    static GLuint getIndexSize(int indexType) {
+        switch (indexType) {
+            case GL_UNSIGNED_BYTE: return sizeof(GLubyte);
+            case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+            case GL_UNSIGNED_INT: return sizeof(GLuint);
+            default: throw std::runtime_error("Unsupported index type");
+        }
+    }
+
+private:
+    struct VertexFormat {
+        std::vector<VertexAttribLayout> attributes;
+        GLuint stride;
+        GLuint vao;
+    };
+
+    struct GeometryPool {
+        VertexFormat *format;
+        int indexType;
+        GLuint indexSize;
+
+        GLuint vbo;
+        GLuint ebo;
+        RangeAllocator vertices;
+        RangeAllocator indices;
+    };
+
+    // Pointers stay stable while formats and pools get added
+    std::vector<std::unique_ptr<VertexFormat> > m_formats;
+    std::vector<std::unique_ptr<GeometryPool> > m_pools;
+    std::vector<GeometryAllocation> m_allocations;
+
+    GeometryArena() = default;
+
+    VertexFormat &getVertexFormat(const std::vector<VertexAttribLayout> &attributes, GLuint stride) {
+        auto sameLayout = [](const VertexAttribLayout &a, const VertexAttribLayout &b) {
+            return a.location == b.location && a.components == b.components &&
+                   a.componentType == b.componentType && a.offset == b.offset &&
+                   a.normalized == b.normalized;
+        };
+
+        for (std::unique_ptr<VertexFormat> &format: m_formats) {
+            if (format->stride == stride &&
+                std::equal(format->attributes.begin(), format->attributes.end(),
+                           attributes.begin(), attributes.end(), sameLayout)) {
+                return *format;
+            }
+        }
+
+        auto format = std::unique_ptr<VertexFormat>(new VertexFormat{attributes, stride, 0});
+
+        glGenVertexArrays(1, &format->vao);
+        glBindVertexArray(format->vao);
+        VertexInterleaver::setupAttribFormat(format->attributes.data(), format->attributes.size(), VERTEX_BINDING);
+        glBindVertexArray(0);
+
+        m_formats.push_back(std::move(format));
+        return *m_formats.back();
+    }
+
+    GeometryPool &getPool(const std::vector<VertexAttribLayout> &attributes, GLuint stride, int indexType) {
+        VertexFormat &format = getVertexFormat(attributes, stride);
+
+        for (std::unique_ptr<GeometryPool> &pool: m_pools) {
+            if (pool->format == &format && pool->indexType == indexType) {
+                return *pool;
+            }
+        }
+
+        auto pool = std::unique_ptr<GeometryPool>(new GeometryPool{
+            &format, indexType, getIndexSize(indexType), 0, 0,
+            RangeAllocator{INITIAL_VERTEX_CAPACITY}, RangeAllocator{INITIAL_INDEX_CAPACITY}
+        });
+
+        pool->vbo = createBuffer(static_cast<GLsizeiptr>(INITIAL_VERTEX_CAPACITY) * stride);
+        pool->ebo = createBuffer(static_cast<GLsizeiptr>(INITIAL_INDEX_CAPACITY) * pool->indexSize);
+
+        m_pools.push_back(std::move(pool));
+        return *m_pools.back();
+    }
+
+    // Doubles the range and its buffer until count elements fit behind the old capacity
+    static void growRange(RangeAllocator &range, GLuint buffer, GLuint elementSize, GLuint count) {
+        const GLuint oldCapacity = range.getCapacity();
+        GLuint capacity = oldCapacity;
+
+        // Worst case the new range can't be merged with a free range at the end
+        while (capacity - oldCapacity < count) {
+            capacity *= 2;
+        }
+
+        growBuffer(buffer, static_cast<GLsizeiptr>(oldCapacity) * elementSize,
+                   static_cast<GLsizeiptr>(capacity) * elementSize);
+        range.grow(capacity);
+    }
+
+    static GLuint createBuffer(GLsizeiptr size) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        return buffer;
+    }
+
+    // Reallocates the storage but keeps the buffer name, so RenderCalls and VAOs stay valid
+    // The old content takes a round trip through a temporary buffer, growing is rare
+    static void growBuffer(GLuint buffer, GLsizeiptr oldSize, GLsizeiptr newSize) {
+        const GLuint temp = createBuffer(oldSize);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, temp);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, temp);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &temp);
+    }
+};
+
+
+#endif //GEOMETRYARENA_H
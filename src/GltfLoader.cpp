@@ -3,24 +3,119 @@
 //
 
 #include "GltfLoader.h"
+#include <algorithm>
 #include <filesystem>
+#include <future>
+#include <limits>
+#include <optional>
 #include <iostream>
+#include <stb_image.h>
+
+#include "AssetArchive.h"
+#include "ThreadPool.h"
+
+namespace {
+    // Same output as the tinygltf decoder, RGBA with 8 or 16 bits per channel
+    GltfImage decodeImage(const Image &image) {
+        // Stayed encoded, tinygltf wasn't able to parse the header
+        if (image.width < 1) {
+            std::cerr << "Unable to decode image: " << image.name << std::endl;
+            return GltfImage{4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 8, 0, 0, {}};
+        }
+
+        const stbi_uc *bytes = image.image.data();
+        const int size = static_cast<int>(image.image.size());
+        int width, height, nChannels;
+
+        if (image.bits == 16) {
+            stbi_us *data = stbi_load_16_from_memory(bytes, size, &width, &height, &nChannels, 4);
+
+            if (data) {
+                const auto *begin = reinterpret_cast<const unsigned char *>(data);
+                GltfImage decoded{
+                    4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 16, width, height,
+                    std::vector<unsigned char>(begin, begin + static_cast<std::size_t>(width) * height * 4 * 2)
+                };
+
+                stbi_image_free(data);
+                return decoded;
+            }
+        }
+
+        stbi_uc *data = stbi_load_from_memory(bytes, size, &width, &height, &nChannels, 4);
+
+        if (!data) {
+            std::cerr << "Unable to decode image: " << image.name << std::endl;
+            return GltfImage{4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 8, 0, 0, {}};
+        }
+
+        GltfImage decoded{
+            4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 8, width, height,
+            std::vector<unsigned char>(data, data + static_cast<std::size_t>(width) * height * 4)
+        };
+
+        stbi_image_free(data);
+        return decoded;
+    }
+}
 
 GltfLoader::GltfLoader() = default;
 
+FsCallbacks GltfLoader::getArchiveFsCallbacks() {
+    return FsCallbacks{
+        [](const std::string &path, void *userData) {
+            return AssetArchive::instance().find(path).has_value() || tinygltf::FileExists(path, userData);
+        },
+        tinygltf::ExpandFilePath,
+        [](std::vector<unsigned char> *out, std::string *err, const std::string &path, void *userData) {
+            if (std::optional<AssetView> view = AssetArchive::instance().find(path)) {
+                const auto *bytes = reinterpret_cast<const unsigned char *>(view->data);
+                out->assign(bytes, bytes + view->size);
+                return true;
+            }
+
+            return tinygltf::ReadWholeFile(out, err, path, userData);
+        },
+        tinygltf::WriteWholeFile,
+        [](std::size_t *size, std::string *err, const std::string &path, void *userData) {
+            if (std::optional<AssetView> view = AssetArchive::instance().find(path)) {
+                *size = view->size;
+                return true;
+            }
+
+            return tinygltf::GetFileSizeInBytes(size, err, path, userData);
+        },
+        nullptr
+    };
+}
+
 GltfScene GltfLoader::loadModel(const std::string &path) {
     Model model;
 
     TinyGLTF loader;
+    // Images are decoded in parallel in processImages
+    loader.SetImagesAsIs(true);
     std::string err;
     std::string warn;
 
+    // External buffers and images of .gltf files are resolved through the archive as well
+    loader.SetFsCallbacks(getArchiveFsCallbacks());
+
     std::filesystem::path filePath(path);
     std::string extension = filePath.extension().string();
+    std::optional<AssetView> packed = AssetArchive::instance().find(path);
 
     bool success = false;
 
-    if (extension == ".gltf") {
+    if (packed && (extension == ".gltf" || extension == ".glb")) {
+        const std::string baseDir = filePath.parent_path().string();
+        const auto *bytes = reinterpret_cast<const unsigned char *>(packed->data);
+        const auto size = static_cast<unsigned int>(packed->size);
+
+        success = extension == ".gltf"
+                      ? loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char *>(bytes), size, baseDir)
+                      : loader.LoadBinaryFromMemory(&model, &err, &warn, bytes, size, baseDir);
+    } else if (extension == ".gltf") {
         success = loader.LoadASCIIFromFile(&model, &err, &warn, path);
     } else if (extension == ".glb") {
         success = loader.LoadBinaryFromFile(&model, &err, &warn, path);
@@ -35,24 +130,56 @@ GltfScene GltfLoader::loadModel(const std::string &path) {
     }
 
     GltfScene gltfScene;
+    collectExternalFiles(gltfScene, model, filePath.parent_path());
+
+    // Take over the binary buffers without copying, the rest of the model gets released on return
+    for (Buffer &buffer : model.buffers) {
+        gltfScene.buffers.emplace_back(std::move(buffer.data));
+    }
+
     processImages(gltfScene, model);
     processMaterials(gltfScene, model);
 
     processScenes(gltfScene, model);
 
-    return std::move(gltfScene);
+    return gltfScene;
+}
+
+void GltfLoader::collectExternalFiles(GltfScene &gltfScene, const Model &model, const std::filesystem::path &baseDir) {
+    auto addUri = [&gltfScene, &baseDir](const std::string &uri) {
+        // Embedded data and GLB chunks have no file behind them
+        if (uri.empty() || uri.rfind("data:", 0) == 0) {
+            return;
+        }
+
+        std::string decodedUri;
+        if (!tinygltf::URIDecode(uri, &decodedUri, nullptr)) {
+            decodedUri = uri;
+        }
+
+        gltfScene.externalFiles.push_back(AssetArchive::normalizePath((baseDir / decodedUri).string()));
+    };
+
+    for (const Buffer &buffer : model.buffers) {
+        addUri(buffer.uri);
+    }
+
+    for (const Image &image : model.images) {
+        addUri(image.uri);
+    }
 }
 
 void GltfLoader::processImages(GltfScene &gltfScene, Model &model) {
+    std::vector<std::future<GltfImage> > decodedImages;
+
     for (const Image &image : model.images) {
-        gltfScene.images.emplace_back(GltfImage{
-            image.component,
-            image.pixel_type,
-            image.bits,
-            image.width,
-            image.height,
-            image.image
-        });
+        decodedImages.emplace_back(ThreadPool::decodePool().submit([&image] {
+            return decodeImage(image);
+        }));
+    }
+
+    for (std::future<GltfImage> &decodedImage : decodedImages) {
+        gltfScene.images.emplace_back(decodedImage.get());
     }
 }
 
@@ -141,7 +268,7 @@ void GltfLoader::processScenes(GltfScene &gltfScene, Model &model) {
                 std::vector<GltfMesh> meshes;
 
                 // Process the mesh attached to the node
-                processNode(model, meshes, node);
+                processNode(gltfScene, model, meshes, node);
                 object.name = node.name;
                 object.meshes = std::move(meshes);
                 gltfScene.objects.emplace_back(std::move(object));
@@ -151,7 +278,7 @@ void GltfLoader::processScenes(GltfScene &gltfScene, Model &model) {
                 std::vector<GltfMesh> meshes;
 
                 // Recursively process this node and its children as an object with geometry
-                processNode(model, meshes, node);
+                processNode(gltfScene, model, meshes, node);
                 object.name = node.name;
                 object.meshes = std::move(meshes);
                 gltfScene.objects.emplace_back(std::move(object));
@@ -160,18 +287,71 @@ void GltfLoader::processScenes(GltfScene &gltfScene, Model &model) {
     }
 }
 
-void GltfLoader::processNode(Model &model, std::vector<GltfMesh> &meshes, const Node &node) {
+void GltfLoader::processNode(GltfScene &gltfScene, Model &model, std::vector<GltfMesh> &meshes, const Node &node) {
     // A node could be a camera, ignore in this case
     if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-        processMesh(model, meshes, model.meshes[node.mesh]);
+        processMesh(gltfScene, model, meshes, model.meshes[node.mesh]);
     }
 
     for (int nodeChildrenIdx : node.children) {
-        processNode(model, meshes, model.nodes[nodeChildrenIdx]);
+        processNode(gltfScene, model, meshes, model.nodes[nodeChildrenIdx]);
+    }
+}
+
+bool GltfLoader::isAccessorInBounds(const GltfScene &gltfScene, const Model &model, const Accessor &accessor) {
+    if (accessor.bufferView < 0 || accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        return false;
+    }
+
+    const BufferView &bufferView = model.bufferViews[accessor.bufferView];
+
+    if (bufferView.buffer < 0 || bufferView.buffer >= static_cast<int>(gltfScene.buffers.size())) {
+        return false;
+    }
+
+    const std::size_t bufferSize = gltfScene.buffers[bufferView.buffer].size();
+    const int componentSize = GetComponentSizeInBytes(accessor.componentType);
+    const int componentCount = GetNumComponentsInType(accessor.type);
+    const int stride = accessor.ByteStride(bufferView);
+
+    if (componentSize <= 0 || componentCount <= 0 || stride <= 0 ||
+        bufferView.byteOffset > bufferSize || bufferView.byteLength > bufferSize - bufferView.byteOffset) {
+        return false;
+    }
+
+    if (accessor.count == 0) {
+        return accessor.byteOffset <= bufferView.byteLength;
+    }
+
+    // The last element only takes its own size, not the full stride
+    const std::size_t elementSize = static_cast<std::size_t>(componentSize) * componentCount;
+    const std::size_t maxCount = (std::numeric_limits<std::size_t>::max() - elementSize) / stride + 1;
+
+    if (accessor.count > maxCount) {
+        return false;
+    }
+
+    const std::size_t extent = (accessor.count - 1) * stride + elementSize;
+    return accessor.byteOffset <= bufferView.byteLength && extent <= bufferView.byteLength - accessor.byteOffset;
+}
+
+void *GltfLoader::getAccessorData(GltfScene &gltfScene, Model &model, const Accessor &accessor) {
+    if (accessor.bufferView < 0 || accessor.sparse.isSparse) {
+        std::cerr << "Unsupported accessor, sparse or without buffer view" << std::endl;
+        return nullptr;
+    }
+
+    if (!isAccessorInBounds(gltfScene, model, accessor)) {
+        return nullptr;
     }
+
+    const BufferView &bufferView = model.bufferViews[accessor.bufferView];
+    std::vector<unsigned char> &buffer = gltfScene.buffers[bufferView.buffer];
+
+    return buffer.data() + bufferView.byteOffset + accessor.byteOffset;
 }
 
-void GltfLoader::processMesh(Model &model, std::vector<GltfMesh> &meshes, const Mesh &mesh) {
+void GltfLoader::processMesh(GltfScene &gltfScene, Model &model, std::vector<GltfMesh> &meshes, const Mesh &mesh) {
     GltfMesh gltfMesh;
     gltfMesh.name = mesh.name;
 
@@ -180,21 +360,47 @@ void GltfLoader::processMesh(Model &model, std::vector<GltfMesh> &meshes, const
 
         gltfPrimitive.mode = primitive.mode;
 
+        // A range past the end of its buffer view or buffer means a broken file, the vertices can't be trusted
+        const auto isOutOfBounds = [&](int accessorIdx) {
+            if (accessorIdx < 0 || accessorIdx >= static_cast<int>(model.accessors.size())) {
+                return true;
+            }
+
+            const Accessor &accessor = model.accessors[accessorIdx];
+            return accessor.bufferView >= 0 && !accessor.sparse.isSparse &&
+                   !isAccessorInBounds(gltfScene, model, accessor);
+        };
+
+        const bool outOfBounds = (primitive.indices >= 0 && isOutOfBounds(primitive.indices)) ||
+                                 std::any_of(primitive.attributes.begin(), primitive.attributes.end(),
+                                             [&](const auto &attrib) { return isOutOfBounds(attrib.second); });
+
+        if (outOfBounds) {
+            std::cerr << "Skipping primitive of " << mesh.name << " with accessors outside their buffers" << std::endl;
+            continue;
+        }
+
         for (auto &attrib : primitive.attributes) {
             GltfVertexAttrib gltfVertexAttrib;
 
             Accessor &accessor = model.accessors[attrib.second];
-            BufferView &bufferView = model.bufferViews[accessor.bufferView];
-            Buffer &buffer = model.buffers[bufferView.buffer];
+            void *data = getAccessorData(gltfScene, model, accessor);
+
+            if (!data) {
+                continue;
+            }
+
+            const std::size_t elementSize = GetComponentSizeInBytes(accessor.componentType) *
+                                            GetNumComponentsInType(accessor.type);
 
             gltfVertexAttrib.attribName = attrib.first;
             gltfVertexAttrib.componentType = accessor.componentType;
             gltfVertexAttrib.elemCount = accessor.count;
             gltfVertexAttrib.datatype = accessor.type;
-            gltfVertexAttrib.bufferSize = bufferView.byteLength;
-
-            gltfVertexAttrib.buffer = new std::byte[bufferView.byteLength];
-            memcpy(gltfVertexAttrib.buffer, &buffer.data.at(bufferView.byteOffset), bufferView.byteLength);
+            gltfVertexAttrib.bufferSize = accessor.count * elementSize;
+            gltfVertexAttrib.byteStride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+            gltfVertexAttrib.buffer = data;
+            gltfVertexAttrib.normalized = accessor.normalized;
 
             if (attrib.first == "POSITION") {
                 gltfPrimitive.attributes[GltfAttribute::POSITION] = std::move(gltfVertexAttrib);
@@ -211,17 +417,26 @@ void GltfLoader::processMesh(Model &model, std::vector<GltfMesh> &meshes, const
             }
         }
 
+        if (gltfPrimitive.attributes.find(GltfAttribute::POSITION) == gltfPrimitive.attributes.end()) {
+            std::cerr << "Skipping primitive of " << mesh.name << " without readable positions" << std::endl;
+            continue;
+        }
+
         if (primitive.indices >= 0) {
             Accessor &accessorEbo = model.accessors[primitive.indices];
-            BufferView &bufferView = model.bufferViews[accessorEbo.bufferView];
-            Buffer &buffer = model.buffers[bufferView.buffer];
 
-            gltfPrimitive.indexBuffer = new std::byte[bufferView.byteLength];
+            // Indices are always tightly packed
+            gltfPrimitive.indexBuffer = getAccessorData(gltfScene, model, accessorEbo);
+
+            // Drawing without the indices would produce garbage, drop the whole primitive
+            if (!gltfPrimitive.indexBuffer) {
+                std::cerr << "Skipping primitive of " << mesh.name << " without readable indices" << std::endl;
+                continue;
+            }
+
             gltfPrimitive.elemCount = accessorEbo.count;
-            gltfPrimitive.indexBufferSize = bufferView.byteLength;
+            gltfPrimitive.indexBufferSize = accessorEbo.count * GetComponentSizeInBytes(accessorEbo.componentType);
             gltfPrimitive.componentType = accessorEbo.componentType;
-
-            memcpy(gltfPrimitive.indexBuffer, &buffer.data.at(bufferView.byteOffset), bufferView.byteLength);
         }
 
         // Handle materials
@@ -232,4 +447,3 @@ void GltfLoader::processMesh(Model &model, std::vector<GltfMesh> &meshes, const
 
     meshes.emplace_back(std::move(gltfMesh));
 }
-
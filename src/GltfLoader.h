@@ -6,6 +6,8 @@
 
 #ifndef GLTFLOADER_H
 #define GLTFLOADER_H
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <glm/vec4.hpp>
 
@@ -20,18 +22,42 @@ enum class GltfAttribute {
 
 struct GltfVertexAttrib {
     std::string attribName;
-    void *buffer;
+    void *buffer; // Points to the first element, memory is owned by the GltfScene
     int componentType; // OpenGL data type
     int datatype; // VEC2..
     std::size_t elemCount;
-    std::size_t bufferSize;
+    std::size_t bufferSize; // Size if tightly packed, elemCount * element size
+    std::size_t byteStride; // Distance between two elements, can be larger than the element size
+    bool normalized = false; // Integer components map to [0, 1] / [-1, 1] (KHR_mesh_quantization)
+
+    [[nodiscard]] std::size_t getElementSize() const {
+        return elemCount > 0 ? bufferSize / elemCount : 0;
+    }
+
+    [[nodiscard]] const std::byte *getElement(std::size_t idx) const {
+        return static_cast<const std::byte *>(buffer) + idx * byteStride;
+    }
+
+    // dst has to hold bufferSize bytes
+    void copyPacked(void *dst) const {
+        const std::size_t elementSize = getElementSize();
+
+        if (byteStride == elementSize) {
+            std::memcpy(dst, buffer, bufferSize);
+            return;
+        }
+
+        for (std::size_t i = 0; i < elemCount; i++) {
+            std::memcpy(static_cast<std::byte *>(dst) + i * elementSize, getElement(i), elementSize);
+        }
+    }
 };
 struct GltfPrimitive {
     std::unordered_map<GltfAttribute, GltfVertexAttrib> attributes;
-    void *indexBuffer;
-    std::size_t indexBufferSize;
-    int componentType;
-    std::size_t elemCount;
+    void *indexBuffer = nullptr; // Tightly packed, memory is owned by the GltfScene
+    std::size_t indexBufferSize = 0;
+    int componentType = 0;
+    std::size_t elemCount = 0;
     int mode;
     int materialIdx;
 
@@ -42,8 +68,6 @@ struct GltfPrimitive {
 
         return attributes.find(attribName)->second;
     }
-
-    // TODO: Figure out how to clear this, i should maybe look into smart pointers
 };
 
 struct GltfMesh {
@@ -76,22 +100,40 @@ struct GltfMaterial {
     std::vector<GltfTextureProperties> textureProperties;
 };
 
+// Move only, primitives point directly into the buffers owned by the scene
 struct GltfScene {
     std::string name;
     std::vector<GltfObject> objects;
     std::vector<GltfImage> images;
     std::vector<GltfMaterial> materials;
+    std::vector<std::vector<unsigned char> > buffers;
+    // Buffers and images a .gltf references by URI, resolved against its directory
+    std::vector<std::string> externalFiles;
+
+    GltfScene() = default;
+    GltfScene(const GltfScene &) = delete;
+    GltfScene &operator=(const GltfScene &) = delete;
+    GltfScene(GltfScene &&) = default;
+    GltfScene &operator=(GltfScene &&) = default;
 };
 
 
 class GltfLoader {
 private:
+    void collectExternalFiles(GltfScene &gltfScene, const Model &model, const std::filesystem::path &baseDir);
     void processImages(GltfScene &gltfScene, Model &model);
     void processTextures(GltfScene &gltfScene, Model &model);
     void processMaterials(GltfScene &gltfScene, Model &model);
     void processScenes(GltfScene &gltfScene, Model &model);
-    void processNode(Model &model, std::vector<GltfMesh> &meshes, const Node &node);
-    void processMesh(Model &model, std::vector<GltfMesh> &meshes, const Mesh &mesh);
+    void processNode(GltfScene &gltfScene, Model &model, std::vector<GltfMesh> &meshes, const Node &node);
+    void processMesh(GltfScene &gltfScene, Model &model, std::vector<GltfMesh> &meshes, const Mesh &mesh);
+    // Every element of the accessor lies inside its buffer view, and the view inside its buffer
+    static bool isAccessorInBounds(const GltfScene &gltfScene, const Model &model, const Accessor &accessor);
+    // Start of the accessor inside the scene owned buffers, accounts for view and accessor offset
+    // Null for sparse or out of bounds accessors
+    void *getAccessorData(GltfScene &gltfScene, Model &model, const Accessor &accessor);
+    // Reads from the asset archive first, falls back to the default file system callbacks
+    static FsCallbacks getArchiveFsCallbacks();
 
 public:
     explicit GltfLoader();
@@ -8,6 +8,7 @@
 #include "../../Shaders/ModelShader/ModelShaderProgram.h"
 #include "../../OrbitCamera.h"
 #include "../../RenderBase.h"
+#include "../../VertexBindings.h"
 
 
 class Lecture05 : public RenderBase {
@@ -64,11 +65,12 @@ public:
         m_modelShader.setFloat("u_specularIntensity", m_specularIntensity);
 
         for (const RenderCall &call: m_renderCalls) {
-            glBindVertexArray(call.vao);
+            VertexBindings::instance().bind(call);
             m_modelShader.preRender({ call}, call, true);
-            glDrawElements(GL_TRIANGLES, call.elemCount, call.componentType, nullptr);
-            glBindVertexArray(0);
+            glDrawElementsBaseVertex(GL_TRIANGLES, call.elemCount, call.componentType, call.getIndexOffset(), call.baseVertex);
         }
+
+        VertexBindings::instance().unbind();
     }
 };
 
@@ -0,0 +1,100 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat fileStat{};
+
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const std::byte *>(data);
+                m_size = fileStat.st_size;
+            }
+        }
+
+        // The mapping stays valid after closing
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (m_data) {
+            munmap(const_cast<std::byte *>(m_data), m_size);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    // Lets the kernel read the whole file ahead in one sequential pass
+    void prefetch() const {
+        if (m_data) {
+            madvise(const_cast<std::byte *>(m_data), m_size, MADV_SEQUENTIAL);
+            madvise(const_cast<std::byte *>(m_data), m_size, MADV_WILLNEED);
+        }
+    }
+
+    // Starts reading a byte range in the background, the range gets widened to whole pages
+    void prefetch(const std::size_t offset, const std::size_t size) const {
+        if (!m_data || offset >= m_size) {
+            return;
+        }
+
+        const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t first = offset / pageSize * pageSize;
+        const std::size_t last = std::min(offset + size, m_size);
+        madvise(const_cast<std::byte *>(m_data) + first, last - first, MADV_WILLNEED);
+    }
+
+    [[nodiscard]] bool isOpen() const {
+        return m_data != nullptr;
+    }
+
+    [[nodiscard]] const std::byte *data() const {
+        return m_data;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return m_size;
+    }
+
+private:
+    const std::byte *m_data{nullptr};
+    std::size_t m_size{0};
+};
+
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,521 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "GltfLoader.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "TextureCache.h"
+#include "VertexInterleaver.h"
+
+// Binary file layout, all offsets are absolute and 16 byte aligned
+//  Header | vertex/index/texel data | primitive table | attribute table | material table | texture table | LOD table |
+//  dependency paths | dependency table
+struct MeshCacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t sourceSize; // Size and write time of the glTF the cache was built from
+    std::int64_t sourceWriteTime;
+    std::uint32_t primitiveCount;
+    std::uint32_t attributeCount;
+    std::uint32_t materialCount;
+    std::uint32_t textureCount;
+    std::uint64_t primitivesOffset;
+    std::uint64_t attributesOffset;
+    std::uint64_t materialsOffset;
+    std::uint64_t texturesOffset;
+    std::uint32_t lodCount;
+    std::uint32_t dependencyCount;
+    std::uint64_t lodsOffset;
+    std::uint64_t dependenciesOffset;
+};
+
+// External buffer or image a .gltf references, stamped like the glTF itself
+struct MeshCacheDependency {
+    std::uint64_t size;
+    std::int64_t writeTime;
+    std::uint64_t pathOffset; // Absolute, into the dependency paths
+    std::uint32_t pathLength;
+    std::uint32_t padding;
+};
+
+struct MeshCachePrimitive {
+    std::uint64_t vertexOffset;
+    std::uint64_t vertexBytes;
+    std::uint64_t indexOffset;
+    std::uint64_t indexBytes;
+    std::uint32_t vertexStride;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    std::uint32_t indexComponentType;
+    std::int32_t materialIdx;
+    std::uint32_t firstAttribute; // Into the attribute table
+    std::uint32_t attributeCount;
+    std::uint32_t firstLod; // Into the LOD table, ranges are relative to the primitive's indices
+    std::uint32_t lodCount;
+    std::uint32_t padding;
+    VertexQuantization quantization;
+};
+
+struct MeshCacheMaterialTexture {
+    std::int32_t type; // TextureType
+    std::int32_t textureIdx; // Into the texture table
+};
+
+struct MeshCacheMaterial {
+    static constexpr int MAX_TEXTURES = 5;
+
+    float baseColorFactor[4];
+    std::uint32_t textureCount;
+    MeshCacheMaterialTexture textures[MAX_TEXTURES];
+};
+
+struct MeshCacheTexture {
+    std::uint64_t hash; // TextureCache::hashImage of the base level
+    std::uint64_t checkHash;
+    std::uint64_t dataOffset; // Mip levels are stored back to back, base level first
+    std::uint64_t dataBytes;
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t component;
+    std::int32_t pixelType;
+    std::int32_t bits;
+    std::int32_t mipCount;
+};
+
+// Preprocessed glTF models: vertices already interleaved in the VertexInterleaver layout and optimized,
+// textures decoded and mip-chained, so loading is a mmap and a few buffer uploads
+// A cache is stale if the version or the size/write time of the source or any file it references differ
+class MeshCache {
+public:
+    static constexpr char MAGIC[4] = {'R', 'C', 'G', 'M'};
+    static constexpr std::uint32_t VERSION = 10;
+    static constexpr std::size_t ALIGNMENT = 16;
+
+    // Quantized and float vertices are cached side by side
+    // The full path goes into the name, models with the same file name in different directories don't collide
+    static std::string getCachePath(const std::string &sourcePath, bool quantized) {
+        const std::string fullPath = AssetArchive::normalizePath(std::filesystem::absolute(sourcePath).string());
+        char pathHash[17];
+        std::snprintf(pathHash, sizeof(pathHash), "%016llx",
+                      static_cast<unsigned long long>(AssetArchive::hashPath(fullPath)));
+
+        return "../assets/cache/" + std::filesystem::path(sourcePath).filename().string() + "." + pathHash +
+               (quantized ? ".q.meshcache" : ".meshcache");
+    }
+
+    // Returns an unmapped file if there is no valid cache for the source
+    static MappedFile open(const std::string &sourcePath, bool quantized) {
+        MappedFile file{getCachePath(sourcePath, quantized)};
+
+        if (!file.isOpen() || file.size() < sizeof(MeshCacheHeader)) {
+            return {};
+        }
+
+        const MeshCacheHeader &header = getHeader(file);
+        std::uint64_t sourceSize;
+        std::int64_t sourceWriteTime;
+
+        if (!getSourceStamp(sourcePath, sourceSize, sourceWriteTime) ||
+            std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header.version != VERSION ||
+            header.sourceSize != sourceSize ||
+            header.sourceWriteTime != sourceWriteTime ||
+            !isValid(file) || !areDependenciesCurrent(file)) {
+            return {};
+        }
+
+        return file;
+    }
+
+    static bool write(const GltfScene &scene, const std::string &sourcePath, bool quantize) {
+        MeshCacheHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+
+        if (!getSourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime)) {
+            return false;
+        }
+
+        std::vector<MeshCacheDependency> dependencies(scene.externalFiles.size());
+
+        for (std::size_t i = 0; i < dependencies.size(); i++) {
+            if (!getSourceStamp(scene.externalFiles[i], dependencies[i].size, dependencies[i].writeTime)) {
+                return false;
+            }
+        }
+
+        const std::string cachePath = getCachePath(sourcePath, quantize);
+        const std::string tmpPath = cachePath + ".tmp";
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+
+        if (!out) {
+            std::cerr << "Unable to write mesh cache: " << cachePath << std::endl;
+            return false;
+        }
+
+        // Header gets rewritten once all offsets are known
+        writeAligned(out, &header, sizeof(header));
+
+        std::vector<MeshCachePrimitive> primitives;
+        std::vector<VertexAttribLayout> attributes;
+        std::vector<MeshCacheMaterial> materials;
+        std::vector<MeshCacheTexture> textures;
+        std::vector<MeshLodRange> lods;
+
+        for (const GltfObject &object: scene.objects) {
+            for (const GltfMesh &mesh: object.meshes) {
+                for (const GltfPrimitive &primitive: mesh.primitives) {
+                    const PrimitiveGeometry geometry = MeshOptimizer::buildGltfPrimitive(primitive, quantize);
+                    const InterleavedVertexData &vertexData = geometry.vertices;
+                    const PackedIndexData &indexData = geometry.indices;
+
+                    MeshCachePrimitive cachedPrimitive{};
+                    cachedPrimitive.vertexStride = vertexData.stride;
+                    cachedPrimitive.vertexCount = vertexData.vertexCount;
+                    cachedPrimitive.vertexBytes = vertexData.buffer.size();
+                    cachedPrimitive.vertexOffset = writeAligned(out, vertexData.buffer.data(), vertexData.buffer.size());
+                    cachedPrimitive.quantization = vertexData.quantization;
+                    cachedPrimitive.indexCount = indexData.count;
+                    cachedPrimitive.indexComponentType = indexData.componentType;
+                    cachedPrimitive.indexBytes = indexData.buffer.size();
+                    cachedPrimitive.indexOffset = writeAligned(out, indexData.buffer.data(), indexData.buffer.size());
+                    cachedPrimitive.materialIdx = primitive.materialIdx;
+                    cachedPrimitive.firstAttribute = static_cast<std::uint32_t>(attributes.size());
+                    cachedPrimitive.attributeCount = static_cast<std::uint32_t>(vertexData.attributes.size());
+                    cachedPrimitive.firstLod = static_cast<std::uint32_t>(lods.size());
+                    cachedPrimitive.lodCount = static_cast<std::uint32_t>(geometry.lods.size());
+
+                    lods.insert(lods.end(), geometry.lods.begin(), geometry.lods.end());
+
+                    attributes.insert(attributes.end(), vertexData.attributes.begin(), vertexData.attributes.end());
+                    primitives.push_back(cachedPrimitive);
+                }
+            }
+        }
+
+        for (const GltfImage &image: scene.images) {
+            MeshCacheTexture texture{};
+            const TextureContentHash contentHash = TextureCache::hashImage(image);
+            texture.hash = contentHash.hash;
+            texture.checkHash = contentHash.checkHash;
+            texture.width = image.width;
+            texture.height = image.height;
+            texture.component = image.component;
+            texture.pixelType = image.pixelType;
+            texture.bits = image.bits;
+
+            std::vector<unsigned char> mipChain = image.bits == 16
+                                                      ? generateMipChain<std::uint16_t>(image, texture.mipCount)
+                                                      : generateMipChain<std::uint8_t>(image, texture.mipCount);
+
+            texture.dataBytes = mipChain.size();
+            texture.dataOffset = writeAligned(out, mipChain.data(), mipChain.size());
+            textures.push_back(texture);
+        }
+
+        for (const GltfMaterial &material: scene.materials) {
+            MeshCacheMaterial cachedMaterial{};
+
+            for (int i = 0; i < 4; i++) {
+                cachedMaterial.baseColorFactor[i] = material.baseColorFactor[i];
+            }
+
+            for (const GltfTextureProperties &properties: material.textureProperties) {
+                if (cachedMaterial.textureCount < MeshCacheMaterial::MAX_TEXTURES) {
+                    cachedMaterial.textures[cachedMaterial.textureCount++] = {
+                        static_cast<std::int32_t>(properties.type), properties.index
+                    };
+                }
+            }
+
+            materials.push_back(cachedMaterial);
+        }
+
+        header.primitiveCount = static_cast<std::uint32_t>(primitives.size());
+        header.attributeCount = static_cast<std::uint32_t>(attributes.size());
+        header.materialCount = static_cast<std::uint32_t>(materials.size());
+        header.textureCount = static_cast<std::uint32_t>(textures.size());
+        header.lodCount = static_cast<std::uint32_t>(lods.size());
+        header.primitivesOffset = writeAligned(out, primitives.data(), primitives.size() * sizeof(MeshCachePrimitive));
+        header.attributesOffset = writeAligned(out, attributes.data(), attributes.size() * sizeof(VertexAttribLayout));
+        header.materialsOffset = writeAligned(out, materials.data(), materials.size() * sizeof(MeshCacheMaterial));
+        header.texturesOffset = writeAligned(out, textures.data(), textures.size() * sizeof(MeshCacheTexture));
+        header.lodsOffset = writeAligned(out, lods.data(), lods.size() * sizeof(MeshLodRange));
+
+        for (std::size_t i = 0; i < dependencies.size(); i++) {
+            const std::string &path = scene.externalFiles[i];
+            dependencies[i].pathLength = static_cast<std::uint32_t>(path.size());
+            dependencies[i].pathOffset = writeAligned(out, path.data(), path.size());
+        }
+
+        header.dependencyCount = static_cast<std::uint32_t>(dependencies.size());
+        header.dependenciesOffset = writeAligned(out, dependencies.data(),
+                                                 dependencies.size() * sizeof(MeshCacheDependency));
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.close();
+
+        if (!out) {
+            std::cerr << "Unable to write mesh cache: " << cachePath << std::endl;
+            return false;
+        }
+
+        // Readers never see a half written cache
+        std::filesystem::rename(tmpPath, cachePath, error);
+        return !error;
+    }
+
+    static const MeshCacheHeader &getHeader(const MappedFile &file) {
+        return *reinterpret_cast<const MeshCacheHeader *>(file.data());
+    }
+
+    template<typename T>
+    static const T *getTable(const MappedFile &file, std::uint64_t offset) {
+        return reinterpret_cast<const T *>(file.data() + offset);
+    }
+
+    // Size of a single mip level in bytes
+    static std::size_t getMipSize(const MeshCacheTexture &texture, int width, int height) {
+        return static_cast<std::size_t>(width) * height * texture.component * (texture.bits / 8);
+    }
+
+private:
+    static bool isInFile(const MappedFile &file, std::uint64_t offset, std::uint64_t size) {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    static bool isTableInFile(const MappedFile &file, std::uint64_t offset, std::uint64_t count, std::size_t elementSize) {
+        return count <= file.size() / elementSize && isInFile(file, offset, count * elementSize);
+    }
+
+    static std::uint32_t getIndexSize(std::uint32_t componentType) {
+        switch (componentType) {
+            case GL_UNSIGNED_BYTE: return 1;
+            case GL_UNSIGNED_SHORT: return 2;
+            case GL_UNSIGNED_INT: return 4;
+            default: return 0;
+        }
+    }
+
+    // Every table, range and index taken from the file has to stay inside the mapping,
+    // a truncated or corrupt cache is treated like a missing one
+    static bool isValid(const MappedFile &file) {
+        const MeshCacheHeader &header = getHeader(file);
+
+        if (!isTableInFile(file, header.primitivesOffset, header.primitiveCount, sizeof(MeshCachePrimitive)) ||
+            !isTableInFile(file, header.attributesOffset, header.attributeCount, sizeof(VertexAttribLayout)) ||
+            !isTableInFile(file, header.materialsOffset, header.materialCount, sizeof(MeshCacheMaterial)) ||
+            !isTableInFile(file, header.texturesOffset, header.textureCount, sizeof(MeshCacheTexture)) ||
+            !isTableInFile(file, header.lodsOffset, header.lodCount, sizeof(MeshLodRange)) ||
+            !isTableInFile(file, header.dependenciesOffset, header.dependencyCount, sizeof(MeshCacheDependency))) {
+            return false;
+        }
+
+        const auto *dependencies = getTable<MeshCacheDependency>(file, header.dependenciesOffset);
+
+        for (std::uint32_t i = 0; i < header.dependencyCount; i++) {
+            if (!isInFile(file, dependencies[i].pathOffset, dependencies[i].pathLength)) {
+                return false;
+            }
+        }
+
+        const auto *primitives = getTable<MeshCachePrimitive>(file, header.primitivesOffset);
+        const auto *materials = getTable<MeshCacheMaterial>(file, header.materialsOffset);
+        const auto *textures = getTable<MeshCacheTexture>(file, header.texturesOffset);
+        const auto *lods = getTable<MeshLodRange>(file, header.lodsOffset);
+
+        for (std::uint32_t i = 0; i < header.primitiveCount; i++) {
+            const MeshCachePrimitive &primitive = primitives[i];
+            const std::uint32_t indexSize = getIndexSize(primitive.indexComponentType);
+
+            if (!isInFile(file, primitive.vertexOffset, primitive.vertexBytes) ||
+                !isInFile(file, primitive.indexOffset, primitive.indexBytes) ||
+                static_cast<std::uint64_t>(primitive.vertexCount) * primitive.vertexStride > primitive.vertexBytes ||
+                indexSize == 0 ||
+                static_cast<std::uint64_t>(primitive.indexCount) * indexSize > primitive.indexBytes ||
+                primitive.firstAttribute > header.attributeCount ||
+                primitive.attributeCount > header.attributeCount - primitive.firstAttribute ||
+                primitive.lodCount == 0 ||
+                primitive.firstLod > header.lodCount ||
+                primitive.lodCount > header.lodCount - primitive.firstLod ||
+                primitive.materialIdx >= static_cast<std::int64_t>(header.materialCount)) {
+                return false;
+            }
+
+            for (std::uint32_t j = 0; j < primitive.lodCount; j++) {
+                const MeshLodRange &lod = lods[primitive.firstLod + j];
+
+                if (lod.firstIndex > primitive.indexCount || lod.indexCount > primitive.indexCount - lod.firstIndex) {
+                    return false;
+                }
+            }
+        }
+
+        for (std::uint32_t i = 0; i < header.materialCount; i++) {
+            const MeshCacheMaterial &material = materials[i];
+
+            if (material.textureCount > MeshCacheMaterial::MAX_TEXTURES) {
+                return false;
+            }
+
+            for (std::uint32_t j = 0; j < material.textureCount; j++) {
+                const std::int32_t textureIdx = material.textures[j].textureIdx;
+
+                if (textureIdx < 0 || static_cast<std::uint32_t>(textureIdx) >= header.textureCount) {
+                    return false;
+                }
+            }
+        }
+
+        for (std::uint32_t i = 0; i < header.textureCount; i++) {
+            const MeshCacheTexture &texture = textures[i];
+
+            if (!isInFile(file, texture.dataOffset, texture.dataBytes) || texture.width < 0 || texture.height < 0 ||
+                texture.mipCount < 1 || texture.mipCount > 32) {
+                return false;
+            }
+
+            // Same walk as the upload
+            std::uint64_t chainBytes = 0;
+            int width = texture.width;
+            int height = texture.height;
+
+            for (int mip = 0; mip < texture.mipCount; mip++) {
+                chainBytes += getMipSize(texture, width, height);
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+
+            if (chainBytes > texture.dataBytes) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // A referenced file that went missing or changed makes the cache stale
+    static bool areDependenciesCurrent(const MappedFile &file) {
+        const MeshCacheHeader &header = getHeader(file);
+        const auto *dependencies = getTable<MeshCacheDependency>(file, header.dependenciesOffset);
+
+        for (std::uint32_t i = 0; i < header.dependencyCount; i++) {
+            const MeshCacheDependency &dependency = dependencies[i];
+            const std::string path{reinterpret_cast<const char *>(file.data() + dependency.pathOffset), dependency.pathLength};
+            std::uint64_t size;
+            std::int64_t writeTime;
+
+            if (!getSourceStamp(path, size, writeTime) || size != dependency.size || writeTime != dependency.writeTime) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool getSourceStamp(const std::string &sourcePath, std::uint64_t &size, std::int64_t &writeTime) {
+        // Packed sources are stamped with the archive build time
+        if (std::optional<AssetView> view = AssetArchive::instance().find(sourcePath)) {
+            size = view->size;
+            writeTime = AssetArchive::instance().getBuildTime();
+            return true;
+        }
+
+        std::error_code error;
+        size = std::filesystem::file_size(sourcePath, error);
+
+        if (error) {
+            return false;
+        }
+
+        writeTime = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+        return !error;
+    }
+
+    // Returns the offset the data got written to
+    static std::uint64_t writeAligned(std::ofstream &out, const void *data, std::size_t size) {
+        static const char zeros[ALIGNMENT] = {};
+
+        const std::uint64_t position = out.tellp();
+        const std::uint64_t padding = (ALIGNMENT - position % ALIGNMENT) % ALIGNMENT;
+        out.write(zeros, static_cast<std::streamsize>(padding));
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+
+        return position + padding;
+    }
+
+    // Box filter down to 1x1, a texel averages the source texels it covers
+    // Even sizes take 2x2 texels, odd ones 3 along that axis, so the last row and column aren't dropped
+    template<typename T>
+    static std::vector<unsigned char> generateMipChain(const GltfImage &image, std::int32_t &mipCount) {
+        const int components = image.component;
+        std::vector<T> level(image.buffer.size() / sizeof(T));
+        std::memcpy(level.data(), image.buffer.data(), image.buffer.size());
+
+        std::vector<unsigned char> chain(image.buffer.begin(), image.buffer.end());
+        int width = image.width;
+        int height = image.height;
+        mipCount = 1;
+
+        while (width > 1 || height > 1) {
+            const int nextWidth = std::max(1, width / 2);
+            const int nextHeight = std::max(1, height / 2);
+            std::vector<T> next(static_cast<std::size_t>(nextWidth) * nextHeight * components);
+
+            for (int y = 0; y < nextHeight; y++) {
+                // Source rows [y0, y1), the rounded up end picks up the odd row
+                const int y0 = y * height / nextHeight;
+                const int y1 = ((y + 1) * height + nextHeight - 1) / nextHeight;
+
+                for (int x = 0; x < nextWidth; x++) {
+                    const int x0 = x * width / nextWidth;
+                    const int x1 = ((x + 1) * width + nextWidth - 1) / nextWidth;
+                    const std::uint32_t texelCount = (y1 - y0) * (x1 - x0);
+
+                    for (int c = 0; c < components; c++) {
+                        std::uint32_t sum = 0;
+
+                        for (int sy = y0; sy < y1; sy++) {
+                            for (int sx = x0; sx < x1; sx++) {
+                                sum += level[(static_cast<std::size_t>(sy) * width + sx) * components + c];
+                            }
+                        }
+
+                        next[(static_cast<std::size_t>(y) * nextWidth + x) * components + c] = static_cast<T>(
+                            (sum + texelCount / 2) / texelCount);
+                    }
+                }
+            }
+
+            const auto *bytes = reinterpret_cast<const unsigned char *>(next.data());
+            chain.insert(chain.end(), bytes, bytes + next.size() * sizeof(T));
+
+            level = std::move(next);
+            width = nextWidth;
+            height = nextHeight;
+            mipCount++;
+        }
+
+        return chain;
+    }
+};
+
+
+#endif //MESHCACHE_H
@@ -0,0 +1,536 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Index range of one LOD inside the primitive's index buffer, also stored as is in the mesh cache
+struct MeshLodRange {
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    float error; // Object space deviation from the full mesh
+    std::uint32_t padding;
+};
+
+struct MeshLod {
+    std::vector<std::uint32_t> indices;
+    float error;
+};
+
+// Quadric error metric simplification (Garland and Heckbert 1997) with half edge collapses,
+// vertices only get removed, so every LOD is an index buffer over the original vertex buffer
+// Vertices sharing a position (UV/normal seams) are collapsed together along the seam and
+// vertices on open borders only along the border, so neither tears open
+class MeshSimplifier {
+public:
+    static constexpr float LOD_REDUCTION = 0.5f; // Triangle ratio between neighbouring LODs
+    static constexpr std::uint32_t MAX_LODS = 4;
+    static constexpr std::uint32_t MIN_LOD_TRIANGLES = 32;
+
+    // lods[0] is the input, stops early once a level can't be reduced noticeably
+    static std::vector<MeshLod> generateLodChain(const std::vector<std::uint32_t> &indices,
+                                                 const std::vector<glm::vec3> &positions,
+                                                 std::uint32_t maxLods = MAX_LODS,
+                                                 float reduction = LOD_REDUCTION) {
+        std::vector<MeshLod> lods{{indices, 0.0f}};
+
+        while (lods.size() < maxLods && lods.back().indices.size() / 3 > MIN_LOD_TRIANGLES) {
+            const MeshLod &previous = lods.back();
+            const auto targetIndexCount = static_cast<std::size_t>(previous.indices.size() / 3 * reduction) * 3;
+
+            float error = 0.0f;
+            std::vector<std::uint32_t> simplified = simplify(previous.indices, positions, targetIndexCount,
+                                                             std::numeric_limits<float>::max(), &error);
+
+            if (simplified.empty() || simplified.size() > previous.indices.size() * 9 / 10) {
+                break;
+            }
+
+            // Each level is simplified from the previous one, errors add up
+            lods.push_back({std::move(simplified), previous.error + error});
+        }
+
+        return lods;
+    }
+
+    // Collapses edges until the index count is at most targetIndexCount or no collapse stays below maxError
+    static std::vector<std::uint32_t> simplify(const std::vector<std::uint32_t> &indices,
+                                               const std::vector<glm::vec3> &positions,
+                                               std::size_t targetIndexCount, float maxError,
+                                               float *resultError = nullptr) {
+        const auto vertexCount = static_cast<std::uint32_t>(positions.size());
+        std::vector<std::uint32_t> result = indices;
+        float error = 0.0f;
+
+        // Vertices sharing a position are one vertex for topology and error
+        const std::vector<std::uint32_t> canonical = getCanonicalVertices(positions);
+        std::vector<std::uint32_t> sibling;
+        std::unordered_map<std::uint64_t, EdgeInfo> edges = analyzeEdges(result, canonical);
+        const std::vector<VertexKind> kinds = classifyVertices(result, canonical, edges, sibling);
+        std::vector<Quadric> quadrics = computeQuadrics(result, positions, canonical, edges);
+
+        const double maxErrorSquared = static_cast<double>(maxError) * maxError;
+
+        while (result.size() > targetIndexCount) {
+            std::vector<Collapse> collapses = collectCollapses(result, positions, canonical, kinds, edges, quadrics,
+                                                               maxErrorSquared);
+
+            if (collapses.empty()) {
+                break;
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+                return a.cost < b.cost;
+            });
+
+            const std::vector<std::vector<std::uint32_t> > vertexTriangles = getVertexTriangles(result, vertexCount);
+            std::vector<std::uint32_t> remap(vertexCount);
+            std::vector<bool> locked(vertexCount, false);
+            for (std::uint32_t i = 0; i < vertexCount; i++) {
+                remap[i] = i;
+            }
+
+            // Only independent collapses per pass, every touched one-ring gets locked
+            // A pass removes at most half of the remaining triangles so costs get re-sorted often
+            const std::size_t triangleGoal = (result.size() - targetIndexCount) / 3 / 2 + 1;
+            std::size_t removedTriangles = 0;
+            std::size_t applied = 0;
+
+            for (const Collapse &collapse: collapses) {
+                if (removedTriangles >= triangleGoal) {
+                    break;
+                }
+
+                const std::uint32_t from = canonical[collapse.from];
+                const std::uint32_t to = canonical[collapse.to];
+
+                if (locked[from] || locked[to]) {
+                    continue;
+                }
+
+                // Seam vertices move together, each to the vertex of the target it shares an edge with
+                std::uint32_t wedges[2][2] = {{collapse.from, collapse.to}, {0, 0}};
+                std::uint32_t wedgeCount = 1;
+
+                if (kinds[from] == VertexKind::SEAM) {
+                    wedges[1][0] = sibling[collapse.from];
+                    wedges[1][1] = findNeighbour(wedges[1][0], to, result, canonical, vertexTriangles);
+                    wedgeCount = 2;
+
+                    if (wedges[1][1] == INVALID_VERTEX) {
+                        continue;
+                    }
+                }
+
+                bool flips = false;
+                for (std::uint32_t w = 0; w < wedgeCount; w++) {
+                    flips |= flipsTriangles(wedges[w][0], wedges[w][1], result, positions, canonical,
+                                            vertexTriangles[wedges[w][0]]);
+                }
+
+                if (flips) {
+                    continue;
+                }
+
+                for (std::uint32_t w = 0; w < wedgeCount; w++) {
+                    for (const std::uint32_t triangle: vertexTriangles[wedges[w][0]]) {
+                        for (int k = 0; k < 3; k++) {
+                            const std::uint32_t vertex = canonical[result[triangle * 3 + k]];
+                            locked[vertex] = true;
+                            removedTriangles += vertex == to;
+                        }
+                    }
+
+                    remap[wedges[w][0]] = wedges[w][1];
+                }
+
+                quadrics[to] += quadrics[from];
+                error = std::max(error, static_cast<float>(std::sqrt(collapse.cost)));
+                applied++;
+            }
+
+            if (applied == 0) {
+                break;
+            }
+
+            // Apply the remap and drop triangles that became degenerate
+            std::vector<std::uint32_t> next;
+            next.reserve(result.size());
+
+            for (std::size_t t = 0; t < result.size(); t += 3) {
+                const std::uint32_t a = remap[result[t]];
+                const std::uint32_t b = remap[result[t + 1]];
+                const std::uint32_t c = remap[result[t + 2]];
+
+                if (canonical[a] != canonical[b] && canonical[b] != canonical[c] && canonical[a] != canonical[c]) {
+                    next.insert(next.end(), {a, b, c});
+                }
+            }
+
+            result = std::move(next);
+            edges = analyzeEdges(result, canonical);
+        }
+
+        if (resultError) {
+            *resultError = error;
+        }
+
+        return result;
+    }
+
+private:
+    enum class VertexKind : std::uint8_t {
+        MANIFOLD, // Interior, collapses along any edge
+        BORDER, // On an open edge, collapses along the border
+        SEAM, // Two vertices share the position, collapse along the seam
+        LOCKED // Corners, seams meeting borders or other seams
+    };
+
+    // Edge between two positions, vertices are the first use, ordered by position
+    struct EdgeInfo {
+        std::uint32_t triangles;
+        std::uint32_t vertices[2];
+        bool seam; // Triangles on both sides use different vertices
+    };
+
+    // Symmetric 4x4 matrix, error of a point is p^T Q p divided by the summed plane weights
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(const glm::dvec3 &n, double d, double weight) {
+            Quadric q;
+            q.a00 = n.x * n.x * weight;
+            q.a01 = n.x * n.y * weight;
+            q.a02 = n.x * n.z * weight;
+            q.a03 = n.x * d * weight;
+            q.a11 = n.y * n.y * weight;
+            q.a12 = n.y * n.z * weight;
+            q.a13 = n.y * d * weight;
+            q.a22 = n.z * n.z * weight;
+            q.a23 = n.z * d * weight;
+            q.a33 = d * d * weight;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric &operator+=(const Quadric &o) {
+            a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+            a11 += o.a11; a12 += o.a12; a13 += o.a13;
+            a22 += o.a22; a23 += o.a23;
+            a33 += o.a33;
+            weight += o.weight;
+            return *this;
+        }
+
+        // Squared distance to the planes, weighted average
+        [[nodiscard]] double evaluate(const glm::vec3 &p) const {
+            const double x = p.x, y = p.y, z = p.z;
+            const double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                                 a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                                 a22 * z * z + 2 * a23 * z +
+                                 a33;
+            return weight > 0.0 ? std::abs(error) / weight : 0.0;
+        }
+    };
+
+    struct Collapse {
+        std::uint32_t from;
+        std::uint32_t to;
+        double cost;
+    };
+
+    static constexpr std::uint32_t INVALID_VERTEX = std::numeric_limits<std::uint32_t>::max();
+
+    // Planes along borders and seams keep them in place, relative to the surface planes
+    static constexpr double BORDER_WEIGHT = 10.0;
+    static constexpr double SEAM_WEIGHT = 1.0;
+
+    static std::uint64_t edgeKey(std::uint32_t a, std::uint32_t b) {
+        return a < b ? (static_cast<std::uint64_t>(a) << 32 | b) : (static_cast<std::uint64_t>(b) << 32 | a);
+    }
+
+    static std::vector<std::uint32_t> getCanonicalVertices(const std::vector<glm::vec3> &positions) {
+        struct PositionHash {
+            std::size_t operator()(const glm::vec3 &p) const {
+                std::uint32_t bits[3];
+                std::memcpy(bits, &p[0], sizeof(float));
+                std::memcpy(bits + 1, &p[1], sizeof(float));
+                std::memcpy(bits + 2, &p[2], sizeof(float));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+
+        std::unordered_map<glm::vec3, std::uint32_t, PositionHash> firstVertex;
+        std::vector<std::uint32_t> canonical(positions.size());
+
+        for (std::uint32_t i = 0; i < positions.size(); i++) {
+            canonical[i] = firstVertex.emplace(positions[i], i).first->second;
+        }
+
+        return canonical;
+    }
+
+    static std::unordered_map<std::uint64_t, EdgeInfo> analyzeEdges(const std::vector<std::uint32_t> &indices,
+                                                                     const std::vector<std::uint32_t> &canonical) {
+        std::unordered_map<std::uint64_t, EdgeInfo> edges;
+        edges.reserve(indices.size());
+
+        for (std::size_t t = 0; t < indices.size(); t += 3) {
+            for (int k = 0; k < 3; k++) {
+                std::uint32_t a = indices[t + k];
+                std::uint32_t b = indices[t + (k + 1) % 3];
+
+                if (canonical[a] > canonical[b]) {
+                    std::swap(a, b);
+                }
+
+                auto [it, inserted] = edges.try_emplace(edgeKey(canonical[a], canonical[b]), EdgeInfo{0, {a, b}, false});
+                EdgeInfo &edge = it->second;
+                edge.triangles++;
+                edge.seam |= edge.vertices[0] != a || edge.vertices[1] != b;
+            }
+        }
+
+        return edges;
+    }
+
+    // Kinds are per position, sibling links the two vertices of a seam position
+    static std::vector<VertexKind> classifyVertices(const std::vector<std::uint32_t> &indices,
+                                                    const std::vector<std::uint32_t> &canonical,
+                                                    const std::unordered_map<std::uint64_t, EdgeInfo> &edges,
+                                                    std::vector<std::uint32_t> &sibling) {
+        const std::size_t vertexCount = canonical.size();
+        std::vector<bool> used(vertexCount, false);
+        for (const std::uint32_t index: indices) {
+            used[index] = true;
+        }
+
+        std::vector<std::uint32_t> wedgeCount(vertexCount, 0);
+        std::vector<std::uint32_t> firstWedge(vertexCount, INVALID_VERTEX);
+        sibling.assign(vertexCount, INVALID_VERTEX);
+
+        for (std::uint32_t i = 0; i < vertexCount; i++) {
+            if (!used[i]) {
+                continue;
+            }
+
+            const std::uint32_t position = canonical[i];
+            if (wedgeCount[position]++ == 0) {
+                firstWedge[position] = i;
+            } else {
+                sibling[i] = firstWedge[position];
+                sibling[firstWedge[position]] = i;
+            }
+        }
+
+        std::vector<std::uint32_t> borderEdges(vertexCount, 0);
+        std::vector<std::uint32_t> seamEdges(vertexCount, 0);
+
+        for (const auto &[key, edge]: edges) {
+            for (const std::uint32_t position: {static_cast<std::uint32_t>(key >> 32), static_cast<std::uint32_t>(key)}) {
+                borderEdges[position] += edge.triangles == 1;
+                seamEdges[position] += edge.seam;
+            }
+        }
+
+        std::vector<VertexKind> kinds(vertexCount, VertexKind::LOCKED);
+
+        for (std::uint32_t i = 0; i < vertexCount; i++) {
+            if (canonical[i] != i) {
+                continue;
+            }
+
+            if (wedgeCount[i] == 1 && borderEdges[i] == 0) {
+                kinds[i] = VertexKind::MANIFOLD;
+            } else if (wedgeCount[i] == 1 && borderEdges[i] == 2) {
+                kinds[i] = VertexKind::BORDER;
+            } else if (wedgeCount[i] == 2 && seamEdges[i] == 2 && borderEdges[i] == 0) {
+                kinds[i] = VertexKind::SEAM;
+            }
+        }
+
+        return kinds;
+    }
+
+    static std::vector<Quadric> computeQuadrics(const std::vector<std::uint32_t> &indices,
+                                                const std::vector<glm::vec3> &positions,
+                                                const std::vector<std::uint32_t> &canonical,
+                                                const std::unordered_map<std::uint64_t, EdgeInfo> &edges) {
+        std::vector<Quadric> quadrics(positions.size());
+
+        for (std::size_t t = 0; t < indices.size(); t += 3) {
+            const glm::dvec3 p0(positions[indices[t]]);
+            const glm::dvec3 p1(positions[indices[t + 1]]);
+            const glm::dvec3 p2(positions[indices[t + 2]]);
+
+            const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const double area = glm::length(normal);
+
+            if (area <= 0.0) {
+                continue;
+            }
+
+            const glm::dvec3 n = normal / area;
+            const Quadric plane = Quadric::fromPlane(n, -glm::dot(n, p0), area * 0.5);
+
+            for (int k = 0; k < 3; k++) {
+                quadrics[canonical[indices[t + k]]] += plane;
+            }
+
+            // Plane through border and seam edges, perpendicular to the triangle
+            for (int k = 0; k < 3; k++) {
+                const std::uint32_t a = indices[t + k];
+                const std::uint32_t b = indices[t + (k + 1) % 3];
+                const EdgeInfo &edge = edges.at(edgeKey(canonical[a], canonical[b]));
+
+                if (edge.triangles != 1 && !edge.seam) {
+                    continue;
+                }
+
+                const glm::dvec3 pa(positions[a]);
+                const glm::dvec3 direction = glm::dvec3(positions[b]) - pa;
+                const double length = glm::length(direction);
+
+                if (length <= 0.0) {
+                    continue;
+                }
+
+                const glm::dvec3 edgeNormal = glm::normalize(glm::cross(direction, n));
+                const double weight = length * length * (edge.triangles == 1 ? BORDER_WEIGHT : SEAM_WEIGHT);
+                const Quadric edgePlane = Quadric::fromPlane(edgeNormal, -glm::dot(edgeNormal, pa), weight);
+
+                quadrics[canonical[a]] += edgePlane;
+                quadrics[canonical[b]] += edgePlane;
+            }
+        }
+
+        return quadrics;
+    }
+
+    static std::vector<Collapse> collectCollapses(const std::vector<std::uint32_t> &indices,
+                                                  const std::vector<glm::vec3> &positions,
+                                                  const std::vector<std::uint32_t> &canonical,
+                                                  const std::vector<VertexKind> &kinds,
+                                                  const std::unordered_map<std::uint64_t, EdgeInfo> &edges,
+                                                  const std::vector<Quadric> &quadrics,
+                                                  double maxErrorSquared) {
+        std::vector<Collapse> best(positions.size(), {0, 0, std::numeric_limits<double>::max()});
+
+        // Cheapest collapse per position, the edge direction decides which position gets removed
+        for (std::size_t t = 0; t < indices.size(); t += 3) {
+            for (int k = 0; k < 6; k++) {
+                const std::uint32_t from = indices[t + (k < 3 ? k : (k + 1) % 3)];
+                const std::uint32_t to = indices[t + (k < 3 ? (k + 1) % 3 : k % 3)];
+                const std::uint32_t fromPosition = canonical[from];
+                const std::uint32_t toPosition = canonical[to];
+                const VertexKind kind = kinds[fromPosition];
+
+                if (kind == VertexKind::LOCKED) {
+                    continue;
+                }
+
+                if (kind != VertexKind::MANIFOLD) {
+                    const EdgeInfo &edge = edges.at(edgeKey(fromPosition, toPosition));
+
+                    if ((kind == VertexKind::BORDER && edge.triangles != 1) || (kind == VertexKind::SEAM && !edge.seam)) {
+                        continue;
+                    }
+                }
+
+                Quadric quadric = quadrics[fromPosition];
+                quadric += quadrics[toPosition];
+                const double cost = quadric.evaluate(positions[to]);
+
+                if (cost < best[fromPosition].cost && cost <= maxErrorSquared) {
+                    best[fromPosition] = {from, to, cost};
+                }
+            }
+        }
+
+        std::vector<Collapse> collapses;
+        for (const Collapse &collapse: best) {
+            if (collapse.cost != std::numeric_limits<double>::max()) {
+                collapses.push_back(collapse);
+            }
+        }
+
+        return collapses;
+    }
+
+    static std::vector<std::vector<std::uint32_t> > getVertexTriangles(const std::vector<std::uint32_t> &indices,
+                                                                       std::uint32_t vertexCount) {
+        std::vector<std::vector<std::uint32_t> > vertexTriangles(vertexCount);
+
+        for (std::size_t t = 0; t < indices.size(); t += 3) {
+            for (int k = 0; k < 3; k++) {
+                vertexTriangles[indices[t + k]].push_back(static_cast<std::uint32_t>(t / 3));
+            }
+        }
+
+        return vertexTriangles;
+    }
+
+    // Vertex at the given position sharing a triangle with vertex
+    static std::uint32_t findNeighbour(std::uint32_t vertex, std::uint32_t position,
+                                       const std::vector<std::uint32_t> &indices,
+                                       const std::vector<std::uint32_t> &canonical,
+                                       const std::vector<std::vector<std::uint32_t> > &vertexTriangles) {
+        for (const std::uint32_t triangle: vertexTriangles[vertex]) {
+            for (int k = 0; k < 3; k++) {
+                if (canonical[indices[triangle * 3 + k]] == position) {
+                    return indices[triangle * 3 + k];
+                }
+            }
+        }
+
+        return INVALID_VERTEX;
+    }
+
+    // Rejects collapses that turn a remaining triangle around
+    static bool flipsTriangles(std::uint32_t from, std::uint32_t to, const std::vector<std::uint32_t> &indices,
+                               const std::vector<glm::vec3> &positions, const std::vector<std::uint32_t> &canonical,
+                               const std::vector<std::uint32_t> &triangles) {
+        for (const std::uint32_t triangle: triangles) {
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            bool collapsed = false;
+
+            for (int k = 0; k < 3; k++) {
+                const std::uint32_t vertex = indices[triangle * 3 + k];
+                collapsed |= canonical[vertex] == canonical[to];
+                before[k] = positions[vertex];
+                after[k] = vertex == from ? positions[to] : positions[vertex];
+            }
+
+            // Triangles containing both positions disappear
+            if (collapsed) {
+                continue;
+            }
+
+            const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+            if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+
+#endif //MESHSIMPLIFIER_H
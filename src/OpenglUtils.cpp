@@ -4,6 +4,9 @@
 
 #include "OpenglUtils.h"
 
+#include "AssetArchive.h"
+#include "ThreadPool.h"
+
 namespace opengl_utils {
     std::vector<const GltfPrimitive *> unpackGltfScene(const GltfScene &scene) {
         std::vector<const GltfPrimitive *> primitives;
@@ -21,8 +24,14 @@ namespace opengl_utils {
 
     ImageData loadImage(const std::string &imagePath) {
         int width, height, nChannels;
+        unsigned char *data;
 
-        unsigned char *data = stbi_load(imagePath.c_str(), &width, &height, &nChannels, 0);
+        if (std::optional<AssetView> view = AssetArchive::instance().find(imagePath)) {
+            data = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(view->data), static_cast<int>(view->size),
+                                         &width, &height, &nChannels, 0);
+        } else {
+            data = stbi_load(imagePath.c_str(), &width, &height, &nChannels, 0);
+        }
 
         if (data) {
             return {
@@ -36,7 +45,18 @@ namespace opengl_utils {
         }
     }
 
-    TextureHandle createTexture(int width, int height, int nChannels, bool repeatTexture, GLuint target) {
+    std::future<ImageData> loadImageAsync(const std::string &imagePath) {
+        return ThreadPool::decodePool().submit([imagePath] {
+            return loadImage(imagePath);
+        });
+    }
+
+    void freeImage(ImageData &image) {
+        stbi_image_free(image.buffer);
+        image.buffer = nullptr;
+    }
+
+    int getPixelFormat(int nChannels) {
         int format = GL_RGBA;
 
         switch (nChannels) {
@@ -48,6 +68,12 @@ namespace opengl_utils {
             break;
         }
 
+        return format;
+    }
+
+    TextureHandle createTexture(int width, int height, int nChannels, bool repeatTexture, GLuint target) {
+        int format = getPixelFormat(nChannels);
+
         GLuint handle;
         glGenTextures(1, &handle);
         glBindTexture(target, handle);
@@ -102,10 +128,16 @@ namespace opengl_utils {
             throw std::runtime_error("6 images are required to generate a cube map texture");
         }
 
+        // Decode all faces in parallel, upload happens in order once all are done
+        std::vector<std::future<ImageData> > pendingImages;
         std::vector<ImageData> images;
 
         for (const std::string &path : imagePaths) {
-            images.emplace_back(loadImage(path));
+            pendingImages.emplace_back(loadImageAsync(path));
+        }
+
+        for (std::future<ImageData> &pendingImage : pendingImages) {
+            images.emplace_back(pendingImage.get());
         }
 
         // We assume all images got the same size
@@ -114,6 +146,7 @@ namespace opengl_utils {
         // Set all sides of the cube map texture
         for (std::size_t i = 0; i < images.size(); i++) {
             updateTextureData(cubeTex, images[i], GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+            freeImage(images[i]);
         }
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -8,6 +8,7 @@
 #include <vector>
 #include <cassert>
 #include <cstring>
+#include <future>
 
 #include "GltfLoader.h"
 #include "glad/glad.h"
@@ -15,6 +16,7 @@
 
 #include "ImageData.h"
 #include "TextureHandle.h"
+#include "VertexInterleaver.h"
 
 struct VaoHandle {
     GLuint id;
@@ -136,23 +138,21 @@ namespace opengl_utils {
         glGenVertexArrays(1, &VAO);
         glBindVertexArray(VAO);
 
-        // Generate interleaved byte buffer of vertex attributes
-        std::byte mainBuffer[mainBufferSize]{};
+        // Generate interleaved byte buffer of vertex attributes, heap backed so large meshes don't blow the stack
+        std::byte *mainBuffer = VertexInterleaver::getScratchBuffer(mainBufferSize);
+        std::vector<InterleaveSource> sources;
 
-        for (std::size_t i = 0; i < processedArrays.size(); i++) {
-            const ProcessedVertexArray &attribArray = processedArrays[i];
-
-            for (std::size_t j = 0; j < attribArray.elemCount; j++) {
-                std::size_t mainBufferPos = j * maxOffset + attribArray.bufferOffset;
-                std::size_t vertBufferPos = j * attribArray.stride;
-
-                std::memcpy(mainBuffer + mainBufferPos,
-                            (attribArray.buffer + vertBufferPos),
-                            attribArray.stride
-                );
-            }
+        for (const ProcessedVertexArray &attribArray : processedArrays) {
+            assert(attribArray.elemCount == processedArrays[0].elemCount);
+            sources.push_back({
+                static_cast<const std::byte *>(attribArray.buffer), attribArray.stride,
+                static_cast<std::uint32_t>(attribArray.stride), static_cast<std::uint32_t>(attribArray.bufferOffset)
+            });
         }
 
+        VertexInterleaver::interleave(sources.data(), sources.size(), processedArrays[0].elemCount,
+                                      static_cast<std::uint32_t>(maxOffset), mainBuffer);
+
         // Generate VBO and bind
         GLuint VBO;
         glGenBuffers(1, &VBO);
@@ -248,12 +248,11 @@ inline PrimitiveData getPrimitive(PrimitiveType type) {
 
         auto constructVector = [](const GltfVertexAttrib &attrib) -> std::vector<GLfloat> {
             // We assume its always GLfloat
-            GLfloat *dataPtr = static_cast<GLfloat *>(attrib.buffer);
             std::size_t vecSize = attrib.bufferSize / 4; // 4 byte for float
             std::vector<GLfloat> vec;
             vec.resize(vecSize);
 
-            std::memcpy(vec.data(), dataPtr, attrib.bufferSize);
+            attrib.copyPacked(vec.data());
 
             return vec;
         };
@@ -264,12 +263,7 @@ inline PrimitiveData getPrimitive(PrimitiveType type) {
         data.tangents = constructVector(tangent);
 
         if (color) {
-            GLfloat *dataPtr = static_cast<GLfloat *>(color->buffer);
-            std::size_t vecSize = color->bufferSize / 4; // 4 byte for float
-            std::vector<GLfloat> tempVec;
-            tempVec.resize(vecSize);
-
-            std::memcpy(tempVec.data(), dataPtr, color->bufferSize);
+            std::vector<GLfloat> tempVec = constructVector(*color);
 
             std::vector<GLushort> convertedColors;
             convertedColors.reserve(tempVec.size());
@@ -332,6 +326,10 @@ inline PrimitiveData getPrimitive(PrimitiveType type) {
 
 
     ImageData loadImage(const std::string &imagePath);
+    // Decodes on the shared decode pool, the result has to be freed with freeImage
+    std::future<ImageData> loadImageAsync(const std::string &imagePath);
+    void freeImage(ImageData &image);
+    int getPixelFormat(int nChannels);
     TextureHandle createTexture(int width, int height, int nChannels = 4, bool repeatTexture = false, GLuint target = GL_TEXTURE_2D);
     TextureHandle createTexture(const ImageData &image, bool repeatTexture = false, GLuint target = GL_TEXTURE_2D);
     void updateTextureData(TextureHandle texture, const ImageData &image, GLuint target = GL_TEXTURE_2D);
@@ -5,18 +5,60 @@
 #ifndef RENDERCALL_H
 #define RENDERCALL_H
 
+#include <cstdint>
 #include <map>
 #include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
 
 #include "TextureType.h"
 #include "glad/glad.h"
 
+// Index range of a simplified version, error is the object space deviation from the full mesh
+struct RenderCallLod {
+    GLuint firstIndex;
+    GLuint elemCount;
+    float error;
+};
+
 struct RenderCall {
     GLuint vao;
     GLuint elemCount;
     int componentType;
 
     std::map<TextureType, GLuint> textureHandles;
+
+    // Position inside shared buffers (GeometryArena), 0 for meshes with their own buffers
+    GLint baseVertex = 0;
+    GLuint firstIndex = 0;
+
+    // Buffers attached to the shared format VAO, 0 if the VAO owns its buffers
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLuint vertexStride = 0;
+
+    // Dequantization of quantized vertices, see VertexQuantization
+    glm::vec3 positionScale{1.0f};
+    glm::vec3 positionOffset{0.0f};
+    bool octEncoded = false;
+
+    // All levels in the same buffers, full mesh first, empty for meshes without LODs
+    std::vector<RenderCallLod> lods;
+
+    [[nodiscard]] const void *getIndexOffset() const {
+        return getIndexOffset(firstIndex);
+    }
+
+    [[nodiscard]] const void *getIndexOffset(GLuint first) const {
+        GLuint indexSize = sizeof(GLuint);
+
+        switch (componentType) {
+            case GL_UNSIGNED_BYTE: indexSize = sizeof(GLubyte); break;
+            case GL_UNSIGNED_SHORT: indexSize = sizeof(GLushort); break;
+        }
+
+        return reinterpret_cast<const void *>(static_cast<std::uintptr_t>(first) * indexSize);
+    }
 };
 
 #endif //RENDERCALL_H
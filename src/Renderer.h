@@ -5,13 +5,24 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 #include "RenderQueue.h"
+#include "VertexBindings.h"
 #include "glad/glad.h"
+#include <algorithm>
 #include <vector>
+#include <glm/glm.hpp>
 
 class Renderer {
 public:
     Renderer() = default;
 
+    // Enables LOD selection: the coarsest LOD whose error projects to at most maxPixelError pixels gets drawn
+    // pixelsPerUnit is the screen size of one unit at distance 1, viewportHeight / (2 * tan(fovY / 2))
+    void setLodSelection(const glm::vec3 &cameraPos, float pixelsPerUnit, float maxPixelError) {
+        m_cameraPos = cameraPos;
+        m_pixelsPerUnit = pixelsPerUnit;
+        m_maxPixelError = maxPixelError;
+    }
+
     void addRenderQueue(RenderQueue *queue) {
         m_renderQueues.emplace_back(queue);
     }
@@ -34,17 +45,28 @@ public:
 
             const RenderEntity &renderEntity = renderData.renderEntity;
 
+            // Distance to the entity origin and its largest scale, errors are in object space
+            const glm::mat4 modelMatrix = renderEntity.getModelMatrix();
+            const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                                          glm::length(glm::vec3(modelMatrix[2]))});
+            const float distance = std::max(glm::length(glm::vec3(modelMatrix[3]) - m_cameraPos), 0.001f);
+            const float errorToPixels = scale * m_pixelsPerUnit / distance;
+
             bool setModelMatrix = true;
             for (auto &renderCall : renderEntity.getRenderCalls()) {
-                glBindVertexArray(renderCall.vao);
+                // Arena meshes share a VAO per vertex format, only buffers get swapped
+                VertexBindings::instance().bind(renderCall);
 
                 renderData.shader->preRender(renderEntity, renderCall, setModelMatrix);
                 setModelMatrix = false;
 
-                glDrawElements(GL_TRIANGLES, renderCall.elemCount, renderCall.componentType, nullptr);
-                glBindVertexArray(0);
+                const RenderCallLod lod = selectLod(renderCall, errorToPixels);
+                glDrawElementsBaseVertex(GL_TRIANGLES, lod.elemCount, renderCall.componentType,
+                                         renderCall.getIndexOffset(lod.firstIndex), renderCall.baseVertex);
             }
         }
+
+        VertexBindings::instance().unbind();
     }
 
     void renderAllQueues() {
@@ -64,6 +86,29 @@ public:
 
 private:
     std::vector<RenderQueue*> m_renderQueues;
+
+    // LODs are off until setLodSelection gets called
+    glm::vec3 m_cameraPos{0.0f};
+    float m_pixelsPerUnit{0.0f};
+    float m_maxPixelError{1.0f};
+
+    [[nodiscard]] RenderCallLod selectLod(const RenderCall &renderCall, float errorToPixels) const {
+        RenderCallLod selected{renderCall.firstIndex, renderCall.elemCount, 0.0f};
+
+        if (m_pixelsPerUnit <= 0.0f) {
+            return selected;
+        }
+
+        for (const RenderCallLod &lod : renderCall.lods) {
+            if (lod.error * errorToPixels > m_maxPixelError) {
+                break;
+            }
+
+            selected = lod;
+        }
+
+        return selected;
+    }
 };
 
 #endif //RENDERER_H
@@ -4,16 +4,44 @@
 
 #include "Shader.h"
 
+#include <algorithm>
+#include <optional>
+
+#include "AssetArchive.h"
+
 Shader::Shader(std::string_view path, GLenum shaderType) : m_shaderType(shaderType) {
-    std::ifstream shaderFile{path.begin()};
+    std::optional<std::string> shaderCode = AssetArchive::readText(path);
 
-    if (!shaderFile) {
+    if (!shaderCode) {
         std::cerr << "File not found" << std::endl;
     }
 
-    std::stringstream buffer;
-    buffer << shaderFile.rdbuf();
-    m_shaderCode = buffer.str();
+    m_shaderCode = shaderCode.value_or("");
+    insertCommonSource();
+}
+
+void Shader::insertCommonSource() {
+    static const std::optional<std::string> commonCode = AssetArchive::readText(COMMON_SOURCE_PATH);
+
+    if (!commonCode) {
+        std::cerr << "File not found: " << COMMON_SOURCE_PATH << std::endl;
+        return;
+    }
+
+    // #version has to stay the first statement, the common code goes right after it
+    const std::size_t versionStart = m_shaderCode.find("#version");
+    if (versionStart == std::string::npos) {
+        return;
+    }
+
+    const std::size_t versionEnd = m_shaderCode.find('\n', versionStart);
+    if (versionEnd == std::string::npos) {
+        return;
+    }
+
+    // #line keeps compile errors pointing at the lines of the shader file
+    const auto versionLine = std::count(m_shaderCode.begin(), m_shaderCode.begin() + versionEnd, '\n') + 1;
+    m_shaderCode.insert(versionEnd + 1, *commonCode + "\n#line " + std::to_string(versionLine + 1) + "\n");
 }
 
 bool Shader::compile() {
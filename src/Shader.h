@@ -18,7 +18,12 @@ private:
     const GLenum m_shaderType;
     GLuint m_shaderId{};
 
+    void insertCommonSource();
+
 public:
+    // Shared GLSL functions every shader can use
+    static constexpr const char *COMMON_SOURCE_PATH = "../src/Shaders/Common/common.glsl";
+
     Shader(std::string_view path, GLenum shaderType);
     bool compile();
     [[nodiscard]] GLuint getShaderId() const { return m_shaderId; }
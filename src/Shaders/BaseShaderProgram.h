@@ -136,6 +136,13 @@ public:
         glUniformMatrix4fv(glGetUniformLocation(m_programId, name), 1, GL_FALSE, glm::value_ptr(value));
     }
 
+    // Vertex shaders of quantized models reconstruct position and normal from these
+    void setVertexQuantization(const RenderCall &renderCall) const {
+        setVec3f("u_positionScale", renderCall.positionScale);
+        setVec3f("u_positionOffset", renderCall.positionOffset);
+        setBool("u_octEncoded", renderCall.octEncoded);
+    }
+
     // Supposed to be called before issuing render calls, used to bind textures etc
     virtual void preRender(const RenderEntity &renderEntity, const RenderCall &renderCall, bool setModelMatrix = true) = 0;
     virtual void preRender(const RenderCall &renderCall) = 0;
@@ -0,0 +1,9 @@
+// Prepended to every shader right after its #version line by Shader
+
+// Quantized models and terrain vertices store normals and tangents octahedron encoded
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
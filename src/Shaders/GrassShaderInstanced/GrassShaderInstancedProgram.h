@@ -22,10 +22,12 @@ public:
             setMat4f("u_model", renderEntity.getModelMatrix());
         }
 
+        setVertexQuantization(renderCall);
         handleTextures(renderCall);
     }
 
     void preRender(const RenderCall &renderCall) {
+        setVertexQuantization(renderCall);
         handleTextures(renderCall);
     }
 
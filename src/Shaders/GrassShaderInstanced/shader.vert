@@ -9,6 +9,9 @@ uniform mat4 u_view;
 uniform mat4 u_projection;
 uniform float u_time;
 uniform int u_baseInstance;
+uniform vec3 u_positionScale;
+uniform vec3 u_positionOffset;
+uniform bool u_octEncoded;
 
 struct InstanceData {
     vec3 pos;
@@ -25,18 +28,20 @@ out vec3 f_normal;
 out vec2 f_texCoord;
 
 void main() {
+    vec3 position = aPos * u_positionScale + u_positionOffset;
+    vec3 normal = u_octEncoded ? octDecode(aNormal.xy) : aNormal;
     InstanceData instance = instances[gl_InstanceID + u_baseInstance];
     float scalingFactor = instance.scaling;
-    vec3 worldPos = vec3(scalingFactor * aPos.x, 5 * aPos.y, scalingFactor * aPos.z) + instance.pos;
+    vec3 worldPos = vec3(scalingFactor * position.x, 5 * position.y, scalingFactor * position.z) + instance.pos;
 
     float windStrength = 0.5;
     float windFrequency = 1.5;
     float sway = sin(worldPos.x * 0.5 + worldPos.z * 0.5 + u_time * windFrequency + gl_InstanceID * 0.1);
-    float heightFactor = smoothstep(0.0, 1.0, aPos.y);
+    float heightFactor = smoothstep(0.0, 1.0, position.y);
     worldPos.x += sway * windStrength * heightFactor;
 
     f_worldPos = worldPos;
-    f_normal = aNormal;
+    f_normal = normal;
     f_texCoord = aTexCoord;
     vColor = vec3(aTexCoord, 0.0f);
 
@@ -8,6 +8,9 @@ uniform vec2 u_windowDimensions;
 uniform mat4 u_model;
 uniform mat4 u_view;
 uniform mat4 u_projection;
+uniform vec3 u_positionScale;
+uniform vec3 u_positionOffset;
+uniform bool u_octEncoded;
 
 out vec3 f_worldPos;
 out vec3 vColor;
@@ -15,9 +18,11 @@ out vec3 f_normal;
 out vec2 f_texCoord;
 
 void main() {
-    vec4 worldPos = u_model * vec4(aPos, 1.0f);
+    vec3 position = aPos * u_positionScale + u_positionOffset;
+    vec3 normal = u_octEncoded ? octDecode(aNormal.xy) : aNormal;
+    vec4 worldPos = u_model * vec4(position, 1.0f);
     f_worldPos = worldPos.xyz;
-    f_normal = (u_model * vec4(aNormal, 0.0f)).xyz;
+    f_normal = (u_model * vec4(normal, 0.0f)).xyz;
     f_texCoord = aTexCoord;
     vColor = vec3(aTexCoord, 0.0f);
 
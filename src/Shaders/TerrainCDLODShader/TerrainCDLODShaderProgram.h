@@ -0,0 +1,28 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINCDLODSHADERPROGRAM_H
+#define TERRAINCDLODSHADERPROGRAM_H
+#include "../BaseShaderProgram.h"
+
+
+// Shares the fragment stage with the chunked terrain, only the vertex source differs
+class TerrainCDLODShaderProgram : public BaseShaderProgram {
+public:
+    TerrainCDLODShaderProgram()
+    : BaseShaderProgram("../src/Shaders/TerrainCDLODShader/shader.vert", "../src/Shaders/TerrainShader/shader.frag") {
+        m_stateDescriptor.cullFaceEnabled = true;
+        m_stateDescriptor.cullFaceMode = GL_BACK;
+        m_stateDescriptor.depthTestEnabled = true;
+        m_stateDescriptor.depthMaskEnabled = true;
+    }
+
+    void preRender(const RenderEntity &renderEntity, const RenderCall &renderCall, bool setModelMatrix) override {}
+
+    void preRender(const RenderCall &renderCall) {}
+};
+
+
+
+#endif //TERRAINCDLODSHADERPROGRAM_H
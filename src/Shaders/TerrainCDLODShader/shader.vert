@@ -0,0 +1,120 @@
+#version 430
+// XZ in patch units, 0 to u_patchResolution
+layout (location = 0) in vec2 a_gridPos;
+
+uniform mat4 u_view;
+uniform mat4 u_projection;
+uniform vec3 u_cameraPos;
+
+// Node
+uniform vec2 u_nodeOrigin;
+uniform float u_nodeSize;
+uniform float u_patchResolution;
+uniform vec2 u_morphRange; // Start and end distance of the morph to the next coarser LOD
+
+// Terrain uniforms
+uniform float u_terrainHeight;
+uniform float u_minHeight; // Height range of the generated terrain
+uniform float u_maxHeight;
+uniform float u_scale;
+uniform float u_persistance;
+uniform float u_lucunarity;
+uniform int u_octaves;
+
+out float o_height;
+out vec2 f_texCoord;
+out vec3 f_worldPos;
+out vec3 f_normal;
+
+out float o_minHeight;
+out float o_maxHeight;
+
+vec3 mod289(vec3 x) {
+    return x - floor(x * (1.0 / 289.0)) * 289.0;
+}
+
+vec2 mod289(vec2 x) {
+    return x - floor(x * (1.0 / 289.0)) * 289.0;
+}
+
+vec3 permute(vec3 x) {
+    return mod289(((x * 34.0) + 1.0) * x);
+}
+
+float snoise(vec2 v) {
+    const vec4 C = vec4(0.211324865405187,  // (3.0-sqrt(3.0))/6.0
+                        0.366025403784439,  // 0.5*(sqrt(3.0)-1.0)
+                       -0.577350269189626,  // -1.0 + 2.0 * C.x
+                        0.024390243902439); // 1.0 / 41.0
+    vec2 i = floor(v + dot(v, C.yy));
+    vec2 x0 = v - i + dot(i, C.xx);
+
+    vec2 i1 = (x0.x > x0.y) ? vec2(1.0, 0.0) : vec2(0.0, 1.0);
+    vec4 x12 = x0.xyxy + C.xxzz;
+    x12.xy -= i1;
+
+    i = mod289(i);
+    vec3 p = permute(permute(i.y + vec3(0.0, i1.y, 1.0))
+                     + i.x + vec3(0.0, i1.x, 1.0));
+
+    vec3 m = max(0.5 - vec3(dot(x0, x0), dot(x12.xy, x12.xy), dot(x12.zw, x12.zw)), 0.0);
+    m = m * m;
+    m = m * m;
+
+    vec3 x = 2.0 * fract(p * C.www) - 1.0;
+    vec3 h = abs(x) - 0.5;
+    vec3 ox = floor(x + 0.5);
+    vec3 a0 = x - ox;
+
+    m *= 1.79284291400159 - 0.85373472095314 * (a0 * a0 + h * h);
+
+    vec3 g;
+    g.x = a0.x * x0.x + h.x * x0.y;
+    g.yz = a0.yz * x12.xz + h.yz * x12.yw;
+    return 130.0 * dot(m, g);
+}
+
+float computeHeight(vec2 worldPos) {
+    float noiseHeight = 0.0;
+    float amplitude = 1.0;
+    float frequency = 1.0;
+
+    for (int i = 0; i < u_octaves; i++) {
+        noiseHeight += amplitude * snoise(worldPos / (u_scale * frequency));
+
+        amplitude *= u_persistance;
+        frequency *= u_lucunarity;
+    }
+
+    return u_terrainHeight * (noiseHeight + 1.0) * 0.5;
+}
+
+void main() {
+    float spacing = u_nodeSize / u_patchResolution;
+    vec2 worldXZ = u_nodeOrigin + a_gridPos * spacing;
+
+    // Odd vertices slide onto their even neighbour, fully morphed the patch matches the coarser LOD
+    vec3 unmorphedPos = vec3(worldXZ.x, computeHeight(worldXZ), worldXZ.y);
+    float morph = clamp((distance(u_cameraPos, unmorphedPos) - u_morphRange.x) / (u_morphRange.y - u_morphRange.x), 0.0, 1.0);
+    vec2 morphedGridPos = a_gridPos - fract(a_gridPos * 0.5) * 2.0 * morph;
+    worldXZ = u_nodeOrigin + morphedGridPos * spacing;
+
+    float height = computeHeight(worldXZ);
+    float hL = computeHeight(worldXZ - vec2(1.0, 0.0));
+    float hR = computeHeight(worldXZ + vec2(1.0, 0.0));
+    float hD = computeHeight(worldXZ - vec2(0.0, 1.0));
+    float hU = computeHeight(worldXZ + vec2(0.0, 1.0));
+
+    vec3 dx = vec3(2.0, hR - hL, 0.0);
+    vec3 dz = vec3(0.0, hU - hD, 2.0);
+
+    f_texCoord = worldXZ;
+    f_worldPos = vec3(worldXZ.x, height, worldXZ.y);
+    f_normal = normalize(cross(dz, dx));
+
+    o_minHeight = u_minHeight;
+    o_maxHeight = u_maxHeight;
+    o_height = height;
+
+    gl_Position = u_projection * u_view * vec4(f_worldPos, 1.0);
+}
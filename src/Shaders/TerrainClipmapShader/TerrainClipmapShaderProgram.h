@@ -0,0 +1,28 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TERRAINCLIPMAPSHADERPROGRAM_H
+#define TERRAINCLIPMAPSHADERPROGRAM_H
+#include "../BaseShaderProgram.h"
+
+
+// Shares the fragment stage with the chunked terrain, only the vertex source differs
+class TerrainClipmapShaderProgram : public BaseShaderProgram {
+public:
+    TerrainClipmapShaderProgram()
+    : BaseShaderProgram("../src/Shaders/TerrainClipmapShader/shader.vert", "../src/Shaders/TerrainShader/shader.frag") {
+        m_stateDescriptor.cullFaceEnabled = true;
+        m_stateDescriptor.cullFaceMode = GL_BACK;
+        m_stateDescriptor.depthTestEnabled = true;
+        m_stateDescriptor.depthMaskEnabled = true;
+    }
+
+    void preRender(const RenderEntity &renderEntity, const RenderCall &renderCall, bool setModelMatrix) override {}
+
+    void preRender(const RenderCall &renderCall) {}
+};
+
+
+
+#endif //TERRAINCLIPMAPSHADERPROGRAM_H
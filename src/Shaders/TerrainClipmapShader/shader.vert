@@ -0,0 +1,55 @@
+#version 430
+// XZ in units of the level spacing, relative to the mesh origin
+layout (location = 0) in vec2 a_gridPos;
+
+uniform mat4 u_view;
+uniform mat4 u_projection;
+
+// Clipmap
+uniform sampler2DArray u_heightmap;
+uniform vec2 u_meshOrigin;
+uniform int u_spacing;
+uniform int u_level;
+uniform int u_textureSize;
+
+uniform float u_terrainHeight;
+uniform float u_minHeight; // Height range of the generated terrain
+uniform float u_maxHeight;
+
+out float o_height;
+out vec2 f_texCoord;
+out vec3 f_worldPos;
+out vec3 f_normal;
+
+out float o_minHeight;
+out float o_maxHeight;
+
+float fetchHeight(ivec2 texel) {
+    return texelFetch(u_heightmap, ivec3(texel & (u_textureSize - 1), u_level), 0).r;
+}
+
+void main() {
+    // Mesh origins lie on the level grid, every vertex maps to exactly one texel
+    ivec2 texel = ivec2(round(u_meshOrigin / float(u_spacing))) + ivec2(a_gridPos);
+    vec2 worldXZ = vec2(texel * u_spacing);
+
+    float height = fetchHeight(texel);
+    float hL = fetchHeight(texel - ivec2(1, 0));
+    float hR = fetchHeight(texel + ivec2(1, 0));
+    float hD = fetchHeight(texel - ivec2(0, 1));
+    float hU = fetchHeight(texel + ivec2(0, 1));
+
+    float spacing = float(u_spacing);
+    vec3 dx = vec3(2.0 * spacing, hR - hL, 0.0);
+    vec3 dz = vec3(0.0, hU - hD, 2.0 * spacing);
+
+    f_texCoord = worldXZ;
+    f_worldPos = vec3(worldXZ.x, height, worldXZ.y);
+    f_normal = normalize(cross(dz, dx));
+
+    o_minHeight = u_minHeight;
+    o_maxHeight = u_maxHeight;
+    o_height = height;
+
+    gl_Position = u_projection * u_view * vec4(f_worldPos, 1.0);
+}
@@ -19,18 +19,20 @@ uniform float u_ambientIntensity;
 uniform float u_specularIntensity;
 
 // Terrain
-const float waterLevel = 0.1;
+uniform float u_terrainHeight;
+
+const float waterLevel = 0.1; // Of the terrain height, the water surface covers everything below
 const float lowLevel = 0.35;
 const float highLevel = 1.0;
 const float blendRange = 0.3;
 
 void main() {
-    float normalizedHeight = (o_height - o_minHeight) / (o_maxHeight - o_minHeight);
-
-    if (normalizedHeight < waterLevel) {
+    if (o_height < waterLevel * u_terrainHeight) {
         discard;
     }
 
+    float normalizedHeight = (o_height - o_minHeight) / max(o_maxHeight - o_minHeight, 0.001);
+
     vec3 layerOneColor = texture(u_texLayerOne, f_texCoord / 32.0).xyz;
     vec3 layerTwoColor = texture(u_texLayerTwo, f_texCoord / 32.0).xyz;
 
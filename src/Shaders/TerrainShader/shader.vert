@@ -1,11 +1,17 @@
 #version 430
-struct VertexData {
-    vec3 pos;
-    vec3 normal;
+// Height and octahedron encoded normal, XZ come from the patch template
+struct TerrainVertex {
+    float height;
+    uint normal;
 };
 
-layout (std430, binding = 0) buffer VertexDataBuffer {
-    VertexData data[];
+layout (std430, binding = 0) readonly buffer TerrainVertexBuffer {
+    TerrainVertex data[];
+};
+
+// 16 bit x | 16 bit z in half units
+layout (std430, binding = 6) readonly buffer TerrainTemplateBuffer {
+    uint templatePositions[];
 };
 
 uniform mat4 u_model;
@@ -15,7 +21,10 @@ uniform vec3 u_camPos;
 
 // Terrain uniforms
 uniform vec2 u_chunkOffset;
+uniform int u_dataOffset; // Pool slot of the chunk relative to its template
 uniform float u_terrainHeight;
+uniform float u_minHeight; // Height range of the generated terrain
+uniform float u_maxHeight;
 uniform float u_scale;
 uniform float u_persistance;
 uniform float u_lucunarity;
@@ -29,15 +38,21 @@ out vec3 f_normal;
 out float o_minHeight;
 out float o_maxHeight;
 
+vec2 unpackTemplatePosition(uint packed) {
+    return vec2(packed & 0xFFFFu, packed >> 16) * 0.5;
+}
+
 void main() {
-    vec3 position = data[gl_VertexID].pos;
-    vec3 normal = data[gl_VertexID].normal;
+    vec2 templatePos = unpackTemplatePosition(templatePositions[gl_VertexID]);
+    int dataIndex = gl_VertexID + u_dataOffset;
+    vec3 position = vec3(templatePos.x, data[dataIndex].height, templatePos.y);
+    vec3 normal = octDecode(unpackSnorm2x16(data[dataIndex].normal));
 
     f_texCoord = position.xz;
     vec2 worldPosCam = position.xz;
 
-    o_minHeight = 0;
-    o_maxHeight = u_terrainHeight;
+    o_minHeight = u_minHeight;
+    o_maxHeight = u_maxHeight;
     o_height = position.y;
 
     vec4 worldPos = u_model * vec4(position, 1.0f);
@@ -10,6 +10,9 @@ uniform mat4 u_view;
 uniform mat4 u_projection;
 uniform int u_baseInstance;
 uniform float u_time;
+uniform vec3 u_positionScale;
+uniform vec3 u_positionOffset;
+uniform bool u_octEncoded;
 
 out vec3 f_worldPos;
 out vec3 f_normal;
@@ -25,17 +28,19 @@ layout(std430, binding = 1) buffer InstanceBuffer {
 };
 
 void main() {
+    vec3 position = aPos * u_positionScale + u_positionOffset;
+    vec3 normal = u_octEncoded ? octDecode(aNormal.xy) : aNormal;
     InstanceData instance = instances[gl_InstanceID + u_baseInstance];
     float scalingFactor = instance.scaling;
-    vec3 worldPos = scalingFactor * aPos + instance.pos;
+    vec3 worldPos = scalingFactor * position + instance.pos;
 
-    float currTreeHeight = scalingFactor * aPos.y - instance.pos.y;
+    float currTreeHeight = scalingFactor * position.y - instance.pos.y;
 
     // Tree model got a height about 10
-    if (aPos.y > 5.0) {
+    if (position.y > 5.0) {
         worldPos.x = worldPos.x + sin(worldPos.x * 0.5 + worldPos.z + u_time * 0.5 + gl_InstanceID);
     }
-    vec3 transformedNormal = normalize(aNormal / scalingFactor);
+    vec3 transformedNormal = normalize(normal / scalingFactor);
 
     f_worldPos = worldPos;
     f_normal = transformedNormal;
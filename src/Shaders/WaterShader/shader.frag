@@ -9,11 +9,12 @@ uniform vec3 u_camPos;
 uniform float u_ambientIntensity;
 uniform float u_specularIntensity;
 uniform vec3 u_lightDirection;
+uniform float u_waterCutoff;
 
 uniform samplerCube u_skybox;
 
 void main() {
-    if (f_normalizedTerrainHeight > 0.15) {
+    if (f_normalizedTerrainHeight > u_waterCutoff) {
         discard;
     }
 
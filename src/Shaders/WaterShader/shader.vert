@@ -1,26 +1,30 @@
 #version 430
-layout (location = 0) in vec2 aPos;
-
-struct VertexData {
-    vec3 pos;
-    vec3 normal;
+layout (location = 0) in vec2 aPos; // Tile local XZ
+
+struct WaterTile {
+    vec2 chunkOffset;
+    vec2 tileOffset;
+    int layer;
+    int lod;
+    float minHeight;
+    float padding;
+    ivec4 neighbourLods; // Left, right, top, bottom
 };
 
-layout (std430, binding = 0) buffer VertexDataBuffer {
-    VertexData data[];
+layout (std430, binding = 5) buffer WaterTileBuffer {
+    WaterTile tiles[];
 };
 
-uniform mat4 u_model;
 uniform mat4 u_view;
 uniform mat4 u_projection;
 uniform vec3 u_camPos;
 uniform float u_time;
+uniform int u_baseInstance;
 
 uniform float u_terrainHeight;
-uniform float u_scale;
-uniform float u_persistance;
-uniform float u_lucunarity;
-uniform int u_octaves;
+uniform int u_maskSpacing;
+uniform int u_tileSize;
+uniform sampler2DArray u_waterMask;
 
 out vec3 f_normal;
 out vec3 f_worldPos;
@@ -28,8 +32,10 @@ out float f_normalizedTerrainHeight;
 
 const float pi = 3.14159265358979323846;
 
-void main() {
-    vec2 worldPosCam = aPos + u_camPos.xz;
+// x: surface height, y: normalized terrain height, zw: wave slope
+vec4 computeSurface(WaterTile tile, vec2 tilePos) {
+    vec2 chunkLocalPos = tile.tileOffset + tilePos;
+    vec2 worldPosXZ = tile.chunkOffset + chunkLocalPos;
 
     float height = 0.0f;
     float dx = 0.0f;
@@ -41,7 +47,7 @@ void main() {
         float waveAmplitude = pow(0.6f, i);
         float phaseShift = u_time * 0.5f * float(i);
 
-        float f = waveFreq * (aPos.x + aPos.y) + phaseShift;
+        float f = waveFreq * (worldPosXZ.x + worldPosXZ.y) + phaseShift;
 
         height += waveAmplitude * (sin(f) + 0.5f);
 
@@ -50,18 +56,63 @@ void main() {
         dy += derivative;
     }
 
-    vec3 gradient = vec3(dx, dy, -1.0f);
-    f_normal = normalize(gradient);
-
-    // Use the known height to determine if the waves should be cut off
-    float normalizedHeight =  data[gl_VertexID].pos.y / u_terrainHeight;
-    f_normalizedTerrainHeight = normalizedHeight;
+    // Baked terrain height decides if the waves should be cut off
+    ivec2 texel = ivec2(round(chunkLocalPos)) / u_maskSpacing;
+    float normalizedHeight = texelFetch(u_waterMask, ivec3(texel, tile.layer), 0).r;
 
     float noiseInfluence = clamp((0.1 - normalizedHeight) / 0.1, 0.0, 1.0);
 
     height *= noiseInfluence;
 
-    vec4 worldPos = u_model * vec4(worldPosCam.x, abs(data[gl_VertexID].pos.y) + height, worldPosCam.y, 1.0f);
+    return vec4(normalizedHeight * u_terrainHeight + height, normalizedHeight, dx, dy);
+}
+
+void main() {
+    WaterTile tile = tiles[gl_InstanceID + u_baseInstance];
+    vec4 surface = computeSurface(tile, aPos);
+
+    // Find out if the vertex sits on an edge shared with a coarser tile
+    int neighbourLod = tile.lod;
+    float alongEdge = 0.0;
+    vec2 edgeDirection = vec2(0.0);
+
+    if (aPos.x <= 0.0) {
+        neighbourLod = tile.neighbourLods.x;
+        alongEdge = aPos.y;
+        edgeDirection = vec2(0.0, 1.0);
+    } else if (aPos.x >= u_tileSize) {
+        neighbourLod = tile.neighbourLods.y;
+        alongEdge = aPos.y;
+        edgeDirection = vec2(0.0, 1.0);
+    } else if (aPos.y <= 0.0) {
+        neighbourLod = tile.neighbourLods.z;
+        alongEdge = aPos.x;
+        edgeDirection = vec2(1.0, 0.0);
+    } else if (aPos.y >= u_tileSize) {
+        neighbourLod = tile.neighbourLods.w;
+        alongEdge = aPos.x;
+        edgeDirection = vec2(1.0, 0.0);
+    }
+
+    // Move the vertex onto the coarser edge, otherwise cracks show up between LODs
+    if (neighbourLod > tile.lod) {
+        float coarseSpacing = float(u_maskSpacing << neighbourLod);
+        float edgeStart = floor(alongEdge / coarseSpacing) * coarseSpacing;
+        float t = (alongEdge - edgeStart) / coarseSpacing;
+
+        if (t > 0.0) {
+            vec2 startPos = aPos + edgeDirection * (edgeStart - alongEdge);
+            vec2 endPos = startPos + edgeDirection * coarseSpacing;
+            surface = mix(computeSurface(tile, startPos), computeSurface(tile, endPos), t);
+        }
+    }
+
+    vec3 gradient = vec3(surface.z, surface.w, -1.0f);
+    f_normal = normalize(gradient);
+    f_normalizedTerrainHeight = surface.y;
+
+    vec2 worldPosXZ = tile.chunkOffset + tile.tileOffset + aPos;
+    vec4 worldPos = vec4(worldPosXZ.x, surface.x, worldPosXZ.y, 1.0f);
     f_worldPos = worldPos.xyz;
     gl_Position = u_projection * u_view * worldPos;
 }
@@ -0,0 +1,186 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "GltfLoader.h"
+#include "glad/glad.h"
+
+struct TextureCacheStats {
+    GLuint uniqueTextures;
+    GLuint requests;
+    GLuint hits;
+    std::size_t vramBytes;
+    std::size_t vramBytesSaved;
+    double uploadMs; // CPU time spent in the GL upload calls, GPU side copies are not included
+    double uploadMsSaved;
+};
+
+// Two independent hashes over the same bytes, a match of both plus the size is taken as equal content
+struct TextureContentHash {
+    std::uint64_t hash;
+    std::uint64_t checkHash;
+
+    bool operator==(const TextureContentHash &other) const {
+        return hash == other.hash && checkHash == other.checkHash;
+    }
+};
+
+struct TextureCacheKey {
+    TextureContentHash content; // TextureCache::hashImage of the base level
+    std::uint64_t byteSize; // Of the base level
+    int width;
+    int height;
+    int component;
+    int pixelType;
+
+    bool operator==(const TextureCacheKey &other) const {
+        return content == other.content && byteSize == other.byteSize && width == other.width &&
+               height == other.height && component == other.component && pixelType == other.pixelType;
+    }
+};
+
+struct TextureCacheKeyHash {
+    std::size_t operator()(const TextureCacheKey &key) const {
+        // Content hash is already well distributed
+        return static_cast<std::size_t>(key.content.hash ^ (static_cast<std::uint64_t>(key.width) << 32 | key.height));
+    }
+};
+
+// Deduplicates GL textures by image content, shared by every GPUModelUploader
+// Key is two 64 bit hashes of the pixels plus their size and layout, so the same image in two
+// materials or the same model loaded twice ends up in a single texture
+// Models live as long as the program, so do the textures
+class TextureCache {
+public:
+    static TextureCache &instance() {
+        static TextureCache cache;
+        return cache;
+    }
+
+    static TextureContentHash hashImage(const GltfImage &image) {
+        return hashBytes(image.buffer.data(), image.buffer.size());
+    }
+
+    // FNV-1a over 8 byte words plus a multiply-rotate hash as check, the tail gets hashed byte wise
+    static TextureContentHash hashBytes(const unsigned char *data, const std::size_t size) {
+        constexpr std::uint64_t PRIME = 0x100000001b3ull;
+        constexpr std::uint64_t CHECK_PRIME_1 = 0x87c37b91114253d5ull;
+        constexpr std::uint64_t CHECK_PRIME_2 = 0x4cf5ad432745937full;
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        std::uint64_t checkHash = size;
+
+        auto mixCheck = [&checkHash](std::uint64_t word) {
+            word *= CHECK_PRIME_1;
+            word = word << 31 | word >> 33;
+            checkHash = (checkHash ^ word * CHECK_PRIME_2) * 5 + 0x52dce729;
+        };
+
+        std::size_t i = 0;
+
+        for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * PRIME;
+            mixCheck(word);
+        }
+
+        for (; i < size; i++) {
+            hash = (hash ^ data[i]) * PRIME;
+            mixCheck(data[i]);
+        }
+
+        return {hash, checkHash};
+    }
+
+    // Returns a texture for the image, uploads it only if no equal image is cached
+    GLuint acquire(const GltfImage &image, const TextureContentHash &hash) {
+        const TextureCacheKey key{
+            hash, image.buffer.size(), image.width, image.height, image.component, image.pixelType
+        };
+
+        // Full mip chain adds a third
+        const std::size_t bytesPerPixel = static_cast<std::size_t>(image.component) * (image.bits / 8);
+        const std::size_t vramBytes = static_cast<std::size_t>(image.width) * image.height * bytesPerPixel * 4 / 3;
+
+        return acquire(key, vramBytes, [&image] { return upload(image); });
+    }
+
+    // For images that are not a GltfImage, upload() is only called on a cache miss and returns the texture
+    template<typename F>
+    GLuint acquire(const TextureCacheKey &key, std::size_t vramBytes, F &&upload) {
+        m_stats.requests++;
+
+        auto it = m_entries.find(key);
+
+        if (it != m_entries.end()) {
+            const Entry &entry = it->second;
+
+            m_stats.hits++;
+            m_stats.vramBytesSaved += entry.vramBytes;
+            m_stats.uploadMsSaved += entry.uploadMs;
+
+            return entry.handle;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const GLuint handle = upload();
+        const std::chrono::duration<double, std::milli> uploadTime = std::chrono::steady_clock::now() - start;
+
+        m_entries.emplace(key, Entry{handle, vramBytes, uploadTime.count()});
+
+        m_stats.uniqueTextures++;
+        m_stats.vramBytes += vramBytes;
+        m_stats.uploadMs += uploadTime.count();
+
+        return handle;
+    }
+
+    // Used as internal format and pixel format for model textures
+    static int getFormat(int component) {
+        switch (component) {
+            case 1: return GL_R8;
+            case 3: return GL_RGB;
+            case 4: return GL_RGBA;
+            default: throw std::runtime_error("Invalid internal pixel format in texture");
+        }
+    }
+
+    [[nodiscard]] const TextureCacheStats &getStats() const {
+        return m_stats;
+    }
+
+private:
+    struct Entry {
+        GLuint handle;
+        std::size_t vramBytes;
+        double uploadMs;
+    };
+
+    std::unordered_map<TextureCacheKey, Entry, TextureCacheKeyHash> m_entries;
+    TextureCacheStats m_stats{};
+
+    TextureCache() = default;
+
+    static GLuint upload(const GltfImage &img) {
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+
+        const int format = getFormat(img.component);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, format, img.width, img.height, 0, format, img.pixelType, img.buffer.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        return tex;
+    }
+};
+
+
+#endif //TEXTURECACHE_H
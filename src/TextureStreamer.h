@@ -0,0 +1,157 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include "OpenglUtils.h"
+#include "ImageData.h"
+#include "TextureHandle.h"
+
+// Streams 2D textures from disk without stalling the render thread
+//  - Decoding runs on the shared decode pool
+//  - The GL texture exists right away with a 1x1 white placeholder, its handle never changes
+//  - Callers share the TextureHandle with the streamer, size and format get updated once the image is uploaded
+//  - Decoded images get staged through a ring of pixel unpack buffers in processUploads()
+class TextureStreamer {
+public:
+    static constexpr int PBO_COUNT = 3;
+    // Always at least one image per frame, even if it's larger than the budget
+    static constexpr std::size_t UPLOAD_BUDGET_BYTES = 16 * 1024 * 1024;
+
+    static TextureStreamer &instance() {
+        static TextureStreamer streamer;
+        return streamer;
+    }
+
+    std::shared_ptr<TextureHandle> requestTexture(const std::string &path, bool repeatTexture = false) {
+        auto texture = std::make_shared<TextureHandle>(opengl_utils::createTexture(1, 1, 4, repeatTexture));
+
+        const GLubyte placeholder[4] = {255, 255, 255, 255};
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_pending.push_back({texture, path, opengl_utils::loadImageAsync(path)});
+
+        return texture;
+    }
+
+    // Call once per frame on the render thread
+    void processUploads() {
+        if (m_pending.empty()) {
+            return;
+        }
+
+        std::size_t uploadedBytes = 0;
+
+        for (auto it = m_pending.begin(); it != m_pending.end() && uploadedBytes < UPLOAD_BUDGET_BYTES;) {
+            if (it->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+
+            uploadedBytes += upload(*it);
+            it = m_pending.erase(it);
+        }
+    }
+
+    // Blocks until every requested texture is uploaded, used where a loading screen is acceptable
+    void waitAll() {
+        for (PendingTexture &pendingTexture: m_pending) {
+            pendingTexture.image.wait();
+            upload(pendingTexture);
+        }
+
+        m_pending.clear();
+    }
+
+    [[nodiscard]] std::size_t getPendingCount() const {
+        return m_pending.size();
+    }
+
+private:
+    struct PendingTexture {
+        std::shared_ptr<TextureHandle> texture;
+        std::string path;
+        std::future<ImageData> image;
+    };
+
+    std::vector<PendingTexture> m_pending;
+    std::array<GLuint, PBO_COUNT> m_pbos{};
+    int m_nextPbo{0};
+
+    TextureStreamer() = default;
+
+    // Returns the amount of bytes staged
+    std::size_t upload(PendingTexture &pendingTexture) {
+        ImageData image;
+
+        try {
+            image = pendingTexture.image.get();
+        } catch (const std::exception &e) {
+            // Keep the placeholder
+            std::cerr << e.what() << std::endl;
+            return 0;
+        }
+
+        if (m_pbos[0] == 0) {
+            glGenBuffers(PBO_COUNT, m_pbos.data());
+        }
+
+        const std::size_t imageSize = static_cast<std::size_t>(image.width) * image.height * image.nChannels;
+
+        // Orphan the previous storage, the driver can still be reading from it
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbos[m_nextPbo]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, imageSize, nullptr, GL_STREAM_DRAW);
+
+        // Offset into the bound unpack buffer, or client memory if the buffer can't be used
+        const void *pixels = nullptr;
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageSize,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if (mapped) {
+            std::memcpy(mapped, image.buffer, imageSize);
+        }
+
+        // Unmapping fails if the storage got lost while mapped, the contents are undefined then
+        if (!mapped || glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            pixels = image.buffer;
+        }
+
+        TextureHandle &texture = *pendingTexture.texture;
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.format = opengl_utils::getPixelFormat(image.nChannels);
+
+        // Rows of RGB images are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, texture.handle);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, texture.format,
+                     GL_UNSIGNED_BYTE, pixels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        m_nextPbo = (m_nextPbo + 1) % PBO_COUNT;
+        opengl_utils::freeImage(image);
+
+        return imageSize;
+    }
+};
+
+
+#endif //TEXTURESTREAMER_H
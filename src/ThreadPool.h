@@ -0,0 +1,103 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// Fixed amount of worker threads, tasks are processed in submission order
+// Never touches OpenGL, results have to be uploaded on the render thread
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threadCount) {
+        for (std::size_t i = 0; i < threadCount; i++) {
+            m_workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+
+        m_condition.notify_all();
+
+        for (std::thread &worker: m_workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template<typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F> > > {
+        using Result = std::invoke_result_t<std::decay_t<F> >;
+
+        // std::function requires copyable callables, packaged_task is move only
+        auto packagedTask = std::make_shared<std::packaged_task<Result()> >(std::forward<F>(task));
+        std::future<Result> future = packagedTask->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([packagedTask] { (*packagedTask)(); });
+        }
+
+        m_condition.notify_one();
+        return future;
+    }
+
+    [[nodiscard]] std::size_t getThreadCount() const {
+        return m_workers.size();
+    }
+
+    // Shared pool for file decoding (images, models), leaves one core for the render thread
+    static ThreadPool &decodePool() {
+        // hardware_concurrency may report 0 if unknown
+        const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        static ThreadPool pool{hardwareThreads > 1 ? hardwareThreads - 1 : 1};
+        return pool;
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()> > m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopped{false};
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_stopped || !m_tasks.empty(); });
+
+                if (m_stopped && m_tasks.empty()) {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+
+            task();
+        }
+    }
+};
+
+
+#endif //THREADPOOL_H
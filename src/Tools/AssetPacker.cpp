@@ -0,0 +1,27 @@
+//
+// Created by slice on 10/19/26.
+//
+
+// Packs assets and shader sources into a single archive, run from the build directory like the app
+// Usage: realtime_cg_pack [output], defaults to ../assets.pack
+
+#include <iostream>
+#include <string>
+
+#include "../AssetArchive.h"
+
+int main(int argc, char **argv) {
+    const std::string outPath = argc > 1 ? argv[1] : AssetArchive::DEFAULT_PATH;
+
+    // Mesh caches are generated per machine and stay on disk
+    const bool success = AssetArchive::build({"../assets", "../src/Shaders"}, {"../assets/cache"}, outPath);
+
+    if (!success) {
+        return -1;
+    }
+
+    AssetArchive archive{outPath};
+    std::cout << "Packed assets into " << outPath << std::endl;
+
+    return archive.isValid() ? 0 : -1;
+}
@@ -0,0 +1,38 @@
+//
+// Created by slice on 10/19/26.
+//
+
+// Bakes the default terrain noise into a tiled heightmap, run from the build directory like the app
+// Usage: realtime_cg_bake [world size] [output], defaults to 16384 and ../assets/cache/world.heights
+// The result can be edited like any other heightmap as long as the tile layout stays the same
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "../Final/BakedHeightmap.h"
+
+int main(int argc, char **argv) {
+    const int worldSize = argc > 1 ? std::stoi(argv[1]) : 16384;
+    const std::string outPath = argc > 2 ? argv[2] : BakedHeightmap::DEFAULT_PATH;
+    constexpr int tileSize = 256;
+
+    // Same defaults as the terrain window, the height is applied at runtime
+    const TerrainNoiseParams params = {1.0f, 4, 300.0f, 0.244f, 10.0f};
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(outPath).parent_path(), error);
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!BakedHeightmap::bake(params, worldSize, tileSize, outPath)) {
+        return -1;
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BakedHeightmap heightmap{outPath};
+    std::cout << "Baked " << worldSize << "x" << worldSize << " heightmap into " << outPath << " in " << seconds
+            << "s" << std::endl;
+
+    return heightmap.isValid() ? 0 : -1;
+}
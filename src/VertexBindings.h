@@ -0,0 +1,84 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef VERTEXBINDINGS_H
+#define VERTEXBINDINGS_H
+#include "GeometryArena.h"
+#include "RenderCall.h"
+#include "glad/glad.h"
+
+struct VertexBindingStats {
+    GLuint draws;
+    GLuint vaoBinds;
+    GLuint vertexBufferBinds;
+    GLuint indexBufferBinds;
+};
+
+// Binds the vertex input of RenderCalls and skips redundant binds
+// Arena meshes of one format share a VAO, switching between them only rebinds buffers
+// Every pass using it has to end with unbind(), other code binds VAOs directly
+class VertexBindings {
+public:
+    static VertexBindings &instance() {
+        static VertexBindings bindings;
+        return bindings;
+    }
+
+    void bind(const RenderCall &renderCall) {
+        m_frame.draws++;
+
+        if (renderCall.vao != m_vao) {
+            glBindVertexArray(renderCall.vao);
+            m_vao = renderCall.vao;
+
+            // Buffers attached to the VAO are unknown
+            m_vertexBuffer = 0;
+            m_indexBuffer = 0;
+            m_frame.vaoBinds++;
+        }
+
+        if (renderCall.vertexBuffer && renderCall.vertexBuffer != m_vertexBuffer) {
+            glBindVertexBuffer(GeometryArena::VERTEX_BINDING, renderCall.vertexBuffer, 0,
+                               static_cast<GLsizei>(renderCall.vertexStride));
+            m_vertexBuffer = renderCall.vertexBuffer;
+            m_frame.vertexBufferBinds++;
+        }
+
+        if (renderCall.indexBuffer && renderCall.indexBuffer != m_indexBuffer) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderCall.indexBuffer);
+            m_indexBuffer = renderCall.indexBuffer;
+            m_frame.indexBufferBinds++;
+        }
+    }
+
+    void unbind() {
+        glBindVertexArray(0);
+        m_vao = 0;
+        m_vertexBuffer = 0;
+        m_indexBuffer = 0;
+    }
+
+    // Called once per frame, stats of the finished frame stay readable
+    void endFrame() {
+        m_lastFrame = m_frame;
+        m_frame = {};
+    }
+
+    [[nodiscard]] const VertexBindingStats &getLastFrameStats() const {
+        return m_lastFrame;
+    }
+
+private:
+    GLuint m_vao{0};
+    GLuint m_vertexBuffer{0};
+    GLuint m_indexBuffer{0};
+
+    VertexBindingStats m_frame{};
+    VertexBindingStats m_lastFrame{};
+
+    VertexBindings() = default;
+};
+
+
+#endif //VERTEXBINDINGS_H
@@ -0,0 +1,495 @@
+//
+// Created by slice on 10/19/26.
+//
+
+#ifndef VERTEXINTERLEAVER_H
+#define VERTEXINTERLEAVER_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "GltfLoader.h"
+#include "glad/glad.h"
+
+// Plain 32 bit fields, also stored as is in the mesh cache
+struct VertexAttribLayout {
+    std::uint32_t location;
+    std::uint32_t components;
+    std::uint32_t componentType;
+    std::uint32_t offset;
+    std::uint32_t normalized; // GL_TRUE maps integer components to [0, 1] / [-1, 1]
+};
+
+// How the shaders reconstruct quantized vertices, identity for float vertices
+struct VertexQuantization {
+    float positionScale[3]; // position = attribute * scale + offset
+    float positionOffset[3];
+    std::uint32_t octEncoded; // Normal and tangent are octahedron encoded in .xy
+    std::uint32_t padding;
+};
+
+struct InterleavedVertexData {
+    std::vector<std::byte> buffer;
+    std::vector<VertexAttribLayout> attributes;
+    std::uint32_t stride;
+    std::uint32_t vertexCount;
+    VertexQuantization quantization{{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, 0, 0};
+};
+
+// One attribute stream copied by VertexInterleaver::interleave
+struct InterleaveSource {
+    const std::byte *data;
+    std::size_t stride; // Distance between two source elements
+    std::uint32_t size; // Element size in bytes
+    std::uint32_t offset; // Offset inside the destination vertex
+};
+
+struct PackedIndexData {
+    std::vector<std::byte> buffer;
+    int componentType;
+    std::uint32_t count;
+};
+
+// Builds the interleaved vertex buffer used for glTF models
+// Attribute locations match the model shaders: position 0, normal 1, tangent 2, texcoord 3
+// Missing tangents are left out of the layout, location 2 then reads the disabled attribute's zero default in both formats
+// Quantized glTF inputs (KHR_mesh_quantization) are kept as is, quantizing on import packs a vertex into 20 bytes (16 without tangents):
+//  position 3x snorm16 + dequantization, normal / tangent 2x snorm16 octahedron, texcoord 2x half
+//  The spare fourth position component holds the tangent handedness as +-1 (+1 without tangents)
+class VertexInterleaver {
+public:
+    static InterleavedVertexData interleaveGltfPrimitive(const GltfPrimitive &primitive, bool quantize = false) {
+        if (quantize) {
+            return quantizeGltfPrimitive(primitive);
+        }
+
+        // We always expect the given attributes to be in the primitive
+        const std::vector<GltfAttribute> attribOrder = {
+            GltfAttribute::POSITION,
+            GltfAttribute::NORMAL,
+            GltfAttribute::TANGENT,
+            GltfAttribute::TEXCOORD_0
+        };
+
+        InterleavedVertexData data{};
+        data.vertexCount = static_cast<std::uint32_t>(primitive.get(GltfAttribute::POSITION).elemCount);
+
+        std::vector<const GltfVertexAttrib *> sources;
+
+        for (std::size_t i = 0; i < attribOrder.size(); i++) {
+            const GltfAttribute attrib = attribOrder[i];
+            const GltfVertexAttrib *source;
+
+            if (primitive.attributes.find(attrib) != primitive.attributes.end()) {
+                source = &primitive.attributes.at(attrib);
+            } else if (attrib == GltfAttribute::TANGENT) {
+                // Tangents can be missing
+                continue;
+            } else {
+                throw std::runtime_error("Missing vertex attribute in model");
+            }
+
+            const std::size_t componentSize = getComponentSize(source->componentType);
+
+            data.attributes.push_back({
+                static_cast<std::uint32_t>(i),
+                static_cast<std::uint32_t>(source->getElementSize() / componentSize),
+                static_cast<std::uint32_t>(source->componentType),
+                data.stride,
+                source->normalized ? GL_TRUE : GL_FALSE
+            });
+
+            // Attributes stay 4 byte aligned, quantized inputs can be 2 or 6 bytes
+            data.stride += static_cast<std::uint32_t>(alignTo4(source->getElementSize()));
+            sources.push_back(source);
+        }
+
+        // Zero initialized, padding bytes stay zero
+        data.buffer.resize(static_cast<std::size_t>(data.stride) * data.vertexCount);
+
+        // Sources can be interleaved themselves
+        std::vector<InterleaveSource> streams;
+        for (std::size_t j = 0; j < sources.size(); j++) {
+            streams.push_back({
+                sources[j]->getElement(0), sources[j]->byteStride,
+                static_cast<std::uint32_t>(sources[j]->getElementSize()), data.attributes[j].offset
+            });
+        }
+
+        interleave(streams.data(), streams.size(), data.vertexCount, data.stride, data.buffer.data());
+        return data;
+    }
+
+    // Copies every source into its slot of the destination vertices, bytes between slots are left untouched
+    // Works in blocks of vertices so the destination stays in cache while all sources get copied,
+    // element sizes of the usual float/short/half attributes use fixed size copies
+    static void interleave(const InterleaveSource *sources, std::size_t sourceCount, std::size_t vertexCount,
+                           std::uint32_t stride, std::byte *destination) {
+        std::vector<CopyKernel> kernels(sourceCount);
+        for (std::size_t j = 0; j < sourceCount; j++) {
+            kernels[j] = getCopyKernel(sources[j].size);
+        }
+
+        for (std::size_t first = 0; first < vertexCount; first += INTERLEAVE_BLOCK) {
+            const std::size_t count = std::min(INTERLEAVE_BLOCK, vertexCount - first);
+
+            for (std::size_t j = 0; j < sourceCount; j++) {
+                const InterleaveSource &source = sources[j];
+                kernels[j](destination + first * stride + source.offset, stride,
+                           source.data + first * source.stride, source.stride, count, source.size);
+            }
+        }
+    }
+
+    // Reused heap buffer for data that only lives until it's uploaded, grows but never shrinks
+    // Contents are undefined, valid until the next call on the same thread
+    static std::byte *getScratchBuffer(std::size_t size) {
+        thread_local std::vector<std::byte> scratch;
+
+        if (scratch.size() < size) {
+            scratch.resize(size);
+        }
+
+        return scratch.data();
+    }
+
+    static std::vector<std::uint32_t> readIndices(const GltfPrimitive &primitive) {
+        std::vector<std::uint32_t> indices(primitive.elemCount);
+        const auto *source = static_cast<const std::byte *>(primitive.indexBuffer);
+
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            switch (primitive.componentType) {
+                case GL_UNSIGNED_BYTE: indices[i] = load<std::uint8_t>(source + i); break;
+                case GL_UNSIGNED_SHORT: indices[i] = load<std::uint16_t>(source + i * sizeof(std::uint16_t)); break;
+                default: indices[i] = load<std::uint32_t>(source + i * sizeof(std::uint32_t)); break;
+            }
+        }
+
+        return indices;
+    }
+
+    // Stores the indices as componentType, narrow turns 8 and 32 bit indices into 16 bit if the vertex count allows it
+    static PackedIndexData packIndices(const std::vector<std::uint32_t> &indices, std::uint32_t vertexCount,
+                                       int componentType, bool narrow) {
+        if (narrow && (componentType == GL_UNSIGNED_BYTE || (componentType == GL_UNSIGNED_INT && vertexCount <= 0x10000))) {
+            componentType = GL_UNSIGNED_SHORT;
+        }
+
+        PackedIndexData data{{}, componentType, static_cast<std::uint32_t>(indices.size())};
+        data.buffer.resize(indices.size() * getComponentSize(componentType));
+
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            switch (componentType) {
+                case GL_UNSIGNED_BYTE: store(data.buffer.data() + i, static_cast<std::uint8_t>(indices[i])); break;
+                case GL_UNSIGNED_SHORT: store(data.buffer.data() + i * sizeof(std::uint16_t), static_cast<std::uint16_t>(indices[i])); break;
+                default: store(data.buffer.data() + i * sizeof(std::uint32_t), indices[i]); break;
+            }
+        }
+
+        return data;
+    }
+
+    // Expects the target VAO and the vertex buffer to be bound
+    static void setupAttribPointers(const VertexAttribLayout *attributes, std::size_t attributeCount, GLsizei stride) {
+        for (std::size_t i = 0; i < attributeCount; i++) {
+            const VertexAttribLayout &attribute = attributes[i];
+
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribPointer(
+                attribute.location,
+                static_cast<GLint>(attribute.components),
+                attribute.componentType,
+                static_cast<GLboolean>(attribute.normalized),
+                stride,
+                reinterpret_cast<void *>(static_cast<std::uintptr_t>(attribute.offset))
+            );
+        }
+    }
+
+    // Separate format variant, the buffer gets attached later with glBindVertexBuffer(bindingIndex, ...)
+    // Expects the target VAO to be bound
+    static void setupAttribFormat(const VertexAttribLayout *attributes, std::size_t attributeCount, GLuint bindingIndex) {
+        for (std::size_t i = 0; i < attributeCount; i++) {
+            const VertexAttribLayout &attribute = attributes[i];
+
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribFormat(attribute.location, static_cast<GLint>(attribute.components),
+                                 attribute.componentType, static_cast<GLboolean>(attribute.normalized),
+                                 attribute.offset);
+            glVertexAttribBinding(attribute.location, bindingIndex);
+        }
+    }
+
+    static std::size_t getComponentSize(int componentType) {
+        switch (componentType) {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE: return 1;
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+            case GL_HALF_FLOAT: return 2;
+            case GL_FLOAT: return sizeof(float);
+            case GL_UNSIGNED_INT: return sizeof(unsigned int);
+            case GL_INT: return sizeof(int);
+            default: throw std::runtime_error("Unsupported component type");
+        }
+    }
+
+    // Reads up to 4 components of any glTF component type as floats, returns the component count
+    static std::size_t readElement(const GltfVertexAttrib &attrib, std::size_t idx, float (&out)[4]) {
+        const std::size_t componentSize = getComponentSize(attrib.componentType);
+        const std::size_t components = std::min<std::size_t>(attrib.getElementSize() / componentSize, 4);
+        const std::byte *element = attrib.getElement(idx);
+
+        for (std::size_t c = 0; c < components; c++) {
+            out[c] = readComponent(element + c * componentSize, attrib.componentType, attrib.normalized);
+        }
+
+        return components;
+    }
+
+    static std::uint16_t floatToHalf(float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const std::uint32_t sign = (bits >> 16) & 0x8000;
+        const std::int32_t exponent = static_cast<std::int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        std::uint32_t mantissa = bits & 0x7FFFFF;
+
+        // Inf and NaN
+        if (((bits >> 23) & 0xFF) == 0xFF) {
+            return static_cast<std::uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+        }
+
+        if (exponent >= 31) {
+            return static_cast<std::uint16_t>(sign | 0x7C00);
+        }
+
+        // Subnormal or zero
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return static_cast<std::uint16_t>(sign);
+            }
+
+            mantissa |= 0x800000;
+            const std::uint32_t shift = 14 - exponent;
+            std::uint32_t half = mantissa >> shift;
+
+            if ((mantissa >> (shift - 1)) & 1) {
+                half++;
+            }
+
+            return static_cast<std::uint16_t>(sign | half);
+        }
+
+        // Rounding can carry into the exponent, which is still correct
+        std::uint32_t half = sign | (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13);
+
+        if (mantissa & 0x1000) {
+            half++;
+        }
+
+        return static_cast<std::uint16_t>(half);
+    }
+
+    // Octahedron mapping of a unit vector to [-1, 1]^2, zero vectors map to (0, 0)
+    static void octEncode(const float (&v)[3], std::int16_t (&out)[2]) {
+        const float length = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+
+        if (length == 0.0f) {
+            out[0] = out[1] = 0;
+            return;
+        }
+
+        float x = v[0] / length;
+        float y = v[1] / length;
+
+        if (v[2] < 0.0f) {
+            const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+
+        out[0] = toSnorm16(x);
+        out[1] = toSnorm16(y);
+    }
+
+private:
+    using CopyKernel = void (*)(std::byte *, std::size_t, const std::byte *, std::size_t, std::size_t, std::uint32_t);
+
+    static constexpr std::size_t INTERLEAVE_BLOCK = 1024;
+
+    // Constant sizes turn the copy into one or two (vector) moves instead of a memcpy call
+    template<std::uint32_t SIZE>
+    static void copyElements(std::byte *dst, std::size_t dstStride, const std::byte *src, std::size_t srcStride,
+                             std::size_t count, std::uint32_t) {
+        for (std::size_t i = 0; i < count; i++) {
+            std::memcpy(dst, src, SIZE);
+            dst += dstStride;
+            src += srcStride;
+        }
+    }
+
+    static void copyElements(std::byte *dst, std::size_t dstStride, const std::byte *src, std::size_t srcStride,
+                             std::size_t count, std::uint32_t size) {
+        for (std::size_t i = 0; i < count; i++) {
+            std::memcpy(dst, src, size);
+            dst += dstStride;
+            src += srcStride;
+        }
+    }
+
+    static CopyKernel getCopyKernel(std::uint32_t size) {
+        switch (size) {
+            case 2: return copyElements<2>;
+            case 4: return copyElements<4>;
+            case 6: return copyElements<6>;
+            case 8: return copyElements<8>;
+            case 12: return copyElements<12>;
+            case 16: return copyElements<16>;
+            default: return static_cast<CopyKernel>(copyElements);
+        }
+    }
+
+    static constexpr std::uint32_t QUANTIZED_STRIDE = 20;
+    static constexpr std::uint32_t QUANTIZED_TANGENT_SIZE = 4;
+
+    static std::size_t alignTo4(std::size_t size) {
+        return (size + 3) & ~static_cast<std::size_t>(3);
+    }
+
+    static std::int16_t toSnorm16(float value) {
+        return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    template<typename T>
+    static T load(const std::byte *data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    static void store(std::byte *data, T value) {
+        std::memcpy(data, &value, sizeof(T));
+    }
+
+    // Normalized conversion follows the glTF spec, signed types clamp at -1
+    static float readComponent(const std::byte *data, int componentType, bool normalized) {
+        switch (componentType) {
+            case GL_FLOAT: return load<float>(data);
+            case GL_UNSIGNED_BYTE: {
+                const float value = load<std::uint8_t>(data);
+                return normalized ? value / 255.0f : value;
+            }
+            case GL_BYTE: {
+                const float value = load<std::int8_t>(data);
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+            case GL_UNSIGNED_SHORT: {
+                const float value = load<std::uint16_t>(data);
+                return normalized ? value / 65535.0f : value;
+            }
+            case GL_SHORT: {
+                const float value = load<std::int16_t>(data);
+                return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            }
+            case GL_UNSIGNED_INT: return static_cast<float>(load<std::uint32_t>(data));
+            case GL_INT: return static_cast<float>(load<std::int32_t>(data));
+            default: throw std::runtime_error("Unsupported component type");
+        }
+    }
+
+    static InterleavedVertexData quantizeGltfPrimitive(const GltfPrimitive &primitive) {
+        const GltfVertexAttrib &positions = primitive.get(GltfAttribute::POSITION);
+        const GltfVertexAttrib &normals = primitive.get(GltfAttribute::NORMAL);
+        const GltfVertexAttrib &texCoords = primitive.get(GltfAttribute::TEXCOORD_0);
+        const auto tangentIt = primitive.attributes.find(GltfAttribute::TANGENT);
+        const GltfVertexAttrib *tangents = tangentIt != primitive.attributes.end() ? &tangentIt->second : nullptr;
+
+        // Without tangents the texcoords move up into their slot
+        const std::uint32_t texCoordOffset = tangents ? 16 : 12;
+
+        InterleavedVertexData data{};
+        data.vertexCount = static_cast<std::uint32_t>(positions.elemCount);
+        data.stride = tangents ? QUANTIZED_STRIDE : QUANTIZED_STRIDE - QUANTIZED_TANGENT_SIZE;
+        data.attributes = {
+            {0, 4, GL_SHORT, 0, GL_TRUE},
+            {1, 2, GL_SHORT, 8, GL_TRUE}
+        };
+
+        if (tangents) {
+            data.attributes.push_back({2, 2, GL_SHORT, 12, GL_TRUE});
+        }
+
+        data.attributes.push_back({3, 2, GL_HALF_FLOAT, texCoordOffset, GL_FALSE});
+        data.quantization.octEncoded = 1;
+
+        // Positions get mapped from their bounds to [-1, 1]
+        float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        float max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+        for (std::size_t i = 0; i < data.vertexCount; i++) {
+            float position[4] = {};
+            readElement(positions, i, position);
+
+            for (int c = 0; c < 3; c++) {
+                min[c] = std::min(min[c], position[c]);
+                max[c] = std::max(max[c], position[c]);
+            }
+        }
+
+        for (int c = 0; c < 3; c++) {
+            const float extent = data.vertexCount > 0 ? (max[c] - min[c]) * 0.5f : 0.0f;
+            data.quantization.positionScale[c] = extent > 0.0f ? extent : 1.0f;
+            data.quantization.positionOffset[c] = data.vertexCount > 0 ? (max[c] + min[c]) * 0.5f : 0.0f;
+        }
+
+        data.buffer.resize(static_cast<std::size_t>(data.stride) * data.vertexCount);
+
+        for (std::size_t i = 0; i < data.vertexCount; i++) {
+            std::byte *vertex = data.buffer.data() + i * data.stride;
+
+            float position[4] = {};
+            readElement(positions, i, position);
+
+            std::int16_t quantizedPosition[4] = {};
+            for (int c = 0; c < 3; c++) {
+                quantizedPosition[c] = toSnorm16(
+                    (position[c] - data.quantization.positionOffset[c]) / data.quantization.positionScale[c]);
+            }
+
+            float normal[4] = {};
+            readElement(normals, i, normal);
+            std::int16_t encodedNormal[2];
+            octEncode({normal[0], normal[1], normal[2]}, encodedNormal);
+            std::memcpy(vertex + 8, encodedNormal, sizeof(encodedNormal));
+
+            // The octahedron only holds the direction, the handedness in .w moves into the position's spare .w
+            quantizedPosition[3] = toSnorm16(1.0f);
+            if (tangents) {
+                float tangent[4] = {};
+                readElement(*tangents, i, tangent);
+                std::int16_t encodedTangent[2];
+                octEncode({tangent[0], tangent[1], tangent[2]}, encodedTangent);
+                std::memcpy(vertex + 12, encodedTangent, sizeof(encodedTangent));
+                quantizedPosition[3] = toSnorm16(tangent[3] < 0.0f ? -1.0f : 1.0f);
+            }
+            std::memcpy(vertex, quantizedPosition, sizeof(quantizedPosition));
+
+            float texCoord[4] = {};
+            readElement(texCoords, i, texCoord);
+            const std::uint16_t halfTexCoord[2] = {floatToHalf(texCoord[0]), floatToHalf(texCoord[1])};
+            std::memcpy(vertex + texCoordOffset, halfTexCoord, sizeof(halfTexCoord));
+        }
+
+        return data;
+    }
+};
+
+
+#endif //VERTEXINTERLEAVER_H